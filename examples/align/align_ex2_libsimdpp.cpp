@@ -5,6 +5,9 @@
 #include <string>
 #include <vector>
 #include <fstream> // std::ifstream
+#include <iomanip> // std::setw
+#include <iostream> // std::cout
+#include <thread> // std::thread::hardware_concurrency
 
 #if PAW_BOOST_FOUND
 #include <boost/iostreams/filtering_stream.hpp>
@@ -72,43 +75,52 @@ main(int, char **)
 
   using Ttime = std::chrono::high_resolution_clock;
   using Tduration = std::chrono::duration<double, std::milli>;
-  paw::AlignmentOptions<uint16_t> opts;
 
   //database = database.substr(200, 25);
   //query = query.substr(0, 25);
 
-  auto t0 = Ttime::now();
-  //paw::arch_null::global_alignment(database, query, opts);
-  auto t1 = Ttime::now();
-  //std::cout << "null " << Tduration(t1 - t0).count() << " ms\n";
-  //std::cout << "score = " << opts.get_alignment_results()->score << "\n";
+  // Throughput of each architecture the library was compiled for
+  double const num_cells = static_cast<double>(database.size()) * static_cast<double>(query.size());
+  int name_width = 8;
 
-  //t0 = Ttime::now();
-  //opts = paw::AlignmentOptions<uint16_t>();
-  //paw::arch_popcnt_avx2::global_alignment(database, query, opts);
-  //t1 = Ttime::now();
-  //std::cout << "avx2 " << Tduration(t1 - t0).count() << " ms\n";
-  //std::cout << "score = " << opts.get_alignment_results()->score << "\n";
-
-  t0 = Ttime::now();
-  opts = paw::AlignmentOptions<uint16_t>();
-  paw::arch_sse4p1::global_alignment(database, query, opts);
-  t1 = Ttime::now();
-  std::cout << "sse4_1 " << Tduration(t1 - t0).count() << " ms\n";
-  std::cout << "score = " << opts.get_alignment_results()->score << "\n";
+  for (paw::AlignmentArch const & arch : paw::get_alignment_archs())
+    name_width = std::max(name_width, static_cast<int>(arch.name.size()) + 2);
 
-  t0 = Ttime::now();
-  opts = paw::AlignmentOptions<uint16_t>();
-  paw::arch_popcnt_avx::global_alignment(database, query, opts);
-  t1 = Ttime::now();
-  std::cout << "avx " << Tduration(t1 - t0).count() << " ms\n";
-  std::cout << "score = " << opts.get_alignment_results()->score << "\n";
+  std::cout << std::left << std::setw(name_width) << "arch" << std::right << std::setw(12) << "ms" << std::setw(10) << "GCUPS"
+            << std::setw(10) << "score" << "\n";
 
+  for (paw::AlignmentArch const & arch : paw::get_alignment_archs())
+  {
+    if (!arch.is_runnable)
+    {
+      std::cout << std::left << std::setw(name_width) << arch.name << std::right << std::setw(12) << "not runnable" << "\n";
+      continue;
+    }
+
+    paw::AlignmentOptions<uint16_t> opts;
+    auto t0 = Ttime::now();
+    arch.global_alignment_uint16(database, query, opts);
+    auto t1 = Ttime::now();
+    double const ms = Tduration(t1 - t0).count();
+
+    std::cout << std::left << std::setw(name_width) << arch.name << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << ms << std::setw(10) << std::setprecision(3) << num_cells / ms / 1.0e6
+              << std::setw(10) << opts.get_alignment_results()->score << "\n";
+  }
 
-  t0 = Ttime::now();
-  opts = paw::AlignmentOptions<uint16_t>();
+  auto t0 = Ttime::now();
+  paw::AlignmentOptions<uint16_t> opts;
   paw::global_alignment(database, query, opts);
-  t1 = Ttime::now();
+  auto t1 = Ttime::now();
   std::cout << "best " << Tduration(t1 - t0).count() << " ms\n";
   std::cout << "score = " << opts.get_alignment_results()->score << "\n";
+
+  // The same alignment split into tiles, which are computed on all threads
+  paw::AlignmentOptions<uint16_t> tiled_opts;
+  tiled_opts.num_threads = std::max(1u, std::thread::hardware_concurrency());
+  t0 = Ttime::now();
+  paw::global_alignment(database, query, tiled_opts);
+  t1 = Ttime::now();
+  std::cout << "tiled on " << tiled_opts.num_threads << " threads " << Tduration(t1 - t0).count() << " ms\n";
+  std::cout << "score = " << tiled_opts.get_alignment_results()->score << "\n";
 }
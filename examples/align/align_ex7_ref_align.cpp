@@ -12,6 +12,7 @@ main(int argc, char ** argv)
   std::string ref_fn;
   std::string contigs_fn;
   int min_length = 300;
+  bool is_full_alignment = false;
 
   try
   {
@@ -19,6 +20,8 @@ main(int argc, char ** argv)
     parser.parse_positional_argument(ref_fn, "REF", "Reference FASTA sequence.");
     parser.parse_positional_argument(contigs_fn, "FASTA", "Contig FASTA with sequences to align to the ref.");
     parser.parse_option(min_length, 'l', "min_length", "Minimum length for a contig for it to be considered.");
+    parser.parse_option(is_full_alignment, 'f', "full_alignment",
+                        "Align contigs to the whole reference instead of only between the seeds of a minimizer index.");
     parser.finalize();
   }
   catch (std::exception const & e)
@@ -41,6 +44,9 @@ main(int argc, char ** argv)
     std::exit(1);
   }
 
+  // Contigs are aligned between the anchors of the best chain of minimizers they share with the reference
+  paw::MinimizerIndex const index(ref.seqs[0]);
+
   paw::Fasta contigs;
   contigs.load(contigs_fn);
   //std::cerr << "Ref num seqs = " << contigs.seqs.size() << "\n";
@@ -53,21 +59,13 @@ main(int argc, char ** argv)
     if (static_cast<long>(seq.size()) < min_length)
       continue;
 
-    paw::global_alignment(seq, ref.seqs[0], opts);
-    auto ar1 = opts.get_alignment_results();
-    auto aligned_strings1 = *(ar1->aligned_strings_ptr);
-
-    std::string rseq = paw::reverse_complement(seq);
-    paw::global_alignment(rseq, ref.seqs[0], opts);
-    auto ar2 = opts.get_alignment_results();
-    auto aligned_strings2 = *(ar2->aligned_strings_ptr);
-
-    if (ar2->score > ar1->score)
-    {
-      // make aligned_strings1 better
-      std::swap(aligned_strings1, aligned_strings2);
-    }
+    // Both strands of the contig are aligned and the results of the better one are kept
+    if (is_full_alignment)
+      paw::global_alignment_both_strands(seq, ref.seqs[0], opts);
+    else
+      paw::seed_alignment_both_strands(seq, ref.seqs[0], index, opts);
 
+    auto aligned_strings1 = *(opts.get_alignment_results()->aligned_strings_ptr);
     std::swap(aligned_strings1.first, aligned_strings1.second);
     auto edits = paw::get_edit_script(aligned_strings1, true, false); // is_normalize, is_trim_indel_on_ends
 
@@ -0,0 +1,22 @@
+#include <paw/align.hpp>
+
+#include <cstdlib> // std::atol
+#include <iostream> // std::cerr
+
+
+namespace paw
+{
+
+/// \short Times shift_one_right through memory and in registers on the best available architecture
+void benchmark_shift_one_right(long num_iterations);
+
+} // namespace paw
+
+
+int
+main(int argc, char ** argv)
+{
+  long const num_iterations = argc > 1 ? std::atol(argv[1]) : 10000000;
+  std::cerr << "Current archs are: " << paw::get_current_arch() << "\n";
+  paw::benchmark_shift_one_right(num_iterations);
+}
@@ -0,0 +1,128 @@
+#include <chrono> // std::chrono::high_resolution_clock
+#include <cstdint> // uint8_t, uint16_t
+#include <iostream> // std::cout
+#include <random> // std::mt19937
+#include <vector> // std::vector
+
+#include <simdpp/simd.h>
+#include <simdpp/dispatch/get_arch_linux_cpuinfo.h>
+
+#include <paw/align/libsimdpp_utils.hpp>
+#include <paw/align/alignment_cache.hpp>
+
+
+#define SIMDPP_USER_ARCH_INFO ::simdpp::get_arch_linux_cpuinfo()
+
+
+namespace paw
+{
+namespace SIMDPP_ARCH_NAMESPACE
+{
+
+namespace
+{
+
+template <typename Tuint>
+void
+benchmark_shift_one_right_type(long const num_iterations)
+{
+  using Tpack = typename T<Tuint>::pack;
+  using Tvec_pack = typename T<Tuint>::vec_pack;
+  using Tarr_uint = typename T<Tuint>::arr_uint;
+
+  using Ttime = std::chrono::high_resolution_clock;
+  using Tduration = std::chrono::duration<double, std::milli>;
+
+  std::mt19937 rng(42);
+  AlignmentCache<Tuint> aln_cache;
+
+  for (auto & reduction : aln_cache.reductions)
+    reduction = static_cast<long>(rng() % 64);
+
+  aln_cache.update_reduction_deltas();
+
+  Tvec_pack packs;
+
+  for (long p = 0; p < 256; ++p)
+  {
+    Tarr_uint vec;
+
+    for (auto & element : vec)
+      element = static_cast<Tuint>(rng());
+
+    packs.push_back(static_cast<Tpack>(simdpp::load_u(&vec[0])));
+  }
+
+  Tuint const left = 7;
+
+  // Check that both implementations agree
+  for (auto const & pack : packs)
+  {
+    Tpack const expected = shift_one_right<Tuint>(pack, left, aln_cache.reductions);
+    Tpack const result = shift_one_right<Tuint>(pack,
+                                                left,
+                                                aln_cache.reduction_delta_add,
+                                                aln_cache.reduction_delta_sub,
+                                                aln_cache.left_mask);
+
+    if (simdpp::test_bits_any(static_cast<Tpack>(expected ^ result)))
+    {
+      std::cerr << "ERROR: The shifts of " << sizeof(Tuint) * 8 << "-bit packs differ.\n";
+      return;
+    }
+  }
+
+  // Each shift depends on the previous one like in the alignment kernel
+  Tpack acc = packs[0];
+  auto t0 = Ttime::now();
+
+  for (long k = 0; k < num_iterations; ++k)
+    acc = shift_one_right<Tuint>(acc ^ packs[k % packs.size()], left, aln_cache.reductions);
+
+  auto t1 = Ttime::now();
+  double const store_load_ms = Tduration(t1 - t0).count();
+  Tuint const store_load_checksum = simdpp::reduce_max(acc);
+
+  acc = packs[0];
+  t0 = Ttime::now();
+
+  for (long k = 0; k < num_iterations; ++k)
+  {
+    acc = shift_one_right<Tuint>(acc ^ packs[k % packs.size()],
+                                 left,
+                                 aln_cache.reduction_delta_add,
+                                 aln_cache.reduction_delta_sub,
+                                 aln_cache.left_mask);
+  }
+
+  t1 = Ttime::now();
+  double const in_register_ms = Tduration(t1 - t0).count();
+  Tuint const in_register_checksum = simdpp::reduce_max(acc);
+
+  std::cout << sizeof(Tuint) * 8 << "-bit, " << Tpack::length << " elements per pack\n"
+            << "  store/load  " << store_load_ms << " ms (checksum " << static_cast<long>(store_load_checksum)
+            << ")\n"
+            << "  in-register " << in_register_ms << " ms (checksum " << static_cast<long>(in_register_checksum)
+            << ")\n"
+            << "  speedup     " << store_load_ms / in_register_ms << "x\n";
+}
+
+
+} // anon namespace
+
+
+void
+benchmark_shift_one_right(long const num_iterations)
+{
+  benchmark_shift_one_right_type<uint8_t>(num_iterations);
+  benchmark_shift_one_right_type<uint16_t>(num_iterations);
+}
+
+
+} // namespace SIMDPP_ARCH_NAMESPACE
+
+
+SIMDPP_MAKE_DISPATCHER_VOID1(benchmark_shift_one_right, long)
+
+
+} // namespace paw
@@ -0,0 +1,391 @@
+#include <paw/align.hpp>
+#include <paw/parser.hpp>
+
+#include <algorithm> // std::max, std::find
+#include <chrono> // std::chrono::steady_clock
+#include <cstdint> // uint8_t, uint16_t
+#include <cstdlib> // std::malloc, std::free, EXIT_SUCCESS, EXIT_FAILURE
+#include <fstream> // std::ofstream
+#include <iostream> // std::cout, std::cerr
+#include <limits> // std::numeric_limits
+#include <new> // std::bad_alloc, std::align_val_t
+#include <random> // std::mt19937
+#include <sstream> // std::ostringstream
+#include <string> // std::string
+#include <vector> // std::vector
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h> // getrusage
+#endif
+
+
+// Benchmarks global alignments of every architecture the library has been compiled for, over sequence lengths,
+// identities, score widths, with and without traceback and with and without free database ends. The results are
+// written as JSON, one record per configuration, so they can be compared between commits.
+
+
+// Every allocation of the program is counted, including the ones made by the library
+namespace
+{
+
+long num_allocations{0};
+
+
+void *
+counted_malloc(std::size_t const size)
+{
+  ++num_allocations;
+
+  if (void * ptr = std::malloc(size > 0 ? size : 1))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+
+#if defined(__cpp_aligned_new)
+
+void *
+counted_aligned_alloc(std::size_t const size, std::align_val_t const alignment)
+{
+  ++num_allocations;
+  std::size_t const align = static_cast<std::size_t>(alignment);
+
+  if (void * ptr = std::aligned_alloc(align, (size + align - 1) / align * align))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+#endif // defined(__cpp_aligned_new)
+
+} // anon namespace
+
+
+void * operator new(std::size_t size) {return counted_malloc(size);}
+void * operator new[](std::size_t size) {return counted_malloc(size);}
+void operator delete(void * ptr) noexcept {std::free(ptr);}
+void operator delete[](void * ptr) noexcept {std::free(ptr);}
+void operator delete(void * ptr, std::size_t) noexcept {std::free(ptr);}
+void operator delete[](void * ptr, std::size_t) noexcept {std::free(ptr);}
+
+#if defined(__cpp_aligned_new)
+void * operator new(std::size_t size, std::align_val_t al) {return counted_aligned_alloc(size, al);}
+void * operator new[](std::size_t size, std::align_val_t al) {return counted_aligned_alloc(size, al);}
+void operator delete(void * ptr, std::align_val_t) noexcept {std::free(ptr);}
+void operator delete[](void * ptr, std::align_val_t) noexcept {std::free(ptr);}
+void operator delete(void * ptr, std::size_t, std::align_val_t) noexcept {std::free(ptr);}
+void operator delete[](void * ptr, std::size_t, std::align_val_t) noexcept {std::free(ptr);}
+#endif // defined(__cpp_aligned_new)
+
+
+namespace
+{
+
+struct Options
+{
+  std::vector<long> query_lengths{}; // Lists of the parser are appended to, so defaults are set after parsing
+  std::vector<long> database_lengths{}; // If empty, each database has the same length as its query
+  std::vector<double> identities{};
+  std::vector<std::string> archs{}; // If empty, every runnable architecture is benchmarked
+  long repeats{3};
+  long seed{42};
+  std::string output{"-"};
+};
+
+
+struct Config
+{
+  std::string arch{};
+  long width{8};
+  long query_length{0};
+  long database_length{0};
+  double identity{1.0};
+  bool traceback{false};
+  bool free_ends{false};
+};
+
+
+struct Result
+{
+  double best_ms{0.0};
+  double mean_ms{0.0};
+  long score{0};
+  long allocations_first{0}; // Allocations of the first alignment, which sets up the alignment cache
+  long allocations{0}; // Allocations of the last alignment
+  long peak_rss_kb{-1};
+};
+
+
+/// \short Returns the peak resident set size of the process in kilobytes, or -1 if it is not known
+long
+get_peak_rss_kb()
+{
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return -1;
+
+#if defined(__APPLE__)
+  return static_cast<long>(usage.ru_maxrss / 1024); // bytes on macOS
+#else
+  return static_cast<long>(usage.ru_maxrss);
+#endif
+#else
+  return -1;
+#endif
+}
+
+
+std::string
+get_random_dna(long const length, std::mt19937 & rng)
+{
+  std::uniform_int_distribution<int> base_dist(0, 3);
+  std::string seq(length, 'A');
+
+  for (auto & c : seq)
+    c = "ACGT"[base_dist(rng)];
+
+  return seq;
+}
+
+
+/// \short Returns a copy of the sequence where each base is edited with probability 1 - identity. Two thirds of the
+/// edits are substitutions and the rest are single base insertions and deletions.
+std::string
+get_mutated_dna(std::string const & seq, double const identity, std::mt19937 & rng)
+{
+  std::uniform_real_distribution<double> real_dist(0.0, 1.0);
+  std::uniform_int_distribution<int> base_dist(0, 3);
+  std::string mutated;
+  mutated.reserve(seq.size() + seq.size() / 8);
+
+  for (char const c : seq)
+  {
+    if (real_dist(rng) >= 1.0 - identity)
+    {
+      mutated.push_back(c);
+      continue;
+    }
+
+    double const type = real_dist(rng);
+
+    if (type < 2.0 / 3.0)
+      mutated.push_back("CGTA"[(paw::get_dna_code(c) + base_dist(rng) % 3) % 4]); // substitution
+    else if (type < 5.0 / 6.0)
+      mutated.append({c, "ACGT"[base_dist(rng)]}); // insertion
+    // else deletion
+  }
+
+  return mutated;
+}
+
+
+template <typename Tuint, typename Tfun>
+Result
+run_config(Config const & config,
+           std::string const & query,
+           std::string const & database,
+           long const repeats,
+           Tfun global_alignment)
+{
+  Result result;
+  paw::AlignmentOptions<Tuint> opt;
+  opt.get_cigar = config.traceback;
+  opt.left_column_free = config.free_ends;
+  opt.right_column_free = config.free_ends;
+  result.best_ms = std::numeric_limits<double>::max();
+
+  for (long r = 0; r < repeats; ++r)
+  {
+    long const allocations_before = num_allocations;
+    auto const start = std::chrono::steady_clock::now();
+    global_alignment(query, database, opt);
+    auto const end = std::chrono::steady_clock::now();
+    double const ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    if (r == 0)
+      result.allocations_first = num_allocations - allocations_before;
+
+    result.allocations = num_allocations - allocations_before;
+    result.best_ms = std::min(result.best_ms, ms);
+    result.mean_ms += ms / repeats;
+  }
+
+  result.score = opt.get_alignment_results()->score;
+  result.peak_rss_kb = get_peak_rss_kb();
+  return result;
+}
+
+
+std::string
+to_json(Config const & config, Result const & result)
+{
+  double const cells = static_cast<double>(config.query_length) * static_cast<double>(config.database_length);
+  std::ostringstream ss;
+  ss << "{\"arch\": \"" << config.arch << "\""
+     << ", \"width\": " << config.width
+     << ", \"query_length\": " << config.query_length
+     << ", \"database_length\": " << config.database_length
+     << ", \"identity\": " << config.identity
+     << ", \"traceback\": " << (config.traceback ? "true" : "false")
+     << ", \"free_ends\": " << (config.free_ends ? "true" : "false")
+     << ", \"score\": " << result.score
+     << ", \"best_ms\": " << result.best_ms
+     << ", \"mean_ms\": " << result.mean_ms
+     << ", \"gcups\": " << (result.best_ms > 0.0 ? cells / result.best_ms / 1.0e6 : 0.0)
+     << ", \"allocations_first\": " << result.allocations_first
+     << ", \"allocations\": " << result.allocations
+     << ", \"peak_rss_kb\": " << result.peak_rss_kb
+     << "}";
+  return ss.str();
+}
+
+
+} // anon namespace
+
+
+int
+main(int argc, char ** argv)
+{
+  Options options;
+  paw::Parser parser(argc, argv);
+  parser.set_name("bench_align - Benchmarks global alignments of every compiled architecture.");
+
+  try
+  {
+    parser.parse_option_list(options.query_lengths,
+                             'q',
+                             "query-lengths",
+                             "Lengths of the queries. Default: 150,1000,10000.");
+    parser.parse_option_list(options.database_lengths,
+                             'd',
+                             "database-lengths",
+                             "Lengths of the databases. If not set, each database has the same length as its query.");
+    parser.parse_option_list(options.identities,
+                             'i',
+                             "identities",
+                             "Identities between the queries and databases. Default: 0.99,0.9,0.75.");
+    // Names of architectures have commas, e.g. "SSE2,SSE3"
+    parser.parse_option_list(options.archs,
+                             'a',
+                             "archs",
+                             "Architectures to benchmark, separated by ';'. If not set, every runnable one.",
+                             ';',
+                             "arch1;...");
+    parser.parse_option(options.repeats, 'r', "repeats", "Number of alignments of each configuration.", "N");
+    parser.parse_option(options.seed, 's', "seed", "Seed of the random sequences.", "N");
+    parser.parse_option(options.output, 'o', "output", "Output JSON file, or '-' for standard output.", "FILE");
+    parser.finalize();
+  }
+  catch (const std::exception & e)
+  {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (options.query_lengths.empty())
+    options.query_lengths = {150, 1000, 10000};
+
+  if (options.identities.empty())
+    options.identities = {0.99, 0.90, 0.75};
+
+  if (options.repeats < 1)
+  {
+    std::cerr << "ERROR: The number of repeats must be positive." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream out_file;
+
+  if (options.output != "-")
+  {
+    out_file.open(options.output);
+
+    if (!out_file.is_open())
+    {
+      std::cerr << "ERROR: Could not open file " << options.output << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::ostream & out = options.output == "-" ? std::cout : out_file;
+  std::vector<paw::AlignmentArch> archs;
+  std::vector<std::string> skipped_archs;
+
+  for (auto const & arch : paw::get_alignment_archs())
+  {
+    if (!options.archs.empty() &&
+        std::find(options.archs.begin(), options.archs.end(), arch.name) == options.archs.end())
+    {
+      continue;
+    }
+
+    if (arch.is_runnable)
+      archs.push_back(arch);
+    else
+      skipped_archs.push_back(arch.name);
+  }
+
+  out << "{\n  \"repeats\": " << options.repeats << ",\n  \"seed\": " << options.seed << ",\n  \"skipped_archs\": [";
+
+  for (long i = 0; i < static_cast<long>(skipped_archs.size()); ++i)
+    out << (i > 0 ? ", " : "") << "\"" << skipped_archs[i] << "\"";
+
+  out << "],\n  \"results\": [";
+  bool is_first_result = true;
+
+  for (long const query_length : options.query_lengths)
+  {
+    std::vector<long> database_lengths = options.database_lengths;
+
+    if (database_lengths.empty())
+      database_lengths.push_back(query_length);
+
+    for (long const database_length : database_lengths)
+    {
+      for (double const identity : options.identities)
+      {
+        // The query and database are taken from the start of the same random sequence, then the query is mutated
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(options.seed));
+        std::string const source = get_random_dna(std::max(query_length, database_length), rng);
+        std::string const database = source.substr(0, database_length);
+        std::string const query = get_mutated_dna(source.substr(0, query_length), identity, rng);
+
+        for (auto const & arch : archs)
+        {
+          for (long const width : {8, 16})
+          {
+            for (bool const traceback : {false, true})
+            {
+              for (bool const free_ends : {false, true})
+              {
+                Config config;
+                config.arch = arch.name;
+                config.width = width;
+                config.query_length = static_cast<long>(query.size());
+                config.database_length = static_cast<long>(database.size());
+                config.identity = identity;
+                config.traceback = traceback;
+                config.free_ends = free_ends;
+
+                Result const result =
+                  width == 8 ?
+                  run_config<uint8_t>(config, query, database, options.repeats, arch.global_alignment_uint8) :
+                  run_config<uint16_t>(config, query, database, options.repeats, arch.global_alignment_uint16);
+
+                out << (is_first_result ? "\n    " : ",\n    ") << to_json(config, result);
+                out.flush();
+                is_first_result = false;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  out << "\n  ]\n}\n";
+  return EXIT_SUCCESS;
+}
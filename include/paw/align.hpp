@@ -2,15 +2,27 @@
 
 #include <string>
 
+#include <paw/align/alignment_archs.hpp>
 #include <paw/align/alignment_cache.hpp>
 #include <paw/align/alignment_options.hpp>
 #include <paw/align/alignment_results.hpp>
+#include <paw/align/banded_alignment.hpp>
+#include <paw/align/both_strand_alignment.hpp>
+#include <paw/align/dna_seq.hpp>
+#include <paw/align/edit_distance.hpp>
 #include <paw/align/event.hpp>
 #include <paw/align/fasta.hpp>
 #include <paw/align/global_alignment.hpp>
+#include <paw/align/graph.hpp>
+#include <paw/align/graph_alignment.hpp>
 #include <paw/align/libsimdpp_backtracker.hpp>
 #include <paw/align/libsimdpp_utils.hpp>
+#include <paw/align/local_alignment.hpp>
+#include <paw/align/seed_alignment.hpp>
 #include <paw/align/sequence_utils.hpp>
 #include <paw/align/skyr.hpp>
+#include <paw/align/substitution_matrix.hpp>
+#include <paw/align/tiled_alignment.hpp>
 #include <paw/align/variant.hpp>
 #include <paw/align/vcf.hpp>
+#include <paw/align/wavefront_alignment.hpp>
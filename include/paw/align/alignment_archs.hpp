@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint> // uint8_t, uint16_t
+#include <string> // std::string
+#include <utility> // std::move
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+
+
+namespace paw
+{
+
+/// \short An architecture which the alignment kernels have been compiled for
+struct AlignmentArch
+{
+  std::string name{}; // Instruction sets of the architecture, e.g. "SSE2,SSE3", or "NONE_NULL"
+  bool is_runnable{false}; // Set if the current CPU supports all instruction sets of the architecture
+
+  void (*global_alignment_uint8)(std::string const &, std::string const &, AlignmentOptions<uint8_t> &){nullptr};
+  void (*global_alignment_uint16)(std::string const &, std::string const &, AlignmentOptions<uint16_t> &){nullptr};
+  void (*local_alignment_uint8)(std::string const &, std::string const &, AlignmentOptions<uint8_t> &){nullptr};
+  void (*local_alignment_uint16)(std::string const &, std::string const &, AlignmentOptions<uint16_t> &){nullptr};
+};
+
+
+/// \short Returns every architecture the alignment kernels have been compiled for. Each architecture of the library
+/// adds itself when it is loaded, so the architectures can be called directly, e.g. to compare or benchmark them.
+inline std::vector<AlignmentArch> &
+get_alignment_archs()
+{
+  static std::vector<AlignmentArch> archs;
+  return archs;
+}
+
+
+/// \short Adds an architecture to the list returned by get_alignment_archs()
+inline void
+add_alignment_arch(AlignmentArch arch)
+{
+  get_alignment_archs().push_back(std::move(arch));
+}
+
+
+} // namespace paw
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
 #include <string>
+#include <vector>
 
 #include <paw/align/event.hpp>
 #include <paw/align/libsimdpp_utils.hpp>
 #include <paw/align/libsimdpp_backtracker.hpp>
+#include <paw/align/substitution_matrix.hpp>
 
 namespace paw
 {
@@ -14,7 +20,7 @@ namespace SIMDPP_ARCH_NAMESPACE
 template <typename Tuint>
 struct AlignmentCache
 {
-  using Tarr_vec_pack = typename T<Tuint>::arr_vec_pack;
+  using Tpack = typename T<Tuint>::pack;
   using Tarr_uint = typename T<Tuint>::arr_uint;
   using Tvec_pack = typename T<Tuint>::vec_pack;
 
@@ -27,88 +33,237 @@ struct AlignmentCache
   Tuint mismatch_val {0};
   Tuint gap_open_val {0};
   Tuint max_score_val {0};
+  bool is_linear_gap {false}; // Set when opening and extending gaps cost the same
+  bool is_dual_gap {false}; // Set when gaps also have a second cost, see set_dual_gap
+  Tuint gap_open_2_val_x {0}; // Penalty of opening a deletion with the second gap cost, with the gain removed
+  Tuint gap_open_2_val_y {0}; // Penalty of opening an insertion with the second gap cost, with the gain removed
+  Tuint gap_extend_2_gain_x {0}; // Increase of a deletion with the second gap cost for each column it is extended
+  Tuint gap_extend_2_gain_y {0}; // Increase of an insertion with the second gap cost for each row it is extended
   Tvec_pack vH_up{};
   Tvec_pack vF_up{};
+  Tvec_pack vH{}; // Scores of the current row
+  Tvec_pack vF{}; // Insertion scores of the current row
+  Tvec_pack vE{}; // Deletion scores of the current row
+  Tvec_pack vF2_up{};
+  Tvec_pack vF2{}; // Insertion scores of the current row with the second gap cost
+  Tvec_pack vE2{}; // Deletion scores of the current row with the second gap cost
+  Tvec_pack checkpoint_packs{}; // vH_up, vF_up and vF2_up above each block of backtrack rows, when they are recomputed
+  std::vector<std::array<long, S / sizeof(Tuint)> > checkpoint_reductions{}; // Reductions above each block
+  Tvec_pack vertex_packs{}; // vH_up, vF_up and vF2_up below each vertex of a graph, see graph_alignment
+  std::vector<std::array<long, S / sizeof(Tuint)> > vertex_reductions{}; // Reductions below each vertex
+  std::vector<long> score_row{}; // Scores of a row when they are needed in the order of the query
+  Tvec_pack vH_best{}; // Row with the best score so far, used by the X-drop and Z-drop
+  std::array<long, S / sizeof(Tuint)> best_reductions; // Reductions of the row with the best score
   Backtrack<Tuint> mB{};
-  Tarr_vec_pack W_profile;
+  std::vector<Tvec_pack> W_profile{}; // Scores of each database symbol against the query, see magic_function
+  std::vector<uint8_t> database_codes{}; // Row of W_profile of each database base, see set_database_codes
   std::array<long, S / sizeof(Tuint)> reductions;
+  Tpack reduction_delta_add; // Increase of each element when shifted one to the right, from the reductions
+  Tpack reduction_delta_sub; // Decrease of each element when shifted one to the right, from the reductions
+  Tpack left_mask; // Only the bits of the left-most element are set
+  bool is_left_boundary{false}; // Set when column 0 is inside the score matrix, see tiled_global_alignment
+  long left_boundary_H{0}; // Score of column 0 in the current row with its y gain, used when is_left_boundary is set
+  long left_boundary_E{0}; // Deletion score of column 0 in the current row with its y gain
+  long left_boundary_E2{0}; // Deletion score of column 0 with the second gap cost
 
   AlignmentCache()
   {
     //W_profile.fill(0);
     reductions.fill(0);
+    update_reduction_deltas();
+
+    Tarr_uint left_mask_arr;
+    left_mask_arr.fill(0);
+    left_mask_arr[0] = std::numeric_limits<Tuint>::max();
+    left_mask = simdpp::load_u(&left_mask_arr[0]);
+  }
+
+
+  /// \short Updates the reduction delta packs. Needs to be called every time the reductions change, except when all
+  /// elements change equally.
+  inline void
+  update_reduction_deltas()
+  {
+    Tarr_uint delta_add;
+    Tarr_uint delta_sub;
+    delta_add.fill(0);
+    delta_sub.fill(0);
+
+    for (long e = 1; e < static_cast<long>(reductions.size()); ++e)
+    {
+      long const delta = reductions[e - 1] - reductions[e];
+
+      if (delta > 0)
+        delta_add[e] = static_cast<Tuint>(delta);
+      else
+        delta_sub[e] = static_cast<Tuint>(std::min(-delta, static_cast<long>(std::numeric_limits<Tuint>::max())));
+    }
+
+    reduction_delta_add = simdpp::load_u(&delta_add[0]);
+    reduction_delta_sub = simdpp::load_u(&delta_sub[0]);
+  }
+
+
+  /// \short Returns the stored value of a score in column 0, which is at least min_stored. The score must have the y
+  /// gain of its row added.
+  inline Tuint
+  get_left_boundary_val(long const score, long const min_stored) const
+  {
+    long const val = std::min(std::max(score - reductions[0], min_stored), static_cast<long>(max_score_val));
+    return static_cast<Tuint>(val + std::numeric_limits<Tuint>::min());
   }
 
 
+  template <typename Tseq>
   inline void
-  set_query(std::string && new_query)
+  set_query(Tseq const & seq)
   {
-    query = std::move(new_query);
+    query.assign(begin(seq), end(seq));
     query_size = query.size();
     num_vectors = (query_size + T<Tuint>::pack::length) /
                   T<Tuint>::pack::length;
   }
 
 
+  /// \short Sets the gains and the query profile. When a substitution matrix is given, its highest score and highest
+  /// penalty are used as the match and mismatch values and the profile has a row for each symbol of the matrix.
   inline void
-  set_options(Tuint match, Tuint mismatch, Tuint gap_open, Tuint gap_extend)
+  set_options(Tuint match,
+              Tuint mismatch,
+              Tuint gap_open,
+              Tuint gap_extend,
+              SubstitutionMatrix const * const matrix = nullptr)
   {
+    if (matrix)
+    {
+      match = static_cast<Tuint>(std::max(0l, matrix->get_max_score()));
+      mismatch = static_cast<Tuint>(std::max(0l, -matrix->get_min_score()));
+    }
+
     x_gain = gap_extend;
-    y_gain = std::max(gap_extend, static_cast<Tuint>(mismatch - x_gain));
+    is_linear_gap = gap_open == gap_extend;
+    is_dual_gap = false;
+    // mismatch - x_gain would wrap around when mismatches cost less than extending a gap
+    y_gain = std::max(gap_extend, static_cast<Tuint>(mismatch > x_gain ? mismatch - x_gain : 0));
     gap_open_val = std::max(gap_open - x_gain, gap_open - y_gain);
     match_val = x_gain + y_gain + match;
     mismatch_val = x_gain + y_gain - mismatch;
     max_score_val = std::numeric_limits<Tuint>::max() - match_val - gap_open_val;
 
-    /// Calculate DNA W_profile
+    if (matrix)
+      set_matrix_profile(*matrix);
+    else
+      set_dna_profile();
+  }
+
+
+  /// \short Adds a second gap cost, which must open gaps at a higher and extend them at a lower penalty than the
+  /// first one. Needs to be called after set_options. The lowest stored score, 2 * gap_open_val, is raised so that
+  /// opening a gap with the second cost never goes below the minimum value and a gap which is extended from the
+  /// minimum value never gets a higher score than one which is opened.
+  inline void
+  set_dual_gap(Tuint const gap_open_2, Tuint const gap_extend_2)
+  {
+    is_dual_gap = true;
+    gap_open_2_val_x = gap_open_2 - x_gain;
+    gap_open_2_val_y = gap_open_2 - y_gain; // May wrap around, which is fine as long as the scores do not
+    gap_extend_2_gain_x = x_gain - gap_extend_2;
+    gap_extend_2_gain_y = y_gain - gap_extend_2;
+    gap_open_val = std::max({gap_open_val, gap_open_2_val_x, gap_extend_2_gain_x, gap_extend_2_gain_y});
+    max_score_val = std::numeric_limits<Tuint>::max() - match_val - gap_open_val;
+  }
+
+
+  /// \short Returns the number of bits needed to store each backtrack
+  inline long
+  get_backtrack_bits() const
+  {
+    if (is_dual_gap)
+      return 8;
+
+    return is_linear_gap ? 2 : 4; // Gap extensions do not need to be stored when they cost the same as opening a gap
+  }
+
+
+  /// \short Calculates the DNA profile, which has rows for A, C, G, T and N in the order of magic_function
+  inline void
+  set_dna_profile()
+  {
+    if (W_profile.size() < 5)
+      W_profile.resize(5);
+
+    std::array<char, 4> constexpr DNA_BASES = {{'A', 'C', 'G', 'T'}};
+
+    for (long i = 0; i < 4; ++i)
     {
-      std::array<char, 4> constexpr DNA_BASES = {{'A', 'C', 'G', 'T'}};
+      char const dna_base = DNA_BASES[i];
+      auto & W = W_profile[i];
+      W.clear(); // Clear previous elements
+      W.reserve(num_vectors);
 
-      for (long i = 0; i < 4; ++i)
       {
-        char const dna_base = DNA_BASES[i];
-        auto & W = W_profile[i];
-        W.clear(); // Clear previous elements
-        W.reserve(num_vectors);
-
+        for (long v = 0; v < num_vectors; ++v)
         {
-          for (long v = 0; v < num_vectors; ++v)
-          {
-            std::vector<Tuint> seq(T<Tuint>::pack::length, mismatch_val);
+          Tarr_uint seq;
+          seq.fill(mismatch_val);
 
-            for (long e = 0, j = v; j < query_size; j += num_vectors, ++e)
-            {
-              assert(j < static_cast<long>(query.size()));
-              char const query_dna_base = *(begin(query) + j);
-
-              if (dna_base == query_dna_base || query_dna_base == 'N')
-                seq[e] = match_val;
-            }
+          for (long e = 0, j = v; j < query_size; j += num_vectors, ++e)
+          {
+            assert(j < static_cast<long>(query.size()));
+            char const query_dna_base = *(begin(query) + j);
 
-            W.push_back(static_cast<typename T<Tuint>::pack>(simdpp::load_u(&seq[0])));
+            if (dna_base == query_dna_base || query_dna_base == 'N')
+              seq[e] = match_val;
           }
+
+          W.push_back(static_cast<typename T<Tuint>::pack>(simdpp::load_u(&seq[0])));
         }
       }
+    }
+
+    // All is a match with N
+    {
+      auto & W = W_profile[4];
+      W.assign(num_vectors, static_cast<typename T<Tuint>::pack>(simdpp::make_uint(match_val)));
+    }
+
+    assert(static_cast<std::size_t>(num_vectors) == W_profile[0].size());
+    assert(static_cast<std::size_t>(num_vectors) == W_profile[1].size());
+    assert(static_cast<std::size_t>(num_vectors) == W_profile[2].size());
+    assert(static_cast<std::size_t>(num_vectors) == W_profile[3].size());
+    assert(static_cast<std::size_t>(num_vectors) == W_profile[4].size());
+  }
+
 
-      // All is a match with N
+  /// \short Calculates the profile of a substitution matrix, which has a row for each symbol of the matrix
+  inline void
+  set_matrix_profile(SubstitutionMatrix const & matrix)
+  {
+    long const n_symbols = matrix.get_alphabet_size();
+
+    if (static_cast<long>(W_profile.size()) < n_symbols)
+      W_profile.resize(n_symbols);
+
+    for (long c = 0; c < n_symbols; ++c)
+    {
+      auto & W = W_profile[c];
+      W.clear();
+      W.reserve(num_vectors);
+
+      for (long v = 0; v < num_vectors; ++v)
       {
-        auto & W = W_profile[4];
-        W.clear(); // Clear previous elements
-        W.reserve(num_vectors);
+        Tarr_uint seq;
+        seq.fill(mismatch_val);
 
-        for (long v = 0; v < num_vectors; ++v)
+        for (long e = 0, j = v; j < query_size; j += num_vectors, ++e)
         {
-          std::vector<Tuint> seq(T<Tuint>::pack::length, match_val);
-          W.push_back(static_cast<typename T<Tuint>::pack>(simdpp::load_u(&seq[0])));
+          long const score = matrix.get_score_by_index(matrix.get_index(query[j]), c);
+          seq[e] = static_cast<Tuint>(x_gain + y_gain + score);
         }
-      }
 
-      assert(static_cast<std::size_t>(num_vectors) == W_profile[0].size());
-      assert(static_cast<std::size_t>(num_vectors) == W_profile[1].size());
-      assert(static_cast<std::size_t>(num_vectors) == W_profile[2].size());
-      assert(static_cast<std::size_t>(num_vectors) == W_profile[3].size());
-      assert(static_cast<std::size_t>(num_vectors) == W_profile[4].size());
-    } /// Done calculating DNA W_profile
+        W.push_back(static_cast<typename T<Tuint>::pack>(simdpp::load_u(&seq[0])));
+      }
+    }
   }
 
 
@@ -149,5 +304,17 @@ struct AlignmentCache
 
 };
 
+
+/// \short Returns the alignment cache of the current thread. The buffers of the cache keep their capacity between
+/// alignments, so aligning sequences which are not longer than previous ones does not allocate any memory.
+template <typename Tuint>
+inline AlignmentCache<Tuint> &
+get_thread_alignment_cache()
+{
+  static thread_local AlignmentCache<Tuint> aln_cache;
+  return aln_cache;
+}
+
+
 } // namespace SIMDPP_ARCH_NAMESPACE
 } // namespace paw
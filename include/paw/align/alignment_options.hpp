@@ -4,13 +4,17 @@
 #include <memory>
 #include <set>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <simdpp/simd.h>
 
 #include <paw/align/alignment_cache.hpp>
 #include <paw/align/alignment_results.hpp>
+#include <paw/align/dna_seq.hpp>
 //#include <paw/align/event.hpp>
 #include <paw/align/libsimdpp_utils.hpp>
+#include <paw/align/substitution_matrix.hpp>
 
 
 namespace paw
@@ -24,9 +28,27 @@ struct AlignmentOptions
 public:
   bool left_column_free{false};
   bool right_column_free{false};
-  bool continuous_alignment{false}; /// When set, always continue with the same alignment as long as the query is the same
+  bool top_row_free{false}; /// When set, a prefix of the query can be skipped without a penalty
+  bool bottom_row_free{false}; /// When set, a suffix of the query can be skipped without a penalty
+  bool continuous_alignment{false}; /// When set, always continue with the same alignment as long as the query is the same.
+                                    /// The database can then be aligned in segments, see global_alignment
   std::set<Event2> free_edits; // free SNP events
   bool get_aligned_strings{false};
+  bool get_cigar{false}; /// When set, the alignment is traced back into a CIGAR in the results
+  long band_width{-1}; /// When non-negative, only diagonals within this distance of the main diagonal(s) are computed
+  long backtrack_memory_limit{-1}; /// When non-negative, the maximum number of bytes used to store backtracks. Rows of
+                                   /// the backtrack are then recomputed from checkpoints during the traceback
+  long num_threads{1}; /// When more than one, global alignments are split into tiles which are computed on this
+                       /// many threads, see tiled_global_alignment
+  long tile_size{0}; /// Number of query columns and database rows of each tile. If 0, the query is split into one
+                     /// column of tiles per thread
+  long x_drop{-1}; /// When non-negative, global alignments stop after a row where every score is more than x_drop
+                   /// below the best score so far. The alignment then ends at the cell with the best score
+  long z_drop{-1}; /// When non-negative, global alignments stop after a row where every score is more than z_drop
+                   /// below the best score so far, plus gap_extend for each diagonal it is away from the best cell
+  double wfa_max_divergence{0.0}; /// When positive, global alignments with at most this fraction of mismatches and gap
+                                  /// bases (of the longer sequence) are computed with the wavefront algorithm, see
+                                  /// wavefront_alignment. Other alignments fall back to the score matrix
 
 private:
   /// User options
@@ -34,12 +56,12 @@ private:
   Tuint mismatch = 2; /// Penalty of mismatches
   Tuint gap_open = 5; /// Penalty of opening a gap
   Tuint gap_extend = 1; /// Penalty of extending a gap
+  Tuint gap_open_2 = 0; /// Penalty of opening a gap with the second gap cost, see is_dual_gap()
+  Tuint gap_extend_2 = 0; /// Penalty of extending a gap with the second gap cost
   Tuint clip = 5; /// Penalty of clipping the query
+  std::shared_ptr<SubstitutionMatrix const> substitution_matrix{}; /// When set, scores substitutions instead of the
+                                                                   /// match and mismatch values
   //bool is_traceback = true; /// Set if the alignment traceback is required
-
-  // TODO: Implement usage of "convex" gap cost
-  //Tuint gap_open_2 = 5; /// Penalty of opening a gap in when using a secondary value
-  //Tuint gap_extend_2 = 1; /// Penalty of extending a gap in when using a secondary value
   ///
 
   /// Calculated values
@@ -60,12 +82,24 @@ public:
   AlignmentOptions()
     : left_column_free(false)
     , right_column_free(false)
+    , top_row_free(false)
+    , bottom_row_free(false)
     , continuous_alignment(false)
+    , band_width(-1)
+    , backtrack_memory_limit(-1)
+    , num_threads(1)
+    , tile_size(0)
+    , x_drop(-1)
+    , z_drop(-1)
+    , wfa_max_divergence(0.0)
     , match(2)
     , mismatch(2)
     , gap_open(5)
     , gap_extend(1)
+    , gap_open_2(0)
+    , gap_extend_2(0)
     , clip(5)
+    , substitution_matrix()
     , ar(new AlignmentResults<Tuint>())
   {}
 
@@ -74,13 +108,25 @@ public:
   {
     left_column_free = ao.left_column_free;
     right_column_free = ao.right_column_free;
+    top_row_free = ao.top_row_free;
+    bottom_row_free = ao.bottom_row_free;
     continuous_alignment = ao.continuous_alignment;
+    band_width = ao.band_width;
+    backtrack_memory_limit = ao.backtrack_memory_limit;
+    num_threads = ao.num_threads;
+    tile_size = ao.tile_size;
+    x_drop = ao.x_drop;
+    z_drop = ao.z_drop;
+    wfa_max_divergence = ao.wfa_max_divergence;
 
     match = ao.match;
     mismatch = ao.mismatch;
     gap_open = ao.gap_open;
     gap_extend = ao.gap_extend;
+    gap_open_2 = ao.gap_open_2;
+    gap_extend_2 = ao.gap_extend_2;
     clip = ao.clip;
+    substitution_matrix = ao.substitution_matrix;
 
     ar = std::unique_ptr<AlignmentResults<Tuint> >(new AlignmentResults<Tuint>());
   }
@@ -90,13 +136,25 @@ public:
   {
     left_column_free = ao.left_column_free;
     right_column_free = ao.right_column_free;
+    top_row_free = ao.top_row_free;
+    bottom_row_free = ao.bottom_row_free;
     continuous_alignment = ao.continuous_alignment;
+    band_width = ao.band_width;
+    backtrack_memory_limit = ao.backtrack_memory_limit;
+    num_threads = ao.num_threads;
+    tile_size = ao.tile_size;
+    x_drop = ao.x_drop;
+    z_drop = ao.z_drop;
+    wfa_max_divergence = ao.wfa_max_divergence;
 
     match = ao.match;
     mismatch = ao.mismatch;
     gap_open = ao.gap_open;
     gap_extend = ao.gap_extend;
+    gap_open_2 = ao.gap_open_2;
+    gap_extend_2 = ao.gap_extend_2;
     clip = ao.clip;
+    substitution_matrix = ao.substitution_matrix;
 
     ar = std::move(ao.ar);
   }
@@ -107,13 +165,25 @@ public:
   {
     left_column_free = ao.left_column_free;
     right_column_free = ao.right_column_free;
+    top_row_free = ao.top_row_free;
+    bottom_row_free = ao.bottom_row_free;
     continuous_alignment = ao.continuous_alignment;
+    band_width = ao.band_width;
+    backtrack_memory_limit = ao.backtrack_memory_limit;
+    num_threads = ao.num_threads;
+    tile_size = ao.tile_size;
+    x_drop = ao.x_drop;
+    z_drop = ao.z_drop;
+    wfa_max_divergence = ao.wfa_max_divergence;
 
     match = ao.match;
     mismatch = ao.mismatch;
     gap_open = ao.gap_open;
     gap_extend = ao.gap_extend;
+    gap_open_2 = ao.gap_open_2;
+    gap_extend_2 = ao.gap_extend_2;
     clip = ao.clip;
+    substitution_matrix = ao.substitution_matrix;
 
     ar = std::unique_ptr<AlignmentResults<Tuint> >(new AlignmentResults<Tuint>());
     return *this;
@@ -125,13 +195,25 @@ public:
   {
     left_column_free = ao.left_column_free;
     right_column_free = ao.right_column_free;
+    top_row_free = ao.top_row_free;
+    bottom_row_free = ao.bottom_row_free;
     continuous_alignment = ao.continuous_alignment;
+    band_width = ao.band_width;
+    backtrack_memory_limit = ao.backtrack_memory_limit;
+    num_threads = ao.num_threads;
+    tile_size = ao.tile_size;
+    x_drop = ao.x_drop;
+    z_drop = ao.z_drop;
+    wfa_max_divergence = ao.wfa_max_divergence;
 
     match = ao.match;
     mismatch = ao.mismatch;
     gap_open = ao.gap_open;
     gap_extend = ao.gap_extend;
+    gap_open_2 = ao.gap_open_2;
+    gap_extend_2 = ao.gap_extend_2;
     clip = ao.clip;
+    substitution_matrix = ao.substitution_matrix;
 
     ar = std::move(ao.ar);
     return *this;
@@ -178,6 +260,26 @@ public:
   }
 
 
+  /// \brief Sets penalty of opening gaps with the second gap cost
+  /// It is assumed that the penalty is less or equal to 0
+  AlignmentOptions &
+  set_gap_open_2(long val)
+  {
+    gap_open_2 = val >= 0 ? static_cast<Tuint>(val) : static_cast<Tuint>(-val);
+    return *this;
+  }
+
+
+  /// \brief Sets penalty of extending gaps with the second gap cost
+  /// It is assumed that the penalty is less or equal to 0
+  AlignmentOptions &
+  set_gap_extend_2(long val)
+  {
+    gap_extend_2 = val >= 0 ? static_cast<Tuint>(val) : static_cast<Tuint>(-val);
+    return *this;
+  }
+
+
   /// \brief Sets penalty of clipping
   /// It is assumed that the penalty is less or equal to 0
   AlignmentOptions &
@@ -188,6 +290,20 @@ public:
   }
 
 
+  /// \brief Sets a substitution matrix which scores each pair of aligned symbols instead of the match and mismatch
+  /// values. An empty matrix removes a previously set one.
+  AlignmentOptions &
+  set_substitution_matrix(SubstitutionMatrix const & matrix)
+  {
+    if (matrix.empty())
+      substitution_matrix.reset();
+    else
+      substitution_matrix = std::make_shared<SubstitutionMatrix const>(matrix);
+
+    return *this;
+  }
+
+
   /*
   /// \brief Sets gap penalty for both opening and extending a gap
   /// It is assumed that the penalty is less or equal to 0
@@ -223,6 +339,19 @@ public:
   }
 
 
+  /// \brief Checks if gaps have two affine costs, where a gap of length k costs the lower of
+  /// gap_open + (k - 1) * gap_extend and gap_open_2 + (k - 1) * gap_extend_2. The second cost is only used when it
+  /// opens gaps at a higher and extends them at a lower penalty than the first, so it is the cost of long gaps. Local
+  /// alignments only use the first gap cost.
+  inline bool
+  is_dual_gap() const {return gap_open_2 > gap_open && gap_extend_2 < gap_extend;}
+
+
+  /// \brief Checks if the alignment needs to be traced back
+  inline bool
+  is_traceback() const {return get_aligned_strings || get_cigar;}
+
+
   inline Tuint
   get_match() const {return match;}
   inline Tuint
@@ -232,11 +361,21 @@ public:
   inline Tuint
   get_gap_extend() const {return gap_extend;}
   inline Tuint
+  get_gap_open_2() const {return gap_open_2;}
+  inline Tuint
+  get_gap_extend_2() const {return gap_extend_2;}
+  inline Tuint
   get_clip() const {return clip;}
+  /// Returns the substitution matrix, or a null pointer if the match and mismatch values are used
+  inline SubstitutionMatrix const *
+  get_substitution_matrix() const {return substitution_matrix.get();}
   //inline AlignmentCache<Tuint> *
   //get_alignment_cache() const {return ac.get();}
   inline AlignmentResults<Tuint> *
   get_alignment_results() const {return ar.get();}
+  /// Exchanges the results with other results, so the results of an alignment can be kept while another is made
+  inline void
+  swap_alignment_results(std::unique_ptr<AlignmentResults<Tuint> > & other) {std::swap(ar, other);}
   //inline bool get_is_traceback() const {return is_traceback;}
 
 };
@@ -251,19 +390,21 @@ void
 set_query(AlignmentOptions<Tuint> & opt, AlignmentCache<Tuint> & aln_cache, Tseq const & seq)
 {
   using Tpack = typename T<Tuint>::pack;
-  using Tvec_pack = typename T<Tuint>::vec_pack;
 
-  std::string new_query(begin(seq), end(seq));
   Tpack const min_value_pack = simdpp::make_int(std::numeric_limits<Tuint>::min());
-  //bool const is_new_query = new_query != aln_cache.query;
 
-  //if (is_new_query)
   {
-    aln_cache.set_query(std::move(new_query));
+    aln_cache.set_query(seq);
     aln_cache.set_options(opt.get_match(),
                           opt.get_mismatch(),
                           opt.get_gap_open(),
-                          opt.get_gap_extend());
+                          opt.get_gap_extend(),
+                          opt.get_substitution_matrix());
+
+    if (opt.is_dual_gap())
+      aln_cache.set_dual_gap(opt.get_gap_open_2(), opt.get_gap_extend_2());
+
+    aln_cache.is_left_boundary = false;
   }
 
   // set free snps
@@ -273,16 +414,16 @@ set_query(AlignmentOptions<Tuint> & opt, AlignmentCache<Tuint> & aln_cache, Tseq
   //  aln_cache.set_free_snp(e.pos, e.alt[0]);
   //}
 
-  aln_cache.vH_up = Tvec_pack(static_cast<std::size_t>(aln_cache.num_vectors),
-                              static_cast<Tpack>(simdpp::make_int(2 * aln_cache.gap_open_val +
-                                                                  std::numeric_limits<Tuint>::min()))
-                              );
+  aln_cache.vH_up.assign(static_cast<std::size_t>(aln_cache.num_vectors),
+                         static_cast<Tpack>(simdpp::make_int(2 * aln_cache.gap_open_val +
+                                                             std::numeric_limits<Tuint>::min()))
+                         );
 
   // init vH up
   {
     long const gap_open_val = aln_cache.gap_open_val;
-    std::vector<Tuint> new_vH0(T<Tuint>::pack::length,
-                               2 * gap_open_val + std::numeric_limits<Tuint>::min());
+    typename T<Tuint>::arr_uint new_vH0;
+    new_vH0.fill(2 * gap_open_val + std::numeric_limits<Tuint>::min());
 
     assert(aln_cache.vH_up.size() > 0);
     new_vH0[0] = gap_open_val * 3 + std::numeric_limits<Tuint>::min();
@@ -290,9 +431,80 @@ set_query(AlignmentOptions<Tuint> & opt, AlignmentCache<Tuint> & aln_cache, Tseq
 
   }
 
-  aln_cache.vF_up = Tvec_pack(static_cast<std::size_t>(aln_cache.num_vectors), min_value_pack);
+  aln_cache.vF_up.assign(static_cast<std::size_t>(aln_cache.num_vectors), min_value_pack);
+
+  if (aln_cache.is_dual_gap)
+    aln_cache.vF2_up.assign(static_cast<std::size_t>(aln_cache.num_vectors), min_value_pack);
   aln_cache.reductions.fill(static_cast<long>(-std::numeric_limits<Tuint>::min()) - aln_cache.gap_open_val * 3);
 
+  // When the top row is free every cell in it has a score of zero. Since the scores are stored with a gain of
+  // x_gain per column the stored values increase by x_gain with each vector and the rest is moved to the reductions
+  // of each element. The values start at x_gain above the usual top-left value, so the last vector of one element
+  // can be shifted to the first vector of the next element without going below the minimum value.
+  if (opt.top_row_free)
+  {
+    long const t = aln_cache.num_vectors;
+
+    for (long v = 0; v < t; ++v)
+    {
+      long const val = std::min(static_cast<long>(aln_cache.gap_open_val * 3 + aln_cache.x_gain * (v + 1)),
+                                static_cast<long>(aln_cache.max_score_val));
+
+      aln_cache.vH_up[v] = simdpp::make_int(val + std::numeric_limits<Tuint>::min());
+    }
+
+    for (long e = 0; e < static_cast<long>(aln_cache.reductions.size()); ++e)
+      aln_cache.reductions[e] += aln_cache.x_gain * (e * t - 1);
+  }
+  else if (aln_cache.is_dual_gap)
+  {
+    // A gap in the top row costs the lower of the two gap costs, so once the second cost is lower the scores with
+    // the x_gain added increase along the row. The scores of each element are stored relative to its lowest score,
+    // which is moved to the reductions of the element like above.
+    long const t = aln_cache.num_vectors;
+    long const gap_open_val = aln_cache.gap_open_val;
+
+    auto get_top_row_score =
+      [&](long const j) -> long
+      {
+        if (j == 0)
+          return 0;
+
+        long const gap_1 = static_cast<long>(opt.get_gap_open()) + (j - 1) * opt.get_gap_extend();
+        long const gap_2 = static_cast<long>(opt.get_gap_open_2()) + (j - 1) * opt.get_gap_extend_2();
+        return aln_cache.x_gain * j - std::min(gap_1, gap_2);
+      };
+
+    std::array<long, S / sizeof(Tuint)> extra_reductions;
+
+    for (long e = 0; e < static_cast<long>(extra_reductions.size()); ++e)
+    {
+      long min_score = get_top_row_score(e * t);
+
+      for (long v = 1; v < t; ++v)
+        min_score = std::min(min_score, get_top_row_score(e * t + v));
+
+      extra_reductions[e] = std::max(0l, min_score + gap_open_val);
+      aln_cache.reductions[e] += extra_reductions[e];
+    }
+
+    for (long v = 0; v < t; ++v)
+    {
+      typename T<Tuint>::arr_uint new_vH;
+
+      for (long e = 0; e < static_cast<long>(new_vH.size()); ++e)
+      {
+        long const val = 3 * gap_open_val + get_top_row_score(e * t + v) - extra_reductions[e];
+        new_vH[e] = static_cast<Tuint>(std::min(val, static_cast<long>(aln_cache.max_score_val)) +
+                                       std::numeric_limits<Tuint>::min());
+      }
+
+      aln_cache.vH_up[v] = simdpp::load_u(&new_vH[0]);
+    }
+  }
+
+  aln_cache.update_reduction_deltas();
+
 
 #ifndef NDEBUG
   opt.score_matrix.clear();
@@ -302,11 +514,122 @@ set_query(AlignmentOptions<Tuint> & opt, AlignmentCache<Tuint> & aln_cache, Tseq
 }
 
 
+/// \short Sets the rows above the database to the last row of a previous alignment of the same query, so the
+/// alignment continues from it. The reductions of each element are set so the scores of the element are stored from
+/// the lowest score up. When they do not all fit, the lowest scores are raised, like when scores are reduced lossily.
+template <typename Tuint>
+void
+set_rows_up(AlignmentCache<Tuint> & aln_cache, AlignmentRow const & row)
+{
+  using Tarr_uint = typename T<Tuint>::arr_uint;
+
+  long const m = aln_cache.query_size;
+  long const t = aln_cache.num_vectors;
+  long const lowest_score = 2 * aln_cache.gap_open_val;
+  long const max_score = aln_cache.max_score_val;
+  assert(static_cast<long>(row.scores.size()) == m + 1);
+
+  for (long e = 0; e < static_cast<long>(aln_cache.reductions.size()); ++e)
+  {
+    if (e * t > m)
+    {
+      // Elements after the end of the query have no scores
+      aln_cache.reductions[e] = aln_cache.reductions[e - 1];
+      continue;
+    }
+
+    long min_val = std::numeric_limits<long>::max();
+    long max_val = std::numeric_limits<long>::min();
+
+    for (long j = e * t; j < std::min((e + 1) * t, m + 1); ++j)
+    {
+      min_val = std::min(min_val, row.scores[j] + aln_cache.x_gain * j);
+      max_val = std::max(max_val, row.scores[j] + aln_cache.x_gain * j);
+    }
+
+    aln_cache.reductions[e] = std::max(min_val - lowest_score, max_val - max_score);
+  }
+
+  // Returns the stored value of a score in column j, which is at least min_stored
+  auto get_stored =
+    [&](long const score, long const j, long const min_stored) -> Tuint
+    {
+      long const val = score + aln_cache.x_gain * j - aln_cache.reductions[j / t];
+      return static_cast<Tuint>(std::min(std::max(val, min_stored), max_score) + std::numeric_limits<Tuint>::min());
+    };
+
+  for (long v = 0; v < t; ++v)
+  {
+    Tarr_uint vH_up;
+    Tarr_uint vF_up;
+    Tarr_uint vF2_up;
+    vH_up.fill(lowest_score + std::numeric_limits<Tuint>::min());
+    vF_up.fill(std::numeric_limits<Tuint>::min());
+    vF2_up.fill(std::numeric_limits<Tuint>::min());
+
+    for (long e = 0, j = v; j <= m; j += t, ++e)
+    {
+      vH_up[e] = get_stored(row.scores[j], j, lowest_score);
+      vF_up[e] = get_stored(row.insertion_scores[j], j, 0);
+
+      if (aln_cache.is_dual_gap)
+        vF2_up[e] = get_stored(row.insertion_scores_2[j], j, 0);
+    }
+
+    aln_cache.vH_up[v] = simdpp::load_u(&vH_up[0]);
+    aln_cache.vF_up[v] = simdpp::load_u(&vF_up[0]);
+
+    if (aln_cache.is_dual_gap)
+      aln_cache.vF2_up[v] = simdpp::load_u(&vF2_up[0]);
+  }
+
+  aln_cache.update_reduction_deltas();
+}
+
+
+/// \short Sets the row of the query profile of each base of a database sequence, so the alignment reads each base
+/// once. The sequence is read from begin to end, so its iterators only need to go forward.
+template <typename Tseq>
+void
+set_database_codes(std::vector<uint8_t> & codes, Tseq const & seq, SubstitutionMatrix const * const matrix)
+{
+  codes.clear();
+
+  for (auto it = begin(seq); it != end(seq); ++it)
+    codes.push_back(static_cast<uint8_t>(matrix ? matrix->get_index(*it) : magic_function(*it)));
+}
+
+
+/// \short Sets the rows of the query profile of a packed sequence, whose codes already are the rows of the DNA profile
+inline void
+set_database_codes(std::vector<uint8_t> & codes, DnaSeq const & seq, SubstitutionMatrix const * const matrix)
+{
+  if (matrix)
+  {
+    codes.clear();
+
+    for (char const c : seq)
+      codes.push_back(static_cast<uint8_t>(matrix->get_index(c)));
+  }
+  else
+  {
+    seq.get_codes(codes);
+  }
+}
+
+
+/// \short Allocates the backtrack matrix for a database sequence. At most max_rows rows are allocated, which is less
+/// than the size of the database when rows are recomputed from checkpoints.
 template <typename Tuint, typename Tseq>
 void
-set_database(AlignmentCache<Tuint> & aln_cache, Tseq const & seq)
+set_database(AlignmentCache<Tuint> & aln_cache, Tseq const & seq, long const max_rows = -1)
 {
-  aln_cache.mB = Backtrack<Tuint>(std::distance(begin(seq), end(seq)), aln_cache.num_vectors);
+  long n_rows = std::distance(begin(seq), end(seq));
+
+  if (max_rows >= 0)
+    n_rows = std::min(n_rows, max_rows);
+
+  aln_cache.mB.reset(n_rows, aln_cache.num_vectors, aln_cache.get_backtrack_bits());
 }
 
 
@@ -357,6 +680,15 @@ reduce_too_high_scores(AlignmentCache<Tuint> & aln_cache)
         aln_cache.vF_up[v] = aln_cache.vF_up[v] - new_reductions_pack;
         aln_cache.vH_up[v] = aln_cache.vH_up[v] - new_reductions_pack;
       }
+
+      // Insertions with the second gap cost can be lower than the reductions, they are then never the best
+      if (aln_cache.is_dual_gap)
+      {
+        for (long v = 0; v < num_vectors; ++v)
+          aln_cache.vF2_up[v] = simdpp::sub_sat(aln_cache.vF2_up[v], new_reductions_pack);
+      }
+
+      aln_cache.update_reduction_deltas();
     }
 
     Tuint const max_score = simdpp::reduce_max(aln_cache.vH_up[num_vectors - 1]);
@@ -382,6 +714,8 @@ reduce_too_high_scores(AlignmentCache<Tuint> & aln_cache)
 
         for (long e{0}; e < static_cast<long>(S / sizeof(Tuint)); ++e)
           aln_cache.reductions[e] += overflow_reduction_arr[e];
+
+        aln_cache.update_reduction_deltas();
       }
 
       for (long v = 0; v < num_vectors; ++v)
@@ -389,19 +723,27 @@ reduce_too_high_scores(AlignmentCache<Tuint> & aln_cache)
         aln_cache.vH_up[v] = simdpp::max(aln_cache.vH_up[v] - overflow_reduction, two_gap_open_pack);
         aln_cache.vF_up[v] = simdpp::max(aln_cache.vF_up[v] - overflow_reduction, two_gap_open_pack);
       }
+
+      // Insertions with the second gap cost are not raised to the lowest score, which could make them higher than
+      // they are. Ones that become the minimum value are never the best, since opening a gap gives a higher score.
+      if (aln_cache.is_dual_gap)
+      {
+        for (long v = 0; v < num_vectors; ++v)
+          aln_cache.vF2_up[v] = simdpp::sub_sat(aln_cache.vF2_up[v], overflow_reduction);
+      }
     }
   }
 }
 
 
+/// \short Stores the scores of row i in scores_row, in the order of the query
 template <typename Tuint>
-std::vector<long> inline
+inline void
 get_score_row(AlignmentCache<Tuint> const & aln_cache,
               long const i,
-              typename T<Tuint>::vec_pack const & vX)
+              typename T<Tuint>::vec_pack const & vX,
+              std::vector<long> & scores_row)
 {
-  //AlignmentCache<Tuint> const & aln_cache = *opt.get_alignment_cache();
-  //AlignmentResults<Tuint> const & aln_results = *opt.get_alignment_results();
   long const m = aln_cache.query_size;
   long const t = aln_cache.num_vectors;
 
@@ -409,120 +751,65 @@ get_score_row(AlignmentCache<Tuint> const & aln_cache,
   assert(vX.size() > 0);
   assert(t == static_cast<long>(vX.size()));
 
-  std::vector<Tuint> vec(vX[0].length, 0);
-  std::vector<std::vector<Tuint> > mat(t, vec);
-  std::vector<long> scores_row;
-  scores_row.reserve(m + 1ul);
+  scores_row.resize(m + 1);
 
   for (long v = 0; v < t; ++v)
-    simdpp::store_u(&mat[v][0], vX[v]);
-
-  for (long j = 0; j <= m; ++j)
   {
-    long const v = j % t;
-    long const e = j / t;
-    assert(v < static_cast<long>(mat.size()));
-    assert(e < static_cast<long>(mat[v].size()));
+    typename T<Tuint>::arr_uint vec;
+    simdpp::store_u(&vec[0], vX[v]);
 
-    long const adjustment = aln_cache.reductions[e] - aln_cache.y_gain * i - aln_cache.x_gain * j;
-    scores_row.push_back(static_cast<long>(mat[v][e] + adjustment));
+    for (long e = 0, j = v; j <= m; j += t, ++e)
+    {
+      assert(e < static_cast<long>(vec.size()));
+      long const adjustment = aln_cache.reductions[e] - aln_cache.y_gain * i - aln_cache.x_gain * j;
+      scores_row[j] = static_cast<long>(vec[e] + adjustment);
+    }
   }
+}
 
+
+template <typename Tuint>
+std::vector<long> inline
+get_score_row(AlignmentCache<Tuint> const & aln_cache,
+              long const i,
+              typename T<Tuint>::vec_pack const & vX)
+{
+  std::vector<long> scores_row;
+  get_score_row(aln_cache, i, vX, scores_row);
   return scores_row;
 }
 
 
-/*
+/// \short Returns the best score in row i of the score matrix, where the stored values are in vX. The stored values
+/// of vector v have x_gain * v more than the scores of their columns, so the best value of each element is carried
+/// from the last vector to the first while x_gain is subtracted for each vector. Columns after the query can be
+/// included, but their scores are never higher than the best score of the rows so far.
 template <typename Tuint>
-void
-merge_score_matrices(AlignmentOptions<Tuint> & final_opts, std::vector<AlignmentOptions<Tuint> *> const & opts_vec_ptr)
+long inline
+get_row_max_score(AlignmentCache<Tuint> const & aln_cache,
+                  long const i,
+                  typename T<Tuint>::vec_pack const & vX)
 {
-  using Tarr = std::array<long, S / sizeof(Tuint)>;
   using Tpack = typename T<Tuint>::pack;
 
-  assert(opts_vec_ptr.size() >= 1ul);
-
-  final_opts = *opts_vec_ptr[0];
-  auto & results = *final_opts.get_alignment_results();
-  auto const & cache = *final_opts.get_alignment_cache();
-
-  // Find an array that has the global max of reductions over all input reductions
-  Tarr max_reductions;
-  max_reductions = opts_vec_ptr[0]->get_alignment_results()->reductions;
-
-  for (long i = 1; i < static_cast<long>(opts_vec_ptr.size()); ++i)
-  {
-    Tarr const & reductions = opts_vec_ptr[i]->get_alignment_results()->reductions;
-
-    for (long j = 0; j < static_cast<long>(S / sizeof(Tuint)); ++j)
-    {
-      max_reductions[j] = std::max(reductions[j], max_reductions[j]);
-    }
-  }
-
-
-  for (long j = 0; j < static_cast<long>(S / sizeof(Tuint)); ++j)
-  {
-    std::cerr << j << " " << max_reductions[j] << "\n";
-  }
-
-
-  // Gather how much we need to reduce each vector such they have all reduced the same
-  for (long i = 0; i < static_cast<long>(opts_vec_ptr.size()); ++i)
-  {
-    Tarr const & reductions = opts_vec_ptr[i]->get_alignment_results()->reductions;
-    Tarr extra_reductions;
-    bool any_extra_reductions = false;
-
-    for (long j = 0; j < static_cast<long>(S / sizeof(Tuint)); ++j)
-    {
-      extra_reductions[j] = max_reductions[j] - reductions[j];
-
-      if (extra_reductions[j] != 0)
-        any_extra_reductions = true;
-    }
-
-    if (!any_extra_reductions)
-      continue;
-
-    Tpack extra_reductions_vec = simdpp::load(&extra_reductions[0]);
-    auto & vF_up = opts_vec_ptr[i]->get_alignment_results()->vF_up;
-    auto & vH_up = opts_vec_ptr[i]->get_alignment_results()->vH_up;
-
-    for (long v = 0; v < static_cast<long>(vF_up.size()); ++v)
-    {
-      vF_up[v] = simdpp::sub_sat(vF_up[v], extra_reductions_vec);
-      vH_up[v] = simdpp::sub_sat(vH_up[v], extra_reductions_vec);
-    }
-
-    // Set all reductions as "max_reductions"
-    opts_vec_ptr[i]->get_alignment_results()->reductions = max_reductions;
-  }
+  long const t = aln_cache.num_vectors;
+  Tpack const x_gain_pack = simdpp::make_uint(aln_cache.x_gain);
+  Tpack vmax = vX[t - 1];
 
-  results.reductions = max_reductions;
-  results.vF_up.reserve(cache.num_vectors);
-  results.vH_up.reserve(cache.num_vectors);
+  // Values which saturate at zero are never higher than the value of the vector they are compared with
+  for (long v = t - 2; v >= 0; --v)
+    vmax = simdpp::max(vX[v], static_cast<Tpack>(simdpp::sub_sat(vmax, x_gain_pack)));
 
-  // Find the best scores at each position
-  for (long v = 0; v < cache.num_vectors; ++v)
-  {
-    assert(opts_vec_ptr[0]);
-    assert(opts_vec_ptr[0]->get_alignment_results());
-    assert(static_cast<long>(opts_vec_ptr[0]->get_alignment_results()->vF_up.size()) == cache.num_vectors);
-    assert(v == static_cast<long>(results.vF_up.size()));
-    assert(v == static_cast<long>(results.vH_up.size()));
+  typename T<Tuint>::arr_uint vec;
+  simdpp::store_u(&vec[0], vmax);
+  long max_score = std::numeric_limits<long>::min();
 
-    results.vF_up.push_back(opts_vec_ptr[0]->get_alignment_results()->vF_up[v]);
-    results.vH_up.push_back(opts_vec_ptr[0]->get_alignment_results()->vH_up[v]);
+  for (long e = 0; e < static_cast<long>(vec.size()); ++e)
+    max_score = std::max(max_score, static_cast<long>(vec[e]) + aln_cache.reductions[e] - aln_cache.x_gain * e * t);
 
-    for (long i = 1; i < static_cast<long>(opts_vec_ptr.size()); ++i)
-    {
-      results.vF_up[v] = simdpp::max(results.vF_up[v], opts_vec_ptr[i]->get_alignment_results()->vF_up[v]);
-      results.vH_up[v] = simdpp::max(results.vH_up[v], opts_vec_ptr[i]->get_alignment_results()->vH_up[v]);
-    }
-  }
+  return max_score - aln_cache.y_gain * i;
 }
-*/
+
 
 #ifndef NDEBUG
 
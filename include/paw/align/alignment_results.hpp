@@ -1,8 +1,13 @@
 #pragma once
 
+#include <algorithm> // std::reverse
 #include <array>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include <paw/align/cigar.hpp>
 #include <paw/align/libsimdpp_backtracker.hpp>
 #include <paw/align/libsimdpp_utils.hpp>
 #include <paw/align/alignment_cache.hpp>
@@ -13,6 +18,20 @@
 namespace paw
 {
 
+/// \short Scores of the last row of an alignment, which the next alignment continues from when continuous_alignment
+/// is set. The scores are stored in the order of the query, so they do not depend on the SIMD architecture.
+struct AlignmentRow
+{
+  std::string query{}; // Query of the alignment
+  long num_rows{0}; // Number of database bases aligned, zero if there is no row to continue from
+  std::vector<long> scores{}; // Best score of each column
+  std::vector<long> insertion_scores{}; // Scores of insertions in each column
+  std::vector<long> insertion_scores_2{}; // Scores of insertions with the second gap cost, if it is used
+  long right_column_best_score{0}; // Best score in the right column and its row, used when the right column is free
+  long right_column_best_row{0};
+};
+
+
 // NOTE: AlignmentResults contain stuff which is irrelevant of type of SIMD instructions used, therefore
 // it is (and should not be) in the SIMDPP_ARCH_NAMESPACE namespace
 template <typename Tuint>
@@ -23,14 +42,27 @@ struct AlignmentResults
   long query_end{0};
   long database_begin{0};
   long database_end{0};
+  bool is_overflow{false}; // Set when the scores could not be represented and the score is a lower bound
+  bool is_dropped{false}; // Set when a global alignment was stopped by the X-drop or Z-drop and ends at its best cell
+  long num_lazy_e_rows{0}; // Number of rows where deletions had to be carried between vector elements
+  long num_lazy_e_vectors{0}; // Total number of vectors improved by deletions carried between elements
   std::unique_ptr<std::pair<std::string, std::string> > aligned_strings_ptr;
+  std::vector<Cigar> cigar; // Operations of the alignment, relative to the query. Set when it is traced back
+  std::vector<long> path; // Vertices of the path the query is aligned to, only set by graph_alignment
+  AlignmentRow last_row; // Last row of the alignment, only set when continuous_alignment is set
 
 public:
-  template <typename Tseq>
+  /// \brief Traces the alignment back from (database_end, query_end) into a CIGAR. Parts of the sequences after the
+  ///        end of the alignment are added unaligned. The aligned strings are only created if is_aligned_strings is
+  ///        set, since they are not needed when only the CIGAR is used.
+  /// \param[in] mB Backtrack which can be queried with is_del_at(i, j), is_ins_at(i, j), is_del_extend_at(i, j)
+  ///               and is_ins_extend_at(i, j), where i is the database row and j the query column of a cell
+  template <typename Tbacktrack, typename Tseq>
   inline void
-  get_aligned_strings(SIMDPP_ARCH_NAMESPACE::AlignmentCache<Tuint> & aln_cache,
-                      Tseq const & q,
-                      Tseq const & d);
+  traceback(Tbacktrack const & mB,
+            Tseq const & q,
+            Tseq const & d,
+            bool is_aligned_strings);
 
   template <typename Tseq>
   std::pair<long, long> inline
@@ -55,11 +87,12 @@ public:
 
 
 template <typename Tuint>
-template <typename Tseq>
+template <typename Tbacktrack, typename Tseq>
 inline void
-AlignmentResults<Tuint>::get_aligned_strings(paw::SIMDPP_ARCH_NAMESPACE::AlignmentCache<Tuint> & aln_cache,
-                                             Tseq const & q,
-                                             Tseq const & d)
+AlignmentResults<Tuint>::traceback(Tbacktrack const & mB,
+                                   Tseq const & q,
+                                   Tseq const & d,
+                                   bool const is_aligned_strings)
 {
   long i = database_end;
   long j = query_end;
@@ -67,115 +100,95 @@ AlignmentResults<Tuint>::get_aligned_strings(paw::SIMDPP_ARCH_NAMESPACE::Alignme
   assert(j <= static_cast<long>(q.size()));
   assert(i <= static_cast<long>(d.size()));
 
-  std::pair<std::string, std::string> s;
-  //std::cerr << database_end << " " << query_end << " " << d.size() << " " << q.size() << "\n";
-  /////*
-  //if (query_end < static_cast<long>(q.size()))
-  //{
-  //  s.first.append(std::string(q.rbegin(), q.rbegin() + q.size() - query_end));
-  //  s.second.append(d.size() - query_end, '-');
-  //
-  //  //del_count = 1;
-  //  //del_ext_count = d.size() - query_end - 1;
-  //}
-  ////*/
-  //return s;
-
-  auto add_del = [&]()
+  // The CIGAR is created backwards and reversed at the end
+  cigar.clear();
+
+  // Parts of the sequences after the end of the alignment are not aligned to anything
+  if (i < static_cast<long>(d.size()))
+    add_cigar_operation(cigar, INSERTION, d.size() - i);
+
+  if (j < static_cast<long>(q.size()))
+    add_cigar_operation(cigar, DELETION, q.size() - j);
+
+  auto add_del = [&](long const count)
                  {
-                   assert(j > 0);
-                   assert(j <= static_cast<long>(q.size()));
-                   //std::cout << "DEL SELECTED " << q[j - 1] << " " << j << "\n";
-                   s.first.push_back(q[j - 1]);
-                   s.second.push_back('-');
-                   --j;
+                   assert(j >= count);
+                   add_cigar_operation(cigar, DELETION, count);
+                   j -= count;
                  };
 
-  auto add_del_ext = [&]()
-                     {
-                       assert(j > 0);
-                       assert(j <= static_cast<long>(q.size()));
-                       //std::cout << "DELE SELECTED " << q[j - 1] << " " << j << "\n";
-                       s.first.push_back(q[j - 1]);
-                       s.second.push_back('-');
-                       --j;
-                     };
-
-  auto add_ins = [&]()
+  auto add_ins = [&](long const count)
                  {
-                   assert(i > 0);
-                   assert(i <= static_cast<long>(d.size()));
-                   //std::cout << "INS SELECTED " << d[i - 1] << " " << i << "\n";
-                   s.first.push_back('-');
-                   s.second.push_back(d[i - 1]);
-                   --i;
+                   assert(i >= count);
+                   add_cigar_operation(cigar, INSERTION, count);
+                   i -= count;
                  };
 
-  auto add_ins_ext = [&]()
-                     {
-                       assert(i > 0);
-                       assert(i <= static_cast<long>(d.size()));
-                       //std::cout << "INSE SELECTED " << d[i - 1] << " " << i << "\n";
-                       s.first.push_back('-');
-                       s.second.push_back(d[i - 1]);
-                       --i;
-                     };
-
   auto add_sub = [&]()
                  {
                    assert(j > 0l);
                    assert(j <= static_cast<long>(q.size()));
                    assert(i > 0l);
                    assert(i <= static_cast<long>(d.size()));
-                   //std::cout << "SUB SELECTED " << q[j - 1] << " " << d[i - 1] << "\n";
-
-                   s.first.push_back(q[j - 1]);
-                   s.second.push_back(d[i - 1]);
+                   char const q_base = q[j - 1];
+                   char const d_base = d[i - 1];
+                   bool const is_match = q_base == d_base || q_base == 'N' || d_base == 'N';
+                   add_cigar_operation(cigar, is_match ? SEQUENCE_MATCH : MISMATCH);
                    --i;
                    --j;
                  };
 
   while (i > 0 || j > 0)
   {
-    assert(s.first.size() == s.second.size());
-
     if (j == 0)
     {
-      while (i > 1)
-        add_ins_ext();
-
-      add_ins();
+      add_ins(i);
       break;
     }
 
     assert(i >= 0);
     assert(j >= 0);
-    long const v = j % aln_cache.mB.t;
-    long const e = j / aln_cache.mB.t;
 
     if (i == 0)
     {
-      assert(j > 0);
-      add_del();
-
-      while (j > 0)
-        add_del_ext();
+      add_del(j);
     }
-    else if (aln_cache.mB.is_del(i - 1, v, e))
+    else if (mB.is_del_at(i, j))
     {
-      while (j > 1 && aln_cache.mB.is_del_extend(i - 1, j % aln_cache.mB.t, j / aln_cache.mB.t))
-        add_del_ext();
+      long j_open = j; // Column where the deletion was opened
 
-      assert(j > 0);
-      add_del();
+      if (mB.is_del2_at(i, j))
+      {
+        // The deletion has the second gap cost, which has its own extensions
+        while (j_open > 1 && mB.is_del2_extend_at(i, j_open))
+          --j_open;
+      }
+      else
+      {
+        while (j_open > 1 && mB.is_del_extend_at(i, j_open))
+          --j_open;
+      }
+
+      assert(j_open > 0);
+      add_del(j - j_open + 1);
     }
-    else if (aln_cache.mB.is_ins(i - 1, v, e))
+    else if (mB.is_ins_at(i, j))
     {
-      while (i > 1 && aln_cache.mB.is_ins_extend(i - 1, v, e))
-        add_ins_ext();
+      long i_open = i; // Row where the insertion was opened
 
-      assert(i > 0);
-      add_ins();
+      if (mB.is_ins2_at(i, j))
+      {
+        while (i_open > 1 && mB.is_ins2_extend_at(i_open, j))
+          --i_open;
+      }
+      else
+      {
+        while (i_open > 1 && mB.is_ins_extend_at(i_open, j))
+          --i_open;
+      }
+
+      assert(i_open > 0);
+      add_ins(i - i_open + 1);
     }
     else
     {
@@ -183,12 +196,17 @@ AlignmentResults<Tuint>::get_aligned_strings(paw::SIMDPP_ARCH_NAMESPACE::Alignme
     }
   }
 
-  aligned_strings_ptr = std::unique_ptr<std::pair<std::string, std::string> >(
-    new std::pair<std::string, std::string>(
-      {std::string(s.first.rbegin(), s.first.rend()),
-       std::string(s.second.rbegin(), s.second.rend())
-      }
-      ));
+  std::reverse(cigar.begin(), cigar.end());
+
+  if (is_aligned_strings)
+  {
+    // The aligned strings of the previous alignment are reused
+    if (!aligned_strings_ptr)
+      aligned_strings_ptr = std::unique_ptr<std::pair<std::string, std::string> >(
+        new std::pair<std::string, std::string>());
+
+    get_aligned_strings(cigar, q, d, *aligned_strings_ptr);
+  }
 }
 
 
@@ -389,6 +407,11 @@ AlignmentResults<Tuint>::clear()
   score = 0;
   query_end = 0;
   database_end = 0;
+  is_dropped = false;
+  num_lazy_e_rows = 0;
+  num_lazy_e_vectors = 0;
+  cigar.clear();
+  path.clear();
 }
 
 
@@ -0,0 +1,474 @@
+#pragma once
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/libsimdpp_utils.hpp>
+#include <paw/align/substitution_matrix.hpp>
+
+#include <simdpp/simd.h>
+
+#include <algorithm> // std::max, std::min
+#include <array> // std::array
+#include <cassert> // assert
+#include <cstdint> // int32_t, uint8_t
+#include <iterator> // std::distance
+#include <limits> // std::numeric_limits
+#include <vector> // std::vector
+
+
+namespace paw
+{
+namespace SIMDPP_ARCH_NAMESPACE
+{
+
+/// \short Backtrack of a banded alignment.
+/// Cells are stored one anti-diagonal (r = i + j) after another, so only cells within the band are stored.
+struct BandedBacktrack
+{
+  uint8_t static constexpr DEL_BT = 1;
+  uint8_t static constexpr INS_BT = 2;
+  uint8_t static constexpr DEL_E_BT = 4;
+  uint8_t static constexpr INS_E_BT = 8;
+  uint8_t static constexpr DEL2_BT = 16; // The deletion has the second gap cost
+  uint8_t static constexpr INS2_BT = 32; // The insertion has the second gap cost
+  uint8_t static constexpr DEL2_E_BT = 64;
+  uint8_t static constexpr INS2_E_BT = 128;
+
+  long n{0}; // Number of database rows
+  long m{0}; // Number of query columns
+  long d_lo{0}; // Lowest diagonal (j - i) in the band
+  long d_hi{0}; // Highest diagonal (j - i) in the band
+  long stride{0}; // Maximum number of cells on one anti-diagonal
+  std::vector<uint8_t> matrix;
+
+  BandedBacktrack() = default;
+
+
+  BandedBacktrack(long const _n, long const _m, long const _d_lo, long const _d_hi)
+    : n(_n)
+    , m(_m)
+    , d_lo(_d_lo)
+    , d_hi(_d_hi)
+    , stride((_d_hi - _d_lo) / 2 + 1)
+  {
+    assert(d_lo <= 0);
+    assert(d_hi >= 0);
+  }
+
+
+  /// \short Allocates the backtrack matrix
+  /// \param[in] padding Number of extra elements at the end, which allows writing full SIMD vectors
+  void inline
+  allocate(long const padding)
+  {
+    matrix.assign(static_cast<std::size_t>((n + m + 1) * stride + padding), 0);
+  }
+
+
+  /// \short First row index of anti-diagonal r within the band
+  long inline
+  get_row_begin(long const r) const
+  {
+    long const x = r - d_hi; // Row of the cell at diagonal d_hi is ceil(x / 2)
+    return std::max(std::max(0l, r - m), x >= 0 ? (x + 1) / 2 : -((-x) / 2));
+  }
+
+
+  /// \short Last row index of anti-diagonal r within the band
+  long inline
+  get_row_end(long const r) const
+  {
+    return std::min(std::min(n, r), (r - d_lo) / 2);
+  }
+
+
+  uint8_t inline *
+  get_anti_diagonal(long const r, long const i)
+  {
+    return &matrix[r * stride + (i - get_row_begin(r))];
+  }
+
+
+  uint8_t inline
+  get(long const i, long const j) const
+  {
+    assert(j - i >= d_lo);
+    assert(j - i <= d_hi);
+    long const r = i + j;
+    return matrix[r * stride + (i - get_row_begin(r))];
+  }
+
+
+  bool inline
+  is_del_at(long const i, long const j) const {return get(i, j) & DEL_BT;}
+  bool inline
+  is_ins_at(long const i, long const j) const {return get(i, j) & INS_BT;}
+  bool inline
+  is_del_extend_at(long const i, long const j) const {return get(i, j) & DEL_E_BT;}
+  bool inline
+  is_ins_extend_at(long const i, long const j) const {return get(i, j) & INS_E_BT;}
+  bool inline
+  is_del2_at(long const i, long const j) const {return get(i, j) & DEL2_BT;}
+  bool inline
+  is_ins2_at(long const i, long const j) const {return get(i, j) & INS2_BT;}
+  bool inline
+  is_del2_extend_at(long const i, long const j) const {return get(i, j) & DEL2_E_BT;}
+  bool inline
+  is_ins2_extend_at(long const i, long const j) const {return get(i, j) & INS2_E_BT;}
+};
+
+
+/// \short Code of a query base. Only uppercase A, C, G and T match their database counterpart and N matches all.
+inline int32_t
+banded_query_code(char const c)
+{
+  switch (c)
+  {
+  case 'A':
+  case 'C':
+  case 'G':
+  case 'T':
+    return static_cast<int32_t>(magic_function(c));
+
+  case 'N':
+    return 4;
+
+  default:
+    return 5;
+  }
+}
+
+
+/// \short Global alignment restricted to a band of diagonals around the main diagonal(s).
+/// The band covers diagonals min(0, m - n) - band_width, ..., max(0, m - n) + band_width, so both corners of the
+/// matrix are always within it. Cells are computed one anti-diagonal at a time so each SIMD vector only depends on
+/// the two previous anti-diagonals, which makes the time and memory O((n + m) * band width).
+template <typename Tseq, typename Tuint>
+void
+banded_global_alignment(Tseq const & seq1, // seq1 is query
+                        Tseq const & seq2, // seq2 is database
+                        AlignmentOptions<Tuint> & opt)
+{
+  using Tpack = simdpp::int32<S / sizeof(int32_t)>;
+  using Tmask = typename Tpack::mask_vector_type;
+
+  long constexpr L = Tpack::length;
+  int32_t constexpr NEG_INF = std::numeric_limits<int32_t>::min() / 2;
+
+  assert(opt.get_alignment_results());
+  assert(opt.band_width >= 0);
+  AlignmentResults<Tuint> & aln_results = *opt.get_alignment_results();
+
+  long const m = std::distance(begin(seq1), end(seq1));
+  long const n = std::distance(begin(seq2), end(seq2));
+  long const d_lo = std::min(0l, m - n) - opt.band_width;
+  long const d_hi = std::max(0l, m - n) + opt.band_width;
+
+  int32_t const gap_open = opt.get_gap_open();
+  int32_t const gap_extend = opt.get_gap_extend();
+  bool const is_dual = opt.is_dual_gap();
+  int32_t const gap_open_2 = opt.get_gap_open_2();
+  int32_t const gap_extend_2 = opt.get_gap_extend_2();
+
+  // With a substitution matrix the codes are the indexes of the symbols in the matrix
+  SubstitutionMatrix const * const matrix = opt.get_substitution_matrix();
+
+  // Query codes are stored reversed so the query positions of an anti-diagonal are read with increasing rows
+  std::vector<int32_t> q_rev(m + L + 1, matrix ? 0 : 5);
+
+  {
+    auto it = begin(seq1);
+
+    for (long j = 0; j < m; ++j, ++it)
+      q_rev[m - 1 - j] = matrix ? static_cast<int32_t>(matrix->get_index(*it)) : banded_query_code(*it);
+  }
+
+  // Database codes, where d_codes[i] is the code of the database base of row i
+  std::vector<int32_t> d_codes(n + L + 1, matrix ? 0 : 4);
+
+  {
+    auto it = begin(seq2);
+
+    for (long i = 1; i <= n; ++i, ++it)
+      d_codes[i] = static_cast<int32_t>(matrix ? matrix->get_index(*it) : magic_function(*it));
+  }
+
+  auto get_substitution_score =
+    [matrix, &opt](int32_t const q_code, int32_t const d_code) -> int32_t
+    {
+      if (matrix)
+        return static_cast<int32_t>(matrix->get_score_by_index(q_code, d_code));
+
+      bool const is_match = q_code == d_code || q_code == 4 || d_code == 4;
+      return is_match ? static_cast<int32_t>(opt.get_match()) : -static_cast<int32_t>(opt.get_mismatch());
+    };
+
+  // Scores of the last three anti-diagonals, indexed by row. Element 0 is reserved for row -1.
+  std::vector<int32_t> scores((is_dual ? 11 : 7) * (n + L + 2), NEG_INF);
+  int32_t * H = &scores[0 * (n + L + 2) + 1];
+  int32_t * H1 = &scores[1 * (n + L + 2) + 1];
+  int32_t * H2 = &scores[2 * (n + L + 2) + 1];
+  int32_t * E = &scores[3 * (n + L + 2) + 1];
+  int32_t * E1 = &scores[4 * (n + L + 2) + 1];
+  int32_t * F = &scores[5 * (n + L + 2) + 1];
+  int32_t * F1 = &scores[6 * (n + L + 2) + 1];
+  int32_t * E2 = is_dual ? &scores[7 * (n + L + 2) + 1] : nullptr; // Gaps with the second gap cost
+  int32_t * E2_1 = is_dual ? &scores[8 * (n + L + 2) + 1] : nullptr;
+  int32_t * F2 = is_dual ? &scores[9 * (n + L + 2) + 1] : nullptr;
+  int32_t * F2_1 = is_dual ? &scores[10 * (n + L + 2) + 1] : nullptr;
+
+  BandedBacktrack mB(n, m, d_lo, d_hi);
+  bool const is_traceback = opt.is_traceback();
+
+  if (is_traceback)
+    mB.allocate(L);
+
+  Tpack const gap_open_pack = simdpp::make_int(gap_open);
+  Tpack const gap_extend_pack = simdpp::make_int(gap_extend);
+  Tpack const match_pack = simdpp::make_int(static_cast<int32_t>(opt.get_match()));
+  Tpack const mismatch_pack = simdpp::make_int(-static_cast<int32_t>(opt.get_mismatch()));
+  Tpack const n_code_pack = simdpp::make_int(4);
+  Tpack const zero_pack = simdpp::make_zero();
+  Tpack const del_pack = simdpp::make_int(BandedBacktrack::DEL_BT);
+  Tpack const ins_pack = simdpp::make_int(BandedBacktrack::INS_BT);
+  Tpack const del_e_pack = simdpp::make_int(BandedBacktrack::DEL_E_BT);
+  Tpack const ins_e_pack = simdpp::make_int(BandedBacktrack::INS_E_BT);
+  Tpack const gap_open_2_pack = simdpp::make_int(gap_open_2);
+  Tpack const gap_extend_2_pack = simdpp::make_int(gap_extend_2);
+  Tpack const del2_pack = simdpp::make_int(BandedBacktrack::DEL2_BT);
+  Tpack const ins2_pack = simdpp::make_int(BandedBacktrack::INS2_BT);
+  Tpack const del2_e_pack = simdpp::make_int(BandedBacktrack::DEL2_E_BT);
+  Tpack const ins2_e_pack = simdpp::make_int(BandedBacktrack::INS2_E_BT);
+  std::array<int32_t, L> bt_flags;
+  std::array<int32_t, L> substitution_scores;
+
+  // Score of a boundary cell in the first row or column
+  auto get_boundary_score = [&](long const len, bool const is_free) -> int32_t
+                            {
+                              if (len == 0 || is_free)
+                                return 0;
+
+                              int32_t const cost = gap_open + (len - 1) * gap_extend;
+
+                              if (is_dual)
+                                return -std::min(cost, static_cast<int32_t>(gap_open_2 + (len - 1) * gap_extend_2));
+
+                              return -cost;
+                            };
+
+  H[0] = 0;
+
+  // Best scores in the right column and bottom row, which are only used when they are free
+  long right_column_best_score = m == 0 ? 0 : std::numeric_limits<long>::min();
+  long right_column_best_row = 0;
+  long bottom_row_best_score = n == 0 ? 0 : std::numeric_limits<long>::min();
+  long bottom_row_best_column = 0;
+
+  for (long r = 1; r <= n + m; ++r)
+  {
+    std::swap(H2, H1);
+    std::swap(H1, H); // H1 is now the previous anti-diagonal and H2 the one before that
+    std::swap(E1, E);
+    std::swap(F1, F);
+
+    if (is_dual)
+    {
+      std::swap(E2_1, E2);
+      std::swap(F2_1, F2);
+    }
+
+    long const i_begin = mB.get_row_begin(r);
+    long const i_end = mB.get_row_end(r);
+    assert(i_begin <= i_end + 1); // Anti-diagonals can be empty when the band has a single diagonal
+
+    for (long i = i_begin; i <= i_end; i += L)
+    {
+      // Deletions, from cell (i, j - 1)
+      Tpack const h_left = simdpp::load_u(&H1[i]);
+      Tpack const e_ext = static_cast<Tpack>(simdpp::load_u(&E1[i])) - gap_extend_pack;
+      Tpack vE = h_left - gap_open_pack;
+      Tmask const is_del_extend = e_ext > vE;
+      vE = simdpp::max(vE, e_ext);
+
+      // Insertions, from cell (i - 1, j)
+      Tpack const h_up = simdpp::load_u(&H1[i - 1]);
+      Tpack const f_ext = static_cast<Tpack>(simdpp::load_u(&F1[i - 1])) - gap_extend_pack;
+      Tpack vF = h_up - gap_open_pack;
+      Tmask const is_ins_extend = f_ext > vF;
+      vF = simdpp::max(vF, f_ext);
+
+      // Substitutions, from cell (i - 1, j - 1)
+      Tpack vH = simdpp::load_u(&H2[i - 1]);
+
+      if (matrix)
+      {
+        // Scores of the matrix are gathered one element at a time
+        for (long k = 0; k < L; ++k)
+          substitution_scores[k] = get_substitution_score(q_rev[m - r + i + k], d_codes[i + k]);
+
+        vH = vH + static_cast<Tpack>(simdpp::load_u(&substitution_scores[0]));
+      }
+      else
+      {
+        Tpack const q_code = simdpp::load_u(&q_rev[m - r + i]);
+        Tpack const d_code = simdpp::load_u(&d_codes[i]);
+        Tmask const is_match = (q_code == d_code) | (q_code == n_code_pack) | (d_code == n_code_pack);
+        vH = vH + simdpp::blend(match_pack, mismatch_pack, is_match);
+      }
+
+      simdpp::store_u(&E[i], vE);
+      simdpp::store_u(&F[i], vF);
+      Tpack flags2 = zero_pack; // Backtracks of the gaps with the second gap cost
+
+      if (is_dual)
+      {
+        Tpack const e2_ext = static_cast<Tpack>(simdpp::load_u(&E2_1[i])) - gap_extend_2_pack;
+        Tpack vE2 = h_left - gap_open_2_pack;
+        Tmask const is_del2_extend = e2_ext > vE2;
+        vE2 = simdpp::max(vE2, e2_ext);
+
+        Tpack const f2_ext = static_cast<Tpack>(simdpp::load_u(&F2_1[i - 1])) - gap_extend_2_pack;
+        Tpack vF2 = h_up - gap_open_2_pack;
+        Tmask const is_ins2_extend = f2_ext > vF2;
+        vF2 = simdpp::max(vF2, f2_ext);
+
+        simdpp::store_u(&E2[i], vE2);
+        simdpp::store_u(&F2[i], vF2);
+
+        // The best gaps are used below, which have the second gap cost where it is higher
+        Tmask const is_del2 = vE2 > vE;
+        Tmask const is_ins2 = vF2 > vF;
+        vE = simdpp::max(vE, vE2);
+        vF = simdpp::max(vF, vF2);
+        flags2 = simdpp::blend(del2_pack, zero_pack, is_del2) |
+                 simdpp::blend(ins2_pack, zero_pack, is_ins2) |
+                 simdpp::blend(del2_e_pack, zero_pack, is_del2_extend) |
+                 simdpp::blend(ins2_e_pack, zero_pack, is_ins2_extend);
+      }
+
+      Tmask const is_ins = vF > vH;
+      vH = simdpp::max(vH, vF);
+      Tmask const is_del = vE > vH;
+      vH = simdpp::max(vH, vE);
+
+      simdpp::store_u(&H[i], vH);
+
+      if (is_traceback)
+      {
+        Tpack const flags = simdpp::blend(del_pack, zero_pack, is_del) |
+                            simdpp::blend(ins_pack, zero_pack, is_ins) |
+                            simdpp::blend(del_e_pack, zero_pack, is_del_extend) |
+                            simdpp::blend(ins_e_pack, zero_pack, is_ins_extend) |
+                            flags2;
+        simdpp::store_u(&bt_flags[0], flags);
+        uint8_t * bt = mB.get_anti_diagonal(r, i);
+
+        for (long k = 0; k < L; ++k)
+          bt[k] = static_cast<uint8_t>(bt_flags[k]);
+      }
+    }
+
+    // Right column is free, i.e. insertions at the end of the query are free
+    if (opt.right_column_free && r - m >= i_begin && r - m <= i_end && r - m > 0)
+    {
+      long const i = r - m;
+      int32_t const f_ext = F1[i - 1] - gap_extend;
+      bool const is_ins_extend = f_ext > H1[i - 1];
+      F[i] = is_ins_extend ? f_ext : H1[i - 1];
+
+      int32_t h = H2[i - 1] + get_substitution_score(q_rev[0], d_codes[i]);
+      bool const is_ins = F[i] > h;
+      h = std::max(h, F[i]);
+      int32_t const e = is_dual ? std::max(E[i], E2[i]) : E[i]; // Best deletion, like in the vectors above
+      bool const is_del = e > h;
+      H[i] = std::max(h, e);
+
+      if (is_traceback)
+      {
+        // Insertions are free, so only the backtracks of the deletions are kept
+        uint8_t & bt = *mB.get_anti_diagonal(r, i);
+        bt = static_cast<uint8_t>((bt & (BandedBacktrack::DEL_E_BT | BandedBacktrack::DEL2_BT |
+                                         BandedBacktrack::DEL2_E_BT)) |
+                                  (is_del ? BandedBacktrack::DEL_BT : 0) |
+                                  (is_ins ? BandedBacktrack::INS_BT : 0) |
+                                  (is_ins_extend ? BandedBacktrack::INS_E_BT : 0));
+      }
+    }
+
+    // Cell in the first row
+    if (i_begin == 0)
+    {
+      H[0] = get_boundary_score(r, opt.top_row_free);
+      E[0] = H[0];
+      F[0] = NEG_INF;
+
+      if (is_dual)
+      {
+        E2[0] = NEG_INF;
+        F2[0] = NEG_INF;
+      }
+    }
+
+    // Cell in the first column
+    if (i_end == r)
+    {
+      H[r] = get_boundary_score(r, opt.left_column_free);
+      E[r] = NEG_INF;
+      F[r] = H[r];
+
+      if (is_dual)
+      {
+        E2[r] = NEG_INF;
+        F2[r] = NEG_INF;
+      }
+    }
+
+    if (r - m >= i_begin && r - m <= i_end && H[r - m] > right_column_best_score)
+    {
+      right_column_best_score = H[r - m];
+      right_column_best_row = r - m;
+    }
+
+    if (n >= i_begin && n <= i_end && H[n] >= bottom_row_best_score)
+    {
+      bottom_row_best_score = H[n];
+      bottom_row_best_column = r - n;
+    }
+
+    // Make sure cells outside of the band are never used
+    H[i_begin - 1] = NEG_INF;
+    E[i_begin - 1] = NEG_INF;
+    F[i_begin - 1] = NEG_INF;
+    H[i_end + 1] = NEG_INF;
+    E[i_end + 1] = NEG_INF;
+    F[i_end + 1] = NEG_INF;
+
+    if (is_dual)
+    {
+      E2[i_begin - 1] = NEG_INF;
+      F2[i_begin - 1] = NEG_INF;
+      E2[i_end + 1] = NEG_INF;
+      F2[i_end + 1] = NEG_INF;
+    }
+  }
+
+  aln_results.score = H[n];
+  aln_results.query_end = m;
+  aln_results.database_end = n;
+
+  if (opt.bottom_row_free)
+  {
+    aln_results.score = bottom_row_best_score;
+    aln_results.query_end = bottom_row_best_column;
+  }
+
+  if (opt.right_column_free && aln_results.query_end == m)
+    aln_results.database_end = right_column_best_row;
+
+  if (is_traceback)
+    aln_results.traceback(mB, seq1, seq2, opt.get_aligned_strings);
+}
+
+
+} // namespace SIMDPP_ARCH_NAMESPACE
+} // namespace paw
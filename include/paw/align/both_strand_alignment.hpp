@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory> // std::unique_ptr
+#include <string> // std::string
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/global_alignment.hpp>
+#include <paw/align/seed_alignment.hpp>
+#include <paw/align/sequence_utils.hpp>
+
+
+namespace paw
+{
+
+/// \short Aligns the query and its reverse complement with align(seq), and keeps the results of the strand with the
+/// higher score in the options. The reverse complement is written to a buffer and the results of the other strand are
+/// kept for the next call, so aligning many queries does not allocate for each of them. The results are therefore not
+/// always at the same address after the call, see get_alignment_results. Returns true if the reverse complement aligned
+/// better, in which case the CIGAR and query positions of the results are relative to it.
+template <typename Tuint, typename Talign>
+inline bool
+align_both_strands(std::string const & query, AlignmentOptions<Tuint> & opts, Talign align)
+{
+  static thread_local std::string rc_query;
+  static thread_local std::unique_ptr<AlignmentResults<Tuint> > other_results(new AlignmentResults<Tuint>());
+
+  align(query);
+  opts.swap_alignment_results(other_results); // other_results now has the results of the forward strand
+  reverse_complement(query, rc_query);
+  align(rc_query);
+
+  if (opts.get_alignment_results()->score > other_results->score)
+    return true;
+
+  opts.swap_alignment_results(other_results);
+  return false;
+}
+
+
+/// \short Aligns both strands of the query globally to the database, see global_alignment and align_both_strands
+template <typename Tuint>
+inline bool
+global_alignment_both_strands(std::string const & query,
+                              std::string const & database,
+                              AlignmentOptions<Tuint> & opts)
+{
+  return align_both_strands(query,
+                            opts,
+                            [&](std::string const & seq)
+                            {
+                              paw::global_alignment(seq, database, opts);
+                            });
+}
+
+
+/// \short Aligns both strands of the query to the database with the seeds of one index of the database, see
+/// seed_alignment and align_both_strands
+template <typename Tuint>
+inline bool
+seed_alignment_both_strands(std::string const & query,
+                            std::string const & database,
+                            MinimizerIndex const & index,
+                            AlignmentOptions<Tuint> & opts)
+{
+  return align_both_strands(query,
+                            opts,
+                            [&](std::string const & seq)
+                            {
+                              paw::seed_alignment(seq, database, index, opts);
+                            });
+}
+
+
+} // namespace paw
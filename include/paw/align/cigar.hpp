@@ -1,16 +1,25 @@
 #pragma once
 
+#include <cassert> // assert
+#include <cstddef> // std::size_t
 #include <cstdint>
+#include <string> // std::string, std::to_string
+#include <utility> // std::pair
+#include <vector> // std::vector
 
 
 namespace paw
 {
 
+/// Operations are relative to the first sequence of an alignment, like in get_edit_script. A deletion is a base of
+/// the first sequence which is aligned to a gap and an insertion is a base of the second sequence aligned to a gap.
 enum CigarOperation
 {
-  MATCH = 0,
-  INSERTION,
-  DELETION
+  MATCH = 0, // 'M', the bases may or may not be equal
+  INSERTION, // 'I'
+  DELETION, // 'D'
+  SEQUENCE_MATCH, // '=', equal bases or either base is N
+  MISMATCH // 'X'
 };
 
 
@@ -20,4 +29,125 @@ struct Cigar
   CigarOperation operation;
 };
 
+
+inline char
+get_cigar_char(CigarOperation const operation)
+{
+  switch (operation)
+  {
+  case INSERTION: return 'I';
+  case DELETION: return 'D';
+  case SEQUENCE_MATCH: return '=';
+  case MISMATCH: return 'X';
+  default: return 'M';
+  }
+}
+
+
+/// \short Adds count operations to the end of a CIGAR, extending the last run if it has the same operation
+inline void
+add_cigar_operation(std::vector<Cigar> & cigar, CigarOperation const operation, std::size_t const count = 1)
+{
+  if (!cigar.empty() && cigar.back().operation == operation)
+    cigar.back().count += count;
+  else
+    cigar.push_back({count, operation});
+}
+
+
+/// \short Returns a CIGAR as a string, e.g. "10=1X2I5="
+inline std::string
+get_cigar_string(std::vector<Cigar> const & cigar)
+{
+  std::string cigar_str;
+
+  for (Cigar const & c : cigar)
+  {
+    cigar_str += std::to_string(c.count);
+    cigar_str.push_back(get_cigar_char(c.operation));
+  }
+
+  return cigar_str;
+}
+
+
+/// \short Returns the CIGAR of aligned strings
+inline std::vector<Cigar>
+get_cigar(std::pair<std::string, std::string> const & s)
+{
+  assert(s.first.size() == s.second.size());
+  std::vector<Cigar> cigar;
+
+  for (long i = 0; i < static_cast<long>(s.first.size()); ++i)
+  {
+    char const a = s.first[i];
+    char const b = s.second[i];
+
+    if (a == '-')
+      add_cigar_operation(cigar, INSERTION);
+    else if (b == '-')
+      add_cigar_operation(cigar, DELETION);
+    else if (a == b || a == 'N' || b == 'N')
+      add_cigar_operation(cigar, SEQUENCE_MATCH);
+    else
+      add_cigar_operation(cigar, MISMATCH);
+  }
+
+  return cigar;
+}
+
+
+/// \short Sets the aligned strings of two sequences from their CIGAR. The memory of the strings is reused.
+template <typename Tseq>
+inline void
+get_aligned_strings(std::vector<Cigar> const & cigar,
+                    Tseq const & first,
+                    Tseq const & second,
+                    std::pair<std::string, std::string> & s)
+{
+  s.first.clear();
+  s.second.clear();
+  auto it1 = begin(first);
+  auto it2 = begin(second);
+
+  for (Cigar const & c : cigar)
+  {
+    for (std::size_t k = 0; k < c.count; ++k)
+    {
+      switch (c.operation)
+      {
+      case INSERTION:
+        s.first.push_back('-');
+        s.second.push_back(*it2++);
+        break;
+
+      case DELETION:
+        s.first.push_back(*it1++);
+        s.second.push_back('-');
+        break;
+
+      default:
+        s.first.push_back(*it1++);
+        s.second.push_back(*it2++);
+        break;
+      }
+    }
+  }
+
+  assert(it1 == end(first));
+  assert(it2 == end(second));
+}
+
+
+/// \short Returns the aligned strings of two sequences from their CIGAR
+template <typename Tseq>
+inline std::pair<std::string, std::string>
+get_aligned_strings(std::vector<Cigar> const & cigar, Tseq const & first, Tseq const & second)
+{
+  std::pair<std::string, std::string> s;
+  get_aligned_strings(cigar, first, second, s);
+  return s;
+}
+
+
 } // namespace paw
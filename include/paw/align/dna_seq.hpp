@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm> // std::max, std::min, std::upper_bound
+#include <array> // std::array
+#include <cassert> // assert
+#include <cstddef> // std::ptrdiff_t
+#include <cstdint> // uint64_t
+#include <iterator> // std::distance, std::random_access_iterator_tag, std::reverse_iterator
+#include <memory> // std::shared_ptr
+#include <string> // std::string
+#include <utility> // std::move
+#include <vector> // std::vector
+
+
+namespace paw
+{
+
+/// \short Returns the code of a base, which is 0, 1, 2 and 3 for A, C, G and T (in upper or lower case) and 4 for
+/// anything else. The codes are the same as the rows of the DNA profile of the alignments, see magic_function.
+inline long
+get_dna_code(char const c)
+{
+  static std::array<char, 256> const table = []()
+                                             {
+                                               std::array<char, 256> t;
+                                               t.fill(4);
+                                               t['A'] = 0; t['a'] = 0;
+                                               t['C'] = 1; t['c'] = 1;
+                                               t['G'] = 2; t['g'] = 2;
+                                               t['T'] = 3; t['t'] = 3;
+                                               return t;
+                                             }();
+
+  return table[static_cast<unsigned char>(c)];
+}
+
+
+/// \short A DNA sequence packed with 2 bits per base. Positions of N are stored as runs, so a reference takes about a
+/// quarter of the memory of a std::string. Characters other than A, C, G and T (in upper or lower case) are stored as
+/// N. The sequence can be aligned like a std::string, and subsequences share the bases of the sequence they are taken
+/// from, so they are not copied.
+class DnaSeq
+{
+public:
+  /// \short Random access iterator over the bases of a sequence, which are returned by value
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = char;
+    using difference_type = std::ptrdiff_t;
+    using pointer = char const *;
+    using reference = char;
+
+    const_iterator() = default;
+    const_iterator(DnaSeq const * _seq, long const _pos) : seq(_seq), pos(_pos) {}
+
+    inline char operator*() const {return (*seq)[pos];}
+    inline char operator[](difference_type const k) const {return (*seq)[pos + k];}
+
+    inline const_iterator & operator++() {++pos; return *this;}
+    inline const_iterator & operator--() {--pos; return *this;}
+    inline const_iterator operator++(int) {const_iterator it(*this); ++pos; return it;}
+    inline const_iterator operator--(int) {const_iterator it(*this); --pos; return it;}
+    inline const_iterator & operator+=(difference_type const k) {pos += k; return *this;}
+    inline const_iterator & operator-=(difference_type const k) {pos -= k; return *this;}
+    inline const_iterator operator+(difference_type const k) const {return const_iterator(seq, pos + k);}
+    inline const_iterator operator-(difference_type const k) const {return const_iterator(seq, pos - k);}
+    inline difference_type operator-(const_iterator const & it) const {return pos - it.pos;}
+
+    inline bool operator==(const_iterator const & it) const {return pos == it.pos;}
+    inline bool operator!=(const_iterator const & it) const {return pos != it.pos;}
+    inline bool operator<(const_iterator const & it) const {return pos < it.pos;}
+    inline bool operator>(const_iterator const & it) const {return pos > it.pos;}
+    inline bool operator<=(const_iterator const & it) const {return pos <= it.pos;}
+    inline bool operator>=(const_iterator const & it) const {return pos >= it.pos;}
+
+  private:
+    DnaSeq const * seq{nullptr};
+    long pos{0};
+  };
+
+  using value_type = char;
+  using size_type = std::size_t;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  DnaSeq() = default;
+
+  explicit DnaSeq(std::string const & seq) : DnaSeq(seq.begin(), seq.end()) {}
+
+  template <typename Titer>
+  DnaSeq(Titer first, Titer last);
+
+  inline std::size_t
+  size() const {return static_cast<std::size_t>(length);}
+
+  inline bool
+  empty() const {return length == 0;}
+
+  /// \short Returns the code of the base at a position, see get_dna_code
+  inline long get_code(long pos) const;
+
+  inline char
+  operator[](long const pos) const {return "ACGTN"[get_code(pos)];}
+
+  /// \short Returns the bases from pos to pos + count, which share the memory of this sequence
+  inline DnaSeq subseq(long pos, long count) const;
+
+  inline std::string to_string() const;
+
+  /// \short Sets the code of each base, see get_dna_code. The bases are decoded in one pass, which is faster than
+  /// calling get_code for each of them.
+  template <typename Tcode>
+  inline void get_codes(std::vector<Tcode> & out) const;
+
+  inline const_iterator
+  begin() const {return const_iterator(this, 0);}
+
+  inline const_iterator
+  end() const {return const_iterator(this, length);}
+
+  inline const_reverse_iterator
+  rbegin() const {return const_reverse_iterator(end());}
+
+  inline const_reverse_iterator
+  rend() const {return const_reverse_iterator(begin());}
+
+private:
+  std::shared_ptr<std::vector<uint64_t> const> codes{}; // 32 bases per word, with the first base in the lowest bits
+  std::shared_ptr<std::vector<long> const> n_runs{}; // Begin and end of each run of N, in the order of the sequence
+  long offset{0}; // Position of the first base of the sequence in codes and n_runs
+  long length{0};
+};
+
+
+template <typename Titer>
+DnaSeq::DnaSeq(Titer first, Titer const last)
+{
+  std::vector<uint64_t> new_codes;
+  std::vector<long> new_n_runs;
+  long pos = 0;
+
+  for (; first != last; ++first, ++pos)
+  {
+    uint64_t code = get_dna_code(*first);
+
+    if (code == 4)
+    {
+      // N is stored as A in the codes
+      if (!new_n_runs.empty() && new_n_runs.back() == pos)
+      {
+        ++new_n_runs.back();
+      }
+      else
+      {
+        new_n_runs.push_back(pos);
+        new_n_runs.push_back(pos + 1);
+      }
+
+      code = 0;
+    }
+
+    if (pos % 32 == 0)
+      new_codes.push_back(0);
+
+    new_codes.back() |= code << (2 * (pos % 32));
+  }
+
+  codes = std::make_shared<std::vector<uint64_t> const>(std::move(new_codes));
+  n_runs = std::make_shared<std::vector<long> const>(std::move(new_n_runs));
+  length = pos;
+}
+
+
+inline long
+DnaSeq::get_code(long pos) const
+{
+  assert(pos >= 0 && pos < length);
+  pos += offset;
+
+  if (!n_runs->empty())
+  {
+    // The run of N is the last one which begins at or before the position, if any
+    auto it = std::upper_bound(n_runs->begin(), n_runs->end(), pos);
+
+    if ((it - n_runs->begin()) % 2 == 1)
+      return 4;
+  }
+
+  return static_cast<long>(((*codes)[pos / 32] >> (2 * (pos % 32))) & 3);
+}
+
+
+inline DnaSeq
+DnaSeq::subseq(long const pos, long const count) const
+{
+  assert(pos >= 0 && count >= 0 && pos + count <= length);
+  DnaSeq seq(*this);
+  seq.offset += pos;
+  seq.length = count;
+  return seq;
+}
+
+
+inline std::string
+DnaSeq::to_string() const
+{
+  return std::string(begin(), end());
+}
+
+
+template <typename Tcode>
+inline void
+DnaSeq::get_codes(std::vector<Tcode> & out) const
+{
+  out.resize(length);
+
+  for (long i = 0; i < length; ++i)
+  {
+    long const pos = offset + i;
+    out[i] = static_cast<Tcode>(((*codes)[pos / 32] >> (2 * (pos % 32))) & 3);
+  }
+
+  if (!n_runs)
+    return; // Default constructed sequence
+
+  // Runs of N are set afterwards, clipped to the subsequence
+  for (long r = 0; r < static_cast<long>(n_runs->size()); r += 2)
+  {
+    long const run_begin = std::max((*n_runs)[r] - offset, 0l);
+    long const run_end = std::min((*n_runs)[r + 1] - offset, length);
+
+    for (long i = run_begin; i < run_end; ++i)
+      out[i] = 4;
+  }
+}
+
+
+inline DnaSeq::const_iterator
+begin(DnaSeq const & seq)
+{
+  return seq.begin();
+}
+
+
+inline DnaSeq::const_iterator
+end(DnaSeq const & seq)
+{
+  return seq.end();
+}
+
+
+} // namespace paw
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <simdpp/simd.h>
+
+#include <algorithm> // std::fill, std::max, std::min
+#include <array> // std::array
+#include <cstdint> // uint8_t, uint64_t
+#include <cstdlib> // std::abs
+#include <vector> // std::vector
+
+
+namespace paw
+{
+
+/// \short Returns the edit distance between two sequences, i.e. the number of substitutions, insertions and deletions
+/// in the global alignment with the fewest of them. 'N' matches every base. If max_distance is not negative, -1 is
+/// returned as soon as the distance is known to be larger than max_distance.
+template <typename Tseq>
+long
+edit_distance(Tseq const & seq1,
+              Tseq const & seq2,
+              long max_distance = -1);
+
+
+namespace arch_null
+{
+
+template <typename Tseq>
+long
+edit_distance(Tseq const & seq1,
+              Tseq const & seq2,
+              long max_distance);
+
+}
+
+namespace arch_sse2
+{
+
+template <typename Tseq>
+long
+edit_distance(Tseq const & seq1,
+              Tseq const & seq2,
+              long max_distance);
+
+}
+
+namespace arch_sse3
+{
+
+template <typename Tseq>
+long
+edit_distance(Tseq const & seq1,
+              Tseq const & seq2,
+              long max_distance);
+
+}
+
+namespace arch_sse4p1
+{
+
+template <typename Tseq>
+long
+edit_distance(Tseq const & seq1,
+              Tseq const & seq2,
+              long max_distance);
+
+}
+
+namespace arch_sse4p1_popcnt
+{
+
+template <typename Tseq>
+long
+edit_distance(Tseq const & seq1,
+              Tseq const & seq2,
+              long max_distance);
+
+}
+
+namespace arch_popcnt_avx
+{
+
+template <typename Tseq>
+long
+edit_distance(Tseq const & seq1,
+              Tseq const & seq2,
+              long max_distance);
+
+}
+
+namespace arch_popcnt_avx2
+{
+
+template <typename Tseq>
+long
+edit_distance(Tseq const & seq1,
+              Tseq const & seq2,
+              long max_distance);
+
+}
+
+namespace arch_popcnt_avx512bw_avx512dq_avx512vl
+{
+
+template <typename Tseq>
+long
+edit_distance(Tseq const & seq1,
+              Tseq const & seq2,
+              long max_distance);
+
+}
+
+namespace arch_neon
+{
+
+template <typename Tseq>
+long
+edit_distance(Tseq const & seq1,
+              Tseq const & seq2,
+              long max_distance);
+
+}
+
+} // namespace paw
+
+
+namespace paw
+{
+namespace SIMDPP_ARCH_NAMESPACE
+{
+
+/// \short Vertical score differences of a block of 64 query positions in a column of the edit distance matrix
+struct EditDistanceBlock
+{
+  uint64_t Pv{~static_cast<uint64_t>(0)}; // Positions where the distance is one more than the position above
+  uint64_t Mv{0}; // Positions where the distance is one less than the position above
+  long score{0}; // Distance at the last position of the block
+};
+
+
+/// \short Moves a block one database base to the right (Myers 1999, Hyyro 2003). Eq has the positions of the block
+/// which match the database base, hin is the score difference above the block and the score difference at last_bit
+/// is returned.
+inline long
+advance_edit_distance_block(EditDistanceBlock & block, uint64_t Eq, long const hin, uint64_t const last_bit)
+{
+  uint64_t const hin_is_neg = hin < 0 ? 1 : 0;
+  uint64_t const Pv = block.Pv;
+  uint64_t const Mv = block.Mv;
+  uint64_t const Xv = Eq | Mv;
+  Eq |= hin_is_neg;
+  uint64_t const Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+  uint64_t Ph = Mv | ~(Xh | Pv);
+  uint64_t Mh = Pv & Xh;
+  long const hout = static_cast<long>((Ph & last_bit) != 0) - static_cast<long>((Mh & last_bit) != 0);
+  Ph = (Ph << 1) | (hin > 0 ? 1 : 0);
+  Mh = (Mh << 1) | hin_is_neg;
+  block.Pv = Mh | ~(Xv | Ph);
+  block.Mv = Ph & Xv;
+  return hout;
+}
+
+
+/// \short Calculates the edit distance with the bit-parallel algorithm of Myers, where the query (seq1) is split
+/// into blocks of 64 positions and the database (seq2) is processed one base at a time. With a maximum distance k,
+/// only blocks with positions within k of the diagonals that can reach the last cell are calculated (Ukkonen's
+/// cut-off), and the calculation stops when every calculated position has a distance larger than k.
+template <typename Tseq>
+long
+edit_distance(Tseq const & seq1, // seq1 is query
+              Tseq const & seq2, // seq2 is database
+              long const max_distance)
+{
+  long const m = seq1.size();
+  long const n = seq2.size();
+  long const k = max_distance < 0 ? m + n : max_distance;
+
+  if (std::abs(m - n) > k)
+    return -1;
+
+  if (m == 0 || n == 0)
+    return std::max(m, n);
+
+  long const WORD_BITS = 64;
+  long const num_blocks = (m + WORD_BITS - 1) / WORD_BITS;
+  uint64_t const HIGH_BIT = static_cast<uint64_t>(1) << (WORD_BITS - 1);
+
+  // Match bits of each symbol in the query. Database bases not in the query use the first symbol, which only matches
+  // query N, and database N uses the second symbol, which matches everything.
+  std::array<long, 256> symbol_index;
+  symbol_index.fill(0);
+  symbol_index[static_cast<uint8_t>('N')] = 1;
+  long num_symbols = 2;
+
+  for (auto const c : seq1)
+  {
+    if (symbol_index[static_cast<uint8_t>(c)] == 0)
+      symbol_index[static_cast<uint8_t>(c)] = num_symbols++;
+  }
+
+  std::vector<uint64_t> peq(num_symbols * num_blocks, 0);
+  std::fill(peq.begin() + num_blocks, peq.begin() + 2 * num_blocks, ~static_cast<uint64_t>(0));
+
+  for (long j = 0; j < m; ++j)
+  {
+    uint64_t const bit = static_cast<uint64_t>(1) << (j % WORD_BITS);
+    long const s = symbol_index[static_cast<uint8_t>(seq1[j])];
+
+    if (s == 1)
+    {
+      // Query N matches every database base
+      for (long e = 0; e < num_symbols; ++e)
+        peq[e * num_blocks + j / WORD_BITS] |= bit;
+    }
+    else
+    {
+      peq[s * num_blocks + j / WORD_BITS] |= bit;
+    }
+  }
+
+  std::vector<EditDistanceBlock> blocks(num_blocks);
+  long const last_block_size = m - (num_blocks - 1) * WORD_BITS;
+  uint64_t const last_block_bit = static_cast<uint64_t>(1) << (last_block_size - 1);
+  long last_block = -1; // Last block calculated in the previous column
+
+  for (long i = 1; i <= n; ++i)
+  {
+    // Positions further than k from the diagonals of the first and the last cell have a distance larger than k
+    long const max_j = std::min(i + k, m - n + i + k);
+    long const new_last_block = std::min(num_blocks - 1, (max_j - 1) / WORD_BITS);
+
+    // New blocks start with scores increasing by one from the block above, which are never too low
+    while (last_block < new_last_block)
+    {
+      ++last_block;
+      EditDistanceBlock & block = blocks[last_block];
+      block.Pv = ~static_cast<uint64_t>(0);
+      block.Mv = 0;
+      block.score = (last_block == 0 ? i - 1 : blocks[last_block - 1].score) +
+                    (last_block == num_blocks - 1 ? last_block_size : WORD_BITS);
+    }
+
+    uint64_t const * const eq = &peq[symbol_index[static_cast<uint8_t>(seq2[i - 1])] * num_blocks];
+    long hin = 1; // The first row has distances 0, 1, 2, ...
+    bool is_within = i <= k;
+
+    for (long b = 0; b <= last_block; ++b)
+    {
+      bool const is_last = b == num_blocks - 1;
+      hin = advance_edit_distance_block(blocks[b], eq[b], hin, is_last ? last_block_bit : HIGH_BIT);
+      blocks[b].score += hin;
+
+      // A position in the block has at least the score of the last position minus the number of positions below it
+      is_within |= blocks[b].score - (is_last ? last_block_size : WORD_BITS) + 1 <= k;
+    }
+
+    // The distance of the sequences is at least the lowest distance in any column
+    if (!is_within)
+      return -1;
+  }
+
+  long const distance = blocks[num_blocks - 1].score;
+  return distance <= k ? distance : -1;
+}
+
+
+} // namespace SIMDPP_ARCH_NAMESPACE
+} // namespace paw
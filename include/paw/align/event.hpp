@@ -2,10 +2,13 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iterator> // std::back_inserter
 #include <set>
 #include <string> // std::string
 #include <vector>
 
+#include <paw/align/cigar.hpp>
+
 namespace paw
 {
 
@@ -70,159 +73,144 @@ operator==(Event2 const & a, Event2 const & b)
 }
 
 
+/// \short Returns the edits of an alignment from its CIGAR. Positions of the edits are relative to the first
+/// sequence and the second sequence has the alternative alleles. N matches every base.
+/// \param[in] cigar CIGAR of the alignment, with '=' and 'X' or 'M' operations for aligned bases
+/// \param[in] first first sequence, without gaps
+/// \param[in] second second sequence, without gaps
+/// \param[in] is_normalize set to move indels as far left as possible
+/// \param[in] is_trim_indel_on_ends set to skip indels at the beginning and end of the alignment
 inline std::set<Event2>
-get_edit_script(std::pair<std::string, std::string> const & s,
+get_edit_script(std::vector<Cigar> const & cigar,
+                std::string const & first,
+                std::string const & second,
                 bool const is_normalize,
                 bool const is_trim_indel_on_ends)
 {
-  using Tedit_script = std::set<Event2>;
-  assert(s.first.size() == s.second.size());
-
-  Tedit_script edit_script;
-
-  // reference string without gaps
-  std::string ref;
-  std::copy_if(s.first.begin(), s.first.end(), std::back_inserter(ref), [](char c){
-      return c != '-';
-    });
-
-  // strings which are going to be used to create a new variant event
-  std::vector<char> s1;
-  std::vector<char> s2;
+  std::set<Event2> edit_script;
 
-  // position of the new variant event
-  long pos{0};
-  long pos_q{0};
-
-  auto are_s1_s2_empty =
-    [&s1, &s2]() -> bool {
-      return s1.empty() && s2.empty();
-    };
+  // Current indel, as a range of bases in each sequence. An empty range means the indel has no bases in that
+  // sequence, and both ranges are empty when there is no indel.
+  long pos{0}; // Position in the first sequence after the indel
+  long pos_q{0}; // Position in the second sequence after the indel
+  long indel_size{0}; // Number of bases of the indel in the first sequence
+  long indel_size_q{0}; // Number of bases of the indel in the second sequence
 
   auto add_to_edit_script =
-    [&pos, &pos_q, &s, &s1, &s2, &edit_script, &ref, is_normalize, is_trim_indel_on_ends]() -> void
+    [&](long const size, long const size_q)
     {
-      long event_position = pos - static_cast<long>(s1.size());
-      long event_position_q = pos_q - static_cast<long>(s2.size());
+      long event_position = pos - size;
+      long event_position_q = pos_q - size_q;
       assert(event_position >= 0);
       assert(event_position_q >= 0);
 
-      if (is_trim_indel_on_ends && (s1.size() != s2.size() && event_position == 0))
-      {
-        s1.clear();
-        s2.clear();
+      if (is_trim_indel_on_ends && (size != size_q && event_position == 0))
         return;
-      }
+
+      std::string ref = first.substr(event_position, size);
+      std::string alt = second.substr(event_position_q, size_q);
 
       // Normalization is not possible if event_position is zero
       if (is_normalize && event_position > 0)
       {
-        if (s1.empty())
-        {
-          // Normalize insertion
-          long const s2_size = s2.size();
-          assert(event_position - 1 < static_cast<long>(ref.size()));
+        // Either the ref or alt allele is empty, the other one is moved left until its last base differs from the
+        // base before it
+        std::string & allele = ref.empty() ? alt : ref;
 
-          while (event_position > 0 && s2[s2_size - 1] == ref[event_position - 1])
-          {
-            s2.insert(s2.begin(), s2[s2_size - 1]); // Insert base in front
-            s2.resize(s2_size); // Remove base in back to keep the same size
-            --event_position; // Adjust event position accordingly
-            --event_position_q;
-          }
-        }
-        else if (s2.empty())
+        if (ref.empty() != alt.empty())
         {
-          // Normalize deletion
-          long const s1_size = s1.size();
-          assert(event_position - 1 < static_cast<long>(ref.size()));
-
-          while (event_position > 0 && s1[s1_size - 1] == ref[event_position - 1])
+          while (event_position > 0 && allele.back() == first[event_position - 1])
           {
-            s1.insert(s1.begin(), s1[s1_size - 1]); // Insert base in front
-            s1.resize(s1_size); // Remove base in back to keep the same size
+            allele.insert(allele.begin(), allele.back()); // Insert base in front
+            allele.pop_back(); // Remove base in back to keep the same size
             --event_position; // Adjust event position accordingly
             --event_position_q;
           }
         }
       }
 
-      {
-        // Create a new variant event
-        Event2 new_edit(event_position, event_position_q,
-                        std::string(s1.begin(), s1.end()),
-                        std::string(s2.begin(), s2.end()));
+      edit_script.insert(Event2(event_position, event_position_q, std::move(ref), std::move(alt)));
+    };
 
-        edit_script.insert(std::move(new_edit));
-      }
+  auto add_indel =
+    [&]()
+    {
+      if (indel_size > 0 || indel_size_q > 0)
+        add_to_edit_script(indel_size, indel_size_q);
 
-      s1.clear();
-      s2.clear();
+      indel_size = 0;
+      indel_size_q = 0;
     };
 
-  for (long i = 0; i < static_cast<long>(s.first.size()); ++i)
+  for (Cigar const & c : cigar)
   {
-    // Both string cant have a gap
-    assert(s.first[i] != '-' || s.second[i] != '-');
+    long const count = c.count;
 
-    if (s.first[i] == '-')
+    switch (c.operation)
     {
-      // Insertion
-      if (are_s1_s2_empty() || (s2.size() > 0 && s1.size() == 0))
-      {
-        s2.push_back(s.second[i]); // Extend the insertion
-      }
-      else
+    case INSERTION:
+      // An insertion after a deletion is a new event
+      if (indel_size > 0)
+        add_indel();
+
+      pos_q += count;
+      indel_size_q += count;
+      break;
+
+    case DELETION:
+      if (indel_size_q > 0)
+        add_indel();
+
+      pos += count;
+      indel_size += count;
+      break;
+
+    case SEQUENCE_MATCH:
+      add_indel();
+      pos += count;
+      pos_q += count;
+      break;
+
+    default:
+      add_indel();
+
+      // Each mismatch is a SNP. Bases of 'M' operations are compared to find them
+      for (long k = 0; k < count; ++k, ++pos, ++pos_q)
       {
-        add_to_edit_script(); // add previous variant
-        s2.push_back(s.second[i]); // start new insertion
-      }
+        char const a = first[pos];
+        char const b = second[pos_q];
 
-      ++pos_q;
-    }
-    else if (s.second[i] == '-')
-    {
-      // Deletion
-      if (are_s1_s2_empty() || (s1.size() > 0 && s2.size() == 0))
-      {
-        s1.push_back(s.first[i]); // Extend the deletion
-      }
-      else
-      {
-        add_to_edit_script(); // add previous variant
-        s1.push_back(s.first[i]); // start new deletion
+        if (c.operation == MISMATCH || (a != b && a != 'N' && b != 'N'))
+          edit_script.insert(Event2(pos, pos_q, std::string(1, a), std::string(1, b)));
       }
 
-      ++pos;
-    }
-    else if (s.first[i] != s.second[i] && s.first[i] != 'N' && s.second[i] != 'N')
-    {
-      // Mismatch
-      if (!are_s1_s2_empty())
-        add_to_edit_script();
-
-      ++pos;
-      ++pos_q;
-      s1.push_back(s.first[i]);
-      s2.push_back(s.second[i]);
-      add_to_edit_script();
-    }
-    else
-    {
-      // Match
-      if (!are_s1_s2_empty())
-        add_to_edit_script();
-
-      ++pos;
-      ++pos_q;
+      break;
     }
   }
 
-  if (!are_s1_s2_empty() && !is_trim_indel_on_ends)
-    add_to_edit_script();
+  if (!is_trim_indel_on_ends)
+    add_indel();
 
   return edit_script;
 }
 
 
+/// \short Returns the edits of aligned strings. See the overload which takes a CIGAR.
+inline std::set<Event2>
+get_edit_script(std::pair<std::string, std::string> const & s,
+                bool const is_normalize,
+                bool const is_trim_indel_on_ends)
+{
+  assert(s.first.size() == s.second.size());
+
+  // Sequences without gaps
+  std::string first;
+  std::string second;
+  std::copy_if(s.first.begin(), s.first.end(), std::back_inserter(first), [](char c){return c != '-';});
+  std::copy_if(s.second.begin(), s.second.end(), std::back_inserter(second), [](char c){return c != '-';});
+
+  return get_edit_script(get_cigar(s), first, second, is_normalize, is_trim_indel_on_ends);
+}
+
+
 } // namespace paw
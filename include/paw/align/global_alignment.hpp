@@ -3,17 +3,26 @@
 #include <paw/align/alignment_cache.hpp>
 #include <paw/align/alignment_options.hpp>
 #include <paw/align/alignment_results.hpp>
+#include <paw/align/banded_alignment.hpp>
 #include <paw/align/libsimdpp_backtracker.hpp>
 #include <paw/align/libsimdpp_utils.hpp>
+#include <paw/align/substitution_matrix.hpp>
+#include <paw/align/wavefront_alignment.hpp>
 
 #include <simdpp/simd.h>
 
+#include <algorithm> // std::find_if, std::max_element
 #include <array> // std::array
 #include <cassert> // assert
+#include <cmath> // std::ceil
+#include <cstdlib> // std::abs
 #include <cstdint> // uint8_t, ...
 #include <iostream> // std::cerr
+#include <iterator> // std::next
 #include <limits> // std::numeric_limits
 #include <numeric>
+#include <string> // std::string
+#include <utility> // std::pair
 
 
 namespace paw
@@ -122,6 +131,32 @@ global_alignment(Tseq const & seq1,
 
 }
 
+namespace arch_popcnt_avx512bw_avx512dq_avx512vl
+{
+
+std::string get_current_arch();
+
+template <typename Tseq, typename Tuint>
+void
+global_alignment(Tseq const & seq1,
+                 Tseq const & seq2,
+                 AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_neon
+{
+
+std::string get_current_arch();
+
+template <typename Tseq, typename Tuint>
+void
+global_alignment(Tseq const & seq1,
+                 Tseq const & seq2,
+                 AlignmentOptions<Tuint> & opts);
+
+}
+
 } // namespace paw
 
 
@@ -132,213 +167,833 @@ namespace SIMDPP_ARCH_NAMESPACE
 
 template <typename Tseq, typename Tuint>
 void
-global_alignment(Tseq const & seq1, // seq1 is query
-                 Tseq const & seq2, // seq2 is database
-                 AlignmentOptions<Tuint> & opt)
+set_alignment_begin(Tseq const & seq1, Tseq const & seq2, AlignmentOptions<Tuint> & opt);
+
+template <typename Tseq, typename Tuint>
+void
+tiled_global_alignment(Tseq const & seq1, Tseq const & seq2, AlignmentOptions<Tuint> & opt);
+
+
+/// \short Returns how many rows of the backtrack matrix are kept in memory. All rows are kept unless they would use
+/// more memory than the limit in the options. Then half of the limit is used for a block of rows and the other half
+/// for the checkpoints above each block. If the limit is too small for both, the block size which uses the least
+/// memory is returned.
+template <typename Tuint>
+inline long
+get_backtrack_block_size(AlignmentOptions<Tuint> const & opt, AlignmentCache<Tuint> const & aln_cache, long const n)
 {
   using Tpack = typename T<Tuint>::pack;
-  using Tvec_pack = typename T<Tuint>::vec_pack;
-  using Tarr_uint = typename T<Tuint>::arr_uint;
 
-  AlignmentCache<Tuint> aln_cache;
-  paw::SIMDPP_ARCH_NAMESPACE::set_query<Tuint, Tseq>(opt, aln_cache, seq1);
-  paw::SIMDPP_ARCH_NAMESPACE::set_database<Tuint, Tseq>(aln_cache, seq2);
+  long const row_bytes = Backtrack<Tuint>::get_row_bytes(aln_cache.num_vectors, aln_cache.get_backtrack_bits());
 
-  assert(opt.get_alignment_results());
-  AlignmentResults<Tuint> & aln_results = *opt.get_alignment_results();
+  if (opt.backtrack_memory_limit < 0 || !opt.is_traceback() || n * row_bytes <= opt.backtrack_memory_limit)
+    return n;
 
-  long const m = aln_cache.query_size; // Local variable for the query size
-  long const t = aln_cache.num_vectors; // Keep t as a local variable is it widely used
-  long const right_v = m % t; // Vector that contains the rightmost element
-  long const right_e = m / t; // The right-most element (in vector 'right_v')
-  long const n = std::distance(seq2.begin(), seq2.end());
+  long const num_checkpoint_packs = aln_cache.is_dual_gap ? 3 : 2; // vF2_up is also stored with two gap costs
+  long const checkpoint_bytes = num_checkpoint_packs * aln_cache.num_vectors * sizeof(Tpack) +
+                                sizeof(aln_cache.reductions);
+  long const half_limit = opt.backtrack_memory_limit / 2;
+  long const block_size = std::max(1l, half_limit / row_bytes);
+  long const num_checkpoints = (n + block_size - 1) / block_size;
 
-  Tvec_pack vH(static_cast<std::size_t>(t), simdpp::make_int(
-                 2 * aln_cache.gap_open_val + std::numeric_limits<Tuint>::min()));
-  Tvec_pack vF(aln_cache.vF_up);
-  Tvec_pack vE(aln_cache.vF_up);
+  if (num_checkpoints * checkpoint_bytes <= half_limit)
+    return block_size;
 
-#ifndef NDEBUG
-  store_scores(opt, aln_cache, 0, vE);
-#endif // NDEBUG
+  // Block rows and checkpoints use the same memory when there are about sqrt(n * checkpoint_bytes / row_bytes) rows
+  long min_memory_block_size = 1;
+
+  while (min_memory_block_size * min_memory_block_size * row_bytes < n * checkpoint_bytes)
+    ++min_memory_block_size;
+
+  return std::min(n, min_memory_block_size);
+}
+
+
+/// \short Calculates row i of the score matrix from the row above it in aln_cache.vH_up and aln_cache.vF_up, which
+/// are replaced by the new row. The backtracks of the row are stored in row bt_row of the backtrack matrix.
+/// When is_dual is set, gaps with the second gap cost are also calculated, from and into aln_cache.vF2_up. The free
+/// columns of the options are only used when is_free_columns is set, and the backtracks are only stored when
+/// is_backtrack is set, so the loops over the vectors have no branches for them otherwise.
+template <bool is_dual, bool is_free_columns, bool is_backtrack, typename Tuint>
+inline void
+global_alignment_row(AlignmentOptions<Tuint> const & opt,
+                     AlignmentCache<Tuint> & aln_cache,
+                     AlignmentResults<Tuint> & aln_results,
+                     typename T<Tuint>::vec_pack const & vW, // Substitution scores of the database base of row i
+                     long const i,
+                     long const bt_row,
+                     typename T<Tuint>::vec_pack & vH,
+                     typename T<Tuint>::vec_pack & vF,
+                     typename T<Tuint>::vec_pack & vE)
+{
+  using Tpack = typename T<Tuint>::pack;
+  using Tmask = typename T<Tuint>::mask;
+  using Tarr_uint = typename T<Tuint>::arr_uint;
+  using Tvec_pack = typename T<Tuint>::vec_pack;
 
+  long const m = aln_cache.query_size;
+  long const t = aln_cache.num_vectors;
+  long const right_v = m % t;
+  long const right_e = m / t;
+  long const free_right_v = is_free_columns && opt.right_column_free ? right_v : -1; // Vector of the free right column
   Tpack const gap_open_pack_x = simdpp::make_int(opt.get_gap_open_val_x(aln_cache));
-  Tuint const gap_open_val_y = opt.get_gap_open_val_y(aln_cache); // Store once
+  Tuint const gap_open_val_y = opt.get_gap_open_val_y(aln_cache);
   Tpack const gap_open_pack_y = simdpp::make_int(gap_open_val_y);
+  Tpack const gap_open_2_pack_x = simdpp::make_int(aln_cache.gap_open_2_val_x);
+  Tpack const gap_open_2_pack_y = simdpp::make_int(aln_cache.gap_open_2_val_y);
+  Tpack const gap_extend_2_pack_x = simdpp::make_int(aln_cache.gap_extend_2_gain_x);
 
+  reduce_too_high_scores(aln_cache);
 
-  /// Start of outer loop
-  for (long i = 0; i < n; ++i)
+  // We need to increase fix vF_up if y_gain is more than gap_extend cost
+  if (i > 0 && aln_cache.y_gain > opt.get_gap_extend())
   {
-    reduce_too_high_scores(aln_cache);
-
-    // We need to increase fix vF_up if y_gain is more than gap_extend cost
-    if (i > 0 && aln_cache.y_gain > opt.get_gap_extend())
+    for (long v = 0; v < t; ++v)
     {
-      for (long v = 0; v < t; ++v)
-      {
-        aln_cache.vF_up[v] = aln_cache.vF_up[v] +
-                             static_cast<Tpack>(simdpp::make_uint(aln_cache.y_gain -
-                                                                  opt.get_gap_extend()));
-      }
+      aln_cache.vF_up[v] = aln_cache.vF_up[v] +
+                           static_cast<Tpack>(simdpp::make_uint(aln_cache.y_gain -
+                                                                opt.get_gap_extend()));
     }
+  }
 
-    // vW_i,j has the scores for each substitution between bases q[i] and d[j]
-    Tvec_pack const & vW = aln_cache.W_profile[magic_function(*std::next(seq2.begin(), i))];
+  // Insertions with the second gap cost always increase when they are extended
+  if (is_dual && i > 0)
+  {
+    Tpack const gap_extend_2_pack_y = simdpp::make_int(aln_cache.gap_extend_2_gain_y);
 
-    /// Calculate vector 0
+    for (long v = 0; v < t; ++v)
+      aln_cache.vF2_up[v] = aln_cache.vF2_up[v] + gap_extend_2_pack_y;
+  }
+
+  // Returns the best insertion of vector v. With two gap costs, the insertions with the second cost are calculated
+  // and the insertion has the second cost wherever it is higher.
+  auto get_best_insertion =
+    [&](long const v) -> Tpack
     {
-      auto const left = std::max(static_cast<Tuint>(simdpp::extract<0>(aln_cache.vF_up[0])),
-                                 static_cast<Tuint>(simdpp::extract<0>(aln_cache.vH_up[0]) -
-                                                    gap_open_val_y)
-                                 );
-
-      vH[0] = shift_one_right<Tuint>(aln_cache.vH_up[t - 1] + vW[t - 1],
-                                     left,
-                                     aln_cache.reductions);
-    }
+      if (!is_dual)
+        return vF[v];
+
+      Tpack & vF2_v = aln_cache.vF2[v];
+      vF2_v = aln_cache.vH_up[v] - gap_open_2_pack_y;
+
+      if (is_backtrack)
+        aln_cache.mB.set_ins2_extend(bt_row, v, max_greater<Tuint>(vF2_v, aln_cache.vF2_up[v]));
+      else
+        vF2_v = simdpp::max(vF2_v, aln_cache.vF2_up[v]);
+
+      Tmask const is_second = vF2_v > vF[v];
+
+      if (is_backtrack)
+        aln_cache.mB.set_ins2(bt_row, v, is_second);
+
+      return static_cast<Tpack>(simdpp::blend(vF2_v, vF[v], is_second));
+    };
 
-    // Check if any insertion have highest values
-    vF[0] = aln_cache.vH_up[0] - gap_open_pack_y;
+  /// Calculate vector 0
+  {
+    auto left = std::max(static_cast<Tuint>(simdpp::extract<0>(aln_cache.vF_up[0])),
+                         static_cast<Tuint>(simdpp::extract<0>(aln_cache.vH_up[0]) -
+                                            gap_open_val_y)
+                         );
 
-    if (opt.left_column_free)
+    if (is_dual)
     {
-      Tarr_uint vF0;
-      vF0.fill(std::numeric_limits<Tuint>::min());
-      simdpp::store_u(&vF0[0], vF[0]);
-      vF0[0] = simdpp::extract<0>(aln_cache.vH_up[0]) + aln_cache.y_gain;
-      vF[0] = simdpp::load(&vF0[0]);
+      left = std::max({left,
+                       static_cast<Tuint>(simdpp::extract<0>(aln_cache.vF2_up[0])),
+                       static_cast<Tuint>(simdpp::extract<0>(aln_cache.vH_up[0]) - aln_cache.gap_open_2_val_y)});
     }
 
+    // A tile of the score matrix which is not at its left side gets column 0 from the tile to its left. Its scores
+    // have no diagonal above them in the tile, so they may be lower than the lowest score of the rows above.
+    if (aln_cache.is_left_boundary)
+      left = aln_cache.get_left_boundary_val(aln_cache.left_boundary_H, 0);
+
+    vH[0] = shift_one_right<Tuint>(aln_cache.vH_up[t - 1] + vW[t - 1],
+                                   left,
+                                   aln_cache.reduction_delta_add,
+                                   aln_cache.reduction_delta_sub,
+                                   aln_cache.left_mask);
+  }
+
+  // Check if any insertion have highest values
+  vF[0] = aln_cache.vH_up[0] - gap_open_pack_y;
+
+  if (is_free_columns && opt.left_column_free)
+  {
+    Tarr_uint vF0;
+    vF0.fill(std::numeric_limits<Tuint>::min());
+    simdpp::store_u(&vF0[0], vF[0]);
+    vF0[0] = simdpp::extract<0>(aln_cache.vH_up[0]) + aln_cache.y_gain;
+    vF[0] = simdpp::load(&vF0[0]);
+  }
+
+  // In case right_v is 0
+  if (is_free_columns && free_right_v == 0)
+  {
+    Tarr_uint vH_up_0;
+    vH_up_0.fill(std::numeric_limits<Tuint>::min());
+    simdpp::store_u(&vH_up_0[0], aln_cache.vH_up[0]);
+
+    Tarr_uint vF0;
+    vF0.fill(std::numeric_limits<Tuint>::min());
+    simdpp::store_u(&vF0[0], vF[0]);
+
+    vF0[right_e] = vH_up_0[right_e] + aln_cache.y_gain;
+    vF[0] = simdpp::load(&vF0[0]);
+  }
+
+  if (is_backtrack)
+  {
+    aln_cache.mB.set_ins_extend(bt_row, 0, max_greater<Tuint>(vF[0], aln_cache.vF_up[0]));
+    aln_cache.mB.set_ins(bt_row, 0, max_greater<Tuint>(vH[0], get_best_insertion(0)));
+  }
+  else
+  {
+    vF[0] = simdpp::max(vF[0], aln_cache.vF_up[0]);
+    vH[0] = simdpp::max(vH[0], get_best_insertion(0));
+  }
+  /// Done calculating vector 0
+
+  /// Calculate vectors v=1,...,t-1
+  for (long v = 1; v < t; ++v)
+  {
+    // Check for substitutions and if it has a higher score than the insertion
+    vH[v] = aln_cache.vH_up[v - 1] + vW[v - 1];
+    vF[v] = aln_cache.vH_up[v] - gap_open_pack_y;
+
     // In case right_v is 0
-    if (opt.right_column_free && right_v == 0)
+    if (is_free_columns && free_right_v == v)
     {
-      Tarr_uint vH_up_0;
-      vH_up_0.fill(std::numeric_limits<Tuint>::min());
-      simdpp::store_u(&vH_up_0[0], aln_cache.vH_up[0]);
+      Tarr_uint vH_up_v;
+      vH_up_v.fill(std::numeric_limits<Tuint>::min());
+      simdpp::store_u(&vH_up_v[0], aln_cache.vH_up[v]);
 
       Tarr_uint vF0;
       vF0.fill(std::numeric_limits<Tuint>::min());
-      simdpp::store_u(&vF0[0], vF[0]);
+      simdpp::store_u(&vF0[0], vF[v]);
 
-      vF0[right_e] = vH_up_0[right_e] + aln_cache.y_gain;
-      vF[0] = simdpp::load(&vF0[0]);
+      vF0[right_e] = vH_up_v[right_e] + aln_cache.y_gain;
+      vF[v] = simdpp::load(&vF0[0]);
     }
 
-    aln_cache.mB.set_ins_extend(i, 0, max_greater<Tuint>(vF[0], aln_cache.vF_up[0]));
-    aln_cache.mB.set_ins(i, 0, max_greater<Tuint>(vH[0], vF[0]));
-    /// Done calculating vector 0
+    if (is_backtrack)
+    {
+      aln_cache.mB.set_ins_extend(bt_row, v, max_greater<Tuint>(vF[v], aln_cache.vF_up[v]));
+      aln_cache.mB.set_ins(bt_row, v, max_greater<Tuint>(vH[v], get_best_insertion(v)));
+    }
+    else
+    {
+      vF[v] = simdpp::max(vF[v], aln_cache.vF_up[v]);
+      vH[v] = simdpp::max(vH[v], get_best_insertion(v));
+    }
+  } /// Done calculating vectors v=1,...,t-1
+
+  {
+    /// Deletions within each element
+    vE[0] = shift_one_right<Tuint>(vH[t - 1] - gap_open_pack_x,
+                                   aln_cache.is_left_boundary ?
+                                   aln_cache.get_left_boundary_val(aln_cache.left_boundary_E, 0) :
+                                   std::numeric_limits<Tuint>::min(),
+                                   aln_cache.reduction_delta_add,
+                                   aln_cache.reduction_delta_sub,
+                                   aln_cache.left_mask);
 
-    /// Calculate vectors v=1,...,t-1
     for (long v = 1; v < t; ++v)
     {
-      // Check for substitutions and if it has a higher score than the insertion
-      vH[v] = aln_cache.vH_up[v - 1] + vW[v - 1];
-      vF[v] = aln_cache.vH_up[v] - gap_open_pack_y;
+      vE[v] = vH[v - 1] - gap_open_pack_x;
+
+      if (is_backtrack)
+        aln_cache.mB.set_del_extend(bt_row, v, max_greater<Tuint>(vE[v], vE[v - 1]));
+      else
+        vE[v] = simdpp::max(vE[v], vE[v - 1]);
+    }
+    /// Done with deletions within each element
+
+    /// Deletions crossing elements
+    // Extending a deletion does not change its stored value, so the best deletion entering each element is the
+    // running maximum over the last vectors of all elements to its left, which is found with a single scan over
+    // the elements. Deletion scores are non-decreasing within each element, so the carried deletions are applied
+    // vector by vector until they no longer improve any element.
+    {
+      Tpack const vE_carry = shift_one_right_carry<Tuint>(vE[t - 1],
+                                                          std::numeric_limits<Tuint>::min(),
+                                                          aln_cache.reductions);
 
-      // In case right_v is 0
-      if (opt.right_column_free && right_v == v)
+      for (long v = 0; v < t; ++v)
       {
-        Tarr_uint vH_up_v;
-        vH_up_v.fill(std::numeric_limits<Tuint>::min());
-        simdpp::store_u(&vH_up_v[0], aln_cache.vH_up[v]);
+        Tmask const is_improved = vE_carry > vE[v];
 
-        Tarr_uint vF0;
-        vF0.fill(std::numeric_limits<Tuint>::min());
-        simdpp::store_u(&vF0[0], vF[v]);
+        if (!simdpp::test_bits_any(static_cast<Tpack>(simdpp::bit_cast<Tpack>(is_improved))))
+          break;
 
-        vF0[right_e] = vH_up_v[right_e] + aln_cache.y_gain;
-        vF[v] = simdpp::load(&vF0[0]);
-      }
+        vE[v] = simdpp::max(vE[v], vE_carry);
+
+        if (is_backtrack)
+          aln_cache.mB.set_del_extend(bt_row, v, is_improved);
 
-      aln_cache.mB.set_ins_extend(i, v, max_greater<Tuint>(vF[v], aln_cache.vF_up[v]));
-      aln_cache.mB.set_ins(i, v, max_greater<Tuint>(vH[v], vF[v]));
-    } /// Done calculating vectors v=1,...,t-1
+        ++aln_results.num_lazy_e_vectors;
 
+        if (v == 0)
+          ++aln_results.num_lazy_e_rows;
+      }
+    }
+    /// Done with deletions crossing elements
+
+    if (is_dual)
     {
-      /// Deletions pass 1
-      vE[0] = shift_one_right<Tuint>(vH[t - 1] - gap_open_pack_x,
-                                     std::numeric_limits<Tuint>::min(), aln_cache.reductions);
+      /// Deletions with the second gap cost, which increase by gap_extend_2_gain_x for each column they are extended
+      Tvec_pack & vE2 = aln_cache.vE2;
+      vE2[0] = shift_one_right<Tuint>(vH[t - 1] - gap_open_2_pack_x,
+                                      aln_cache.is_left_boundary ?
+                                      aln_cache.get_left_boundary_val(aln_cache.left_boundary_E2, 0) :
+                                      std::numeric_limits<Tuint>::min(),
+                                      aln_cache.reduction_delta_add,
+                                      aln_cache.reduction_delta_sub,
+                                      aln_cache.left_mask);
 
       for (long v = 1; v < t; ++v)
       {
-        vE[v] = vH[v - 1] - gap_open_pack_x;
-        aln_cache.mB.set_del_extend(i, v, max_greater<Tuint>(vE[v], vE[v - 1]));
-      }
+        vE2[v] = vH[v - 1] - gap_open_2_pack_x;
 
-      Tarr_uint vE0r;
-      vE0r.fill(std::numeric_limits<Tuint>::min());
-      Tarr_uint vE0;
-      vE0.fill(std::numeric_limits<Tuint>::min());
-      simdpp::store_u(&vE0[0], vE[0]);
+        if (is_backtrack)
+          aln_cache.mB.set_del2_extend(bt_row, v, max_greater<Tuint>(vE2[v], static_cast<Tpack>(vE2[v - 1] + gap_extend_2_pack_x)));
+        else
+          vE2[v] = simdpp::max(vE2[v], static_cast<Tpack>(vE2[v - 1] + gap_extend_2_pack_x));
+      }
 
-      // Check for deletions in vector 0
-      Tpack vE0r_pack = shift_one_right<Tuint>(vE[t - 1],
-                                               std::numeric_limits<Tuint>::min(),
-                                               aln_cache.reductions);
-      simdpp::store_u(&vE0r[0], vE0r_pack);
-      bool is_improved = false;
+      // The deletion carried into an element is the best of the last vector of the element to its left and the
+      // deletion carried into that element, extended over the whole element
+      Tpack vE2_carry = shift_one_right_carry_gain<Tuint>(vE2[t - 1],
+                                                          std::numeric_limits<Tuint>::min(),
+                                                          aln_cache.reductions,
+                                                          aln_cache.gap_extend_2_gain_x,
+                                                          t);
 
-      for (long e = 1; e < static_cast<long>(vE0r.size()); ++e)
+      for (long v = 0; v < t; ++v)
       {
-        long val = static_cast<long>(vE0r[e - 1]) + aln_cache.reductions[e - 1] -
-                   aln_cache.reductions[e];
+        Tmask const is_improved = vE2_carry > vE2[v];
+
+        if (!simdpp::test_bits_any(static_cast<Tpack>(simdpp::bit_cast<Tpack>(is_improved))))
+          break;
+
+        vE2[v] = simdpp::max(vE2[v], vE2_carry);
 
-        if (val > static_cast<long>(vE0r[e]))
-          vE0r[e] = val;
+        if (is_backtrack)
+          aln_cache.mB.set_del2_extend(bt_row, v, is_improved);
 
-        if (vE0r[e] > vE0[e])
+        vE2_carry = vE2_carry + gap_extend_2_pack_x;
+      }
+
+      for (long v = 0; v < t; ++v)
+      {
+        if (is_backtrack)
         {
-          vE0[e] = vE0r[e];
-          is_improved = true;
+          Tmask const is_second = vE2[v] > vE[v];
+          aln_cache.mB.set_del2(bt_row, v, is_second);
+          aln_cache.mB.set_del(bt_row, v, max_greater<Tuint>(vH[v], static_cast<Tpack>(simdpp::blend(vE2[v], vE[v], is_second))));
         }
         else
         {
-          vE0r[e] = vE0[e];
+          vH[v] = simdpp::max(vH[v], static_cast<Tpack>(simdpp::max(vE2[v], vE[v])));
         }
       }
+      /// Done with deletions with the second gap cost
+    }
+    else
+    {
+      for (long v = 0; v < t; ++v)
+      {
+        if (is_backtrack)
+          aln_cache.mB.set_del(bt_row, v, max_greater<Tuint>(vH[v], vE[v]));
+        else
+          vH[v] = simdpp::max(vH[v], vE[v]);
+      }
+    }
+  }
 
-      if (is_improved)
-        aln_cache.mB.set_del_extend(i, 0, max_greater<Tuint>(vE[0], simdpp::load_u(&vE0r[0])));
+  std::swap(vF, aln_cache.vF_up);
+  std::swap(vH, aln_cache.vH_up);
 
-      aln_cache.mB.set_del(i, 0, max_greater<Tuint>(vH[0], vE[0]));
-      /// Done with deletion pass 1
+  if (is_dual)
+    std::swap(aln_cache.vF2, aln_cache.vF2_up);
+}
+
+
+/// \short Function which calculates a row of the score matrix, see global_alignment_row
+template <typename Tuint>
+using GlobalAlignmentRow = void (*)(AlignmentOptions<Tuint> const &,
+                                    AlignmentCache<Tuint> &,
+                                    AlignmentResults<Tuint> &,
+                                    typename T<Tuint>::vec_pack const &,
+                                    long,
+                                    long,
+                                    typename T<Tuint>::vec_pack &,
+                                    typename T<Tuint>::vec_pack &,
+                                    typename T<Tuint>::vec_pack &);
+
+
+/// \short Returns the instantiation of global_alignment_row for the flags. It is chosen once for each alignment, so
+/// the rows do not check the options.
+template <typename Tuint>
+inline GlobalAlignmentRow<Tuint>
+get_global_alignment_row(bool const is_dual, bool const is_free_columns, bool const is_backtrack)
+{
+  static GlobalAlignmentRow<Tuint> const rows[8] = {
+    &global_alignment_row<false, false, false, Tuint>,
+    &global_alignment_row<false, false, true, Tuint>,
+    &global_alignment_row<false, true, false, Tuint>,
+    &global_alignment_row<false, true, true, Tuint>,
+    &global_alignment_row<true, false, false, Tuint>,
+    &global_alignment_row<true, false, true, Tuint>,
+    &global_alignment_row<true, true, false, Tuint>,
+    &global_alignment_row<true, true, true, Tuint>
+  };
+
+  return rows[4 * is_dual + 2 * is_free_columns + is_backtrack];
+}
 
-      /// Deletions pass 2
-      if (is_improved)
+
+/// \short Aligns the query (seq1) globally to the database (seq2). When continuous_alignment is set and the previous
+/// alignment with the options had the same query, the alignment continues from its last row, so a database can be
+/// aligned in segments. The score and the database positions are then those of all segments so far. Banded
+/// alignments are never continued. When num_threads is more than one, alignments which are not continued or
+/// checkpointed are computed in tiles, see tiled_global_alignment. When wfa_max_divergence is set, similar sequences
+/// are aligned with wavefront_alignment.
+template <typename Tseq, typename Tuint>
+void
+global_alignment(Tseq const & seq1, // seq1 is query
+                 Tseq const & seq2, // seq2 is database
+                 AlignmentOptions<Tuint> & opt)
+{
+  using Tvec_pack = typename T<Tuint>::vec_pack;
+  using Tarr_uint = typename T<Tuint>::arr_uint;
+
+  opt.get_alignment_results()->is_dropped = false;
+
+  if (opt.band_width >= 0)
+  {
+    opt.get_alignment_results()->last_row.num_rows = 0; // There is no row to continue from
+    banded_global_alignment<Tseq, Tuint>(seq1, seq2, opt);
+    paw::SIMDPP_ARCH_NAMESPACE::set_alignment_begin(seq1, seq2, opt);
+    return;
+  }
+
+  // Similar sequences are aligned in time proportional to the alignment penalty. The wavefront alignment gives up
+  // when the sequences turn out to be more divergent than allowed.
+  if (opt.wfa_max_divergence > 0.0)
+  {
+    long const max_size = std::max(std::distance(seq1.begin(), seq1.end()), std::distance(seq2.begin(), seq2.end()));
+    long const max_edits = static_cast<long>(std::ceil(opt.wfa_max_divergence * max_size));
+
+    if (paw::SIMDPP_ARCH_NAMESPACE::wavefront_alignment(seq1, seq2, opt, max_edits))
+      return;
+  }
+
+  // With multiple threads the score matrix is split into tiles which are computed in parallel
+  if (opt.num_threads > 1 && !opt.continuous_alignment && opt.backtrack_memory_limit < 0 && opt.x_drop < 0 &&
+      opt.z_drop < 0 && seq1.begin() != seq1.end() && seq2.begin() != seq2.end())
+  {
+    paw::SIMDPP_ARCH_NAMESPACE::tiled_global_alignment(seq1, seq2, opt);
+    paw::SIMDPP_ARCH_NAMESPACE::set_alignment_begin(seq1, seq2, opt);
+    return;
+  }
+
+  // The cache of the thread is reused, so its buffers are only allocated when longer sequences are aligned
+  AlignmentCache<Tuint> & aln_cache = get_thread_alignment_cache<Tuint>();
+  paw::SIMDPP_ARCH_NAMESPACE::set_query<Tuint, Tseq>(opt, aln_cache, seq1);
+
+  long const m = aln_cache.query_size; // Local variable for the query size
+  long const t = aln_cache.num_vectors; // Keep t as a local variable is it widely used
+  long const right_v = m % t; // Vector that contains the rightmost element
+  long const right_e = m / t; // The right-most element (in vector 'right_v')
+  SubstitutionMatrix const * const matrix = opt.get_substitution_matrix();
+
+  // The database is encoded once, so the rows read its codes instead of its characters
+  std::vector<uint8_t> & database_codes = aln_cache.database_codes;
+  paw::SIMDPP_ARCH_NAMESPACE::set_database_codes(database_codes, seq2, matrix);
+  long const n = database_codes.size();
+
+  // Number of rows of the backtrack matrix which are kept in memory
+  long const block_size = get_backtrack_block_size(opt, aln_cache, n);
+  bool const is_checkpointed = block_size < n;
+  bool const is_free_columns = opt.left_column_free || opt.right_column_free;
+
+  // Backtracks are only stored when the alignment is traced back
+  paw::SIMDPP_ARCH_NAMESPACE::set_database<Tuint, Tseq>(aln_cache, seq2, opt.is_traceback() ? block_size : 0);
+
+  // Rows above each block of the backtrack matrix, stored when only one block is kept in memory
+  Tvec_pack & checkpoint_packs = aln_cache.checkpoint_packs;
+  std::vector<std::array<long, S / sizeof(Tuint)> > & checkpoint_reductions = aln_cache.checkpoint_reductions;
+  checkpoint_packs.clear();
+  checkpoint_reductions.clear();
+
+  assert(opt.get_alignment_results());
+  AlignmentResults<Tuint> & aln_results = *opt.get_alignment_results();
+  aln_results.num_lazy_e_rows = 0;
+  aln_results.num_lazy_e_vectors = 0;
+
+  // A continuous alignment continues from the last row of the previous alignment if it had the same query
+  AlignmentRow & last_row = aln_results.last_row;
+  bool const is_continued = opt.continuous_alignment &&
+                            last_row.num_rows > 0 &&
+                            last_row.query == aln_cache.query &&
+                            aln_cache.is_dual_gap == !last_row.insertion_scores_2.empty();
+
+  if (is_continued)
+    paw::SIMDPP_ARCH_NAMESPACE::set_rows_up(aln_cache, last_row);
+
+  long const rows_before = is_continued ? last_row.num_rows : 0; // Database bases aligned before seq2
+
+  Tvec_pack & vH = aln_cache.vH;
+  Tvec_pack & vF = aln_cache.vF;
+  Tvec_pack & vE = aln_cache.vE;
+  vH.assign(static_cast<std::size_t>(t), simdpp::make_int(
+              2 * aln_cache.gap_open_val + std::numeric_limits<Tuint>::min()));
+  vF.assign(aln_cache.vF_up.begin(), aln_cache.vF_up.end());
+  vE.assign(aln_cache.vF_up.begin(), aln_cache.vF_up.end());
+
+  if (aln_cache.is_dual_gap)
+  {
+    aln_cache.vF2.assign(aln_cache.vF2_up.begin(), aln_cache.vF2_up.end());
+    aln_cache.vE2.assign(aln_cache.vF2_up.begin(), aln_cache.vF2_up.end());
+  }
+
+#ifndef NDEBUG
+  store_scores(opt, aln_cache, 0, vE);
+#endif // NDEBUG
+
+  // Best score in the right column and its row, only used when the right column is free
+  long right_column_best_score = std::numeric_limits<long>::min();
+  long right_column_best_row = 0;
+
+  auto update_right_column_best =
+    [&](long const i)
+    {
+      Tarr_uint vH_right;
+      simdpp::store_u(&vH_right[0], aln_cache.vH_up[right_v]);
+      long const score = static_cast<long>(vH_right[right_e]) + aln_cache.reductions[right_e] -
+                         aln_cache.x_gain * m - aln_cache.y_gain * i;
+
+      if (score > right_column_best_score)
       {
-        for (long v = 1; v < t; ++v)
-          aln_cache.mB.set_del_extend(i, v, max_greater<Tuint>(vE[v], vE[v - 1]));
+        right_column_best_score = score;
+        right_column_best_row = i;
       }
+    };
 
-      for (long v = 1; v < t; ++v)
-        aln_cache.mB.set_del(i, v, max_greater<Tuint>(vH[v], vE[v]));
-      /// Done with deletion pass 2
+  if (is_continued)
+  {
+    right_column_best_score = last_row.right_column_best_score;
+    right_column_best_row = last_row.right_column_best_row - rows_before;
+  }
+  else if (opt.right_column_free)
+  {
+    update_right_column_best(0);
+  }
+
+  // The best score so far and its cell, used by the X-drop and Z-drop. Continued alignments are never dropped.
+  bool const is_drop = (opt.x_drop >= 0 || opt.z_drop >= 0) && !opt.continuous_alignment;
+  long best_score = 0;
+  long best_row = 0;
+  long best_column = 0;
+  bool is_best_column_known = true;
+
+  // Finds the right-most column of the best score in the stored row with the best score
+  auto find_best_column =
+    [&]()
+    {
+      if (is_best_column_known)
+        return;
+
+      for (long v = 0; v < t; ++v)
+      {
+        Tarr_uint vec;
+        simdpp::store_u(&vec[0], aln_cache.vH_best[v]);
+
+        for (long e = 0, j = v; j <= m; j += t, ++e)
+        {
+          long const score = static_cast<long>(vec[e]) + aln_cache.best_reductions[e] -
+                             aln_cache.y_gain * best_row - aln_cache.x_gain * j;
+
+          if (score == best_score && (!is_best_column_known || j > best_column))
+          {
+            best_column = j;
+            is_best_column_known = true;
+          }
+        }
+      }
+
+      assert(is_best_column_known);
+    };
+
+  // Checks if the alignment should stop after row i, which is in vH_up
+  auto is_dropped =
+    [&](long const i) -> bool
+    {
+      long const row_max_score = get_row_max_score(aln_cache, i, aln_cache.vH_up);
+
+      if (row_max_score > best_score)
+      {
+        best_score = row_max_score;
+        best_row = i;
+        is_best_column_known = false;
+        aln_cache.vH_best.assign(aln_cache.vH_up.begin(), aln_cache.vH_up.end());
+        aln_cache.best_reductions = aln_cache.reductions;
+        return false;
+      }
+
+      if (opt.x_drop >= 0 && row_max_score < best_score - opt.x_drop)
+        return true;
+
+      if (opt.z_drop < 0 || row_max_score >= best_score - opt.z_drop)
+        return false;
+
+      // Cells on other diagonals than the best cell may be further below it, by the cost of extending a gap
+      find_best_column();
+      std::vector<long> & scores_row = aln_cache.score_row;
+      get_score_row(aln_cache, i, aln_cache.vH_up, scores_row);
+
+      for (long j = 0; j <= m; ++j)
+      {
+        long const diagonal_diff = std::abs((i - best_row) - (j - best_column));
+
+        if (scores_row[j] >= best_score - opt.z_drop - opt.get_gap_extend() * diagonal_diff)
+          return false;
+      }
+
+      return true;
+    };
+
+  long num_rows = n; // Number of rows computed, which is less than n if the alignment is dropped
+
+  GlobalAlignmentRow<Tuint> const alignment_row = get_global_alignment_row<Tuint>(aln_cache.is_dual_gap,
+                                                                                  is_free_columns,
+                                                                                  opt.is_traceback());
+
+  // Calculates row i of the score matrix and stores its backtracks in row bt_row
+  auto compute_row =
+    [&](AlignmentResults<Tuint> & results, long const i, long const bt_row)
+    {
+      // vW_i,j has the scores for each substitution between bases q[i] and d[j]
+      Tvec_pack const & vW = aln_cache.W_profile[database_codes[i]];
+
+      // The row is numbered in the whole database, so a continued alignment extends the insertions above it
+      alignment_row(opt, aln_cache, results, vW, rows_before + i, bt_row, vH, vF, vE);
+    };
+
+
+  /// Start of outer loop
+  for (long i = 0; i < n; ++i)
+  {
+    if (is_checkpointed)
+    {
+      if (i % block_size == 0)
+      {
+        checkpoint_packs.insert(checkpoint_packs.end(), aln_cache.vH_up.begin(), aln_cache.vH_up.end());
+        checkpoint_packs.insert(checkpoint_packs.end(), aln_cache.vF_up.begin(), aln_cache.vF_up.end());
+
+        if (aln_cache.is_dual_gap)
+          checkpoint_packs.insert(checkpoint_packs.end(), aln_cache.vF2_up.begin(), aln_cache.vF2_up.end());
+
+        checkpoint_reductions.push_back(aln_cache.reductions);
+      }
+
+      aln_cache.mB.clear_row(i % block_size);
     }
 
-    std::swap(vF, aln_cache.vF_up);
-    std::swap(vH, aln_cache.vH_up);
+    compute_row(aln_results, i, i % block_size);
+
+    if (opt.right_column_free)
+      update_right_column_best(i + 1);
 
   #ifndef NDEBUG
     store_scores(opt, aln_cache, i + 1l, vE);
   #endif
+
+    if (is_drop && i + 1 < n && is_dropped(i + 1))
+    {
+      num_rows = i + 1;
+      break;
+    }
   } /// End of outer loop
 
-  std::vector<Tuint> arr(S / sizeof(Tuint));
+  Tarr_uint arr;
   simdpp::store_u(&arr[0], aln_cache.vH_up[m % t]);
   aln_results.query_end = m;
   aln_results.database_end = n;
-  aln_cache.reduce_every_element(-n * aln_cache.y_gain);
+  aln_cache.reduce_every_element(-num_rows * aln_cache.y_gain);
   aln_results.score = static_cast<long>(arr[m / t])
                       + static_cast<long>(aln_cache.reductions[m / t])
                       - m * aln_cache.x_gain;
 
+  if (opt.bottom_row_free)
+  {
+    // Select the right-most column with the highest score in the last row
+    std::vector<long> & scores_row = aln_cache.score_row;
+    get_score_row(aln_cache, 0 /*y gain already reduced*/, aln_cache.vH_up, scores_row);
+    auto max_it = std::max_element(scores_row.rbegin(), scores_row.rend());
+    aln_results.score = *max_it;
+    aln_results.query_end = std::distance(max_it, scores_row.rend()) - 1;
+  }
+
+  if (opt.right_column_free && aln_results.query_end == m)
+    aln_results.database_end = right_column_best_row;
+
+  // A dropped alignment ends at the cell with the best score
+  if (num_rows < n)
+  {
+    find_best_column();
+    aln_results.is_dropped = true;
+    aln_results.score = best_score;
+    aln_results.query_end = best_column;
+    aln_results.database_end = best_row;
+  }
+
+  if (opt.continuous_alignment)
+  {
+    // The rows are stored before the traceback, which may recompute rows of the cache
+    if (!is_continued)
+      last_row.query = aln_cache.query;
+
+    last_row.num_rows = rows_before + n;
+    get_score_row(aln_cache, 0, aln_cache.vH_up, last_row.scores);
+    get_score_row(aln_cache, 0, aln_cache.vF_up, last_row.insertion_scores);
+
+    if (aln_cache.is_dual_gap)
+      get_score_row(aln_cache, 0, aln_cache.vF2_up, last_row.insertion_scores_2);
+    else
+      last_row.insertion_scores_2.clear();
+
+    last_row.right_column_best_score = right_column_best_score;
+    last_row.right_column_best_row = rows_before + right_column_best_row;
+  }
+
+  // Rows of previous segments are not stored, so a continued alignment which ends in them is not traced back
+  bool const is_traceback = opt.is_traceback() && aln_results.database_end >= 0;
+
+  if (is_traceback && is_checkpointed)
+  {
+    // The rows of the last block are still in the backtrack matrix, other blocks are recomputed from the rows
+    // above them, which changes the cache but not the results
+    AlignmentResults<Tuint> block_results;
+
+    auto compute_block =
+      [&](long const block_begin)
+      {
+        long const c = block_begin / block_size;
+        long const num_packs = aln_cache.is_dual_gap ? 3 : 2; // Rows of packs in each checkpoint
+        auto const checkpoint_begin = checkpoint_packs.begin() + num_packs * c * t;
+        std::copy(checkpoint_begin, checkpoint_begin + t, aln_cache.vH_up.begin());
+        std::copy(checkpoint_begin + t, checkpoint_begin + 2 * t, aln_cache.vF_up.begin());
+
+        if (aln_cache.is_dual_gap)
+          std::copy(checkpoint_begin + 2 * t, checkpoint_begin + 3 * t, aln_cache.vF2_up.begin());
+
+        aln_cache.reductions = checkpoint_reductions[c];
+        aln_cache.update_reduction_deltas();
+
+        for (long i = block_begin; i < std::min(n, block_begin + block_size); ++i)
+        {
+          aln_cache.mB.clear_row(i - block_begin);
+          compute_row(block_results, i, i - block_begin);
+        }
+      };
+
+    CheckpointedBacktrack<Tuint, decltype(compute_block)> const mB(aln_cache.mB,
+                                                                  block_size,
+                                                                  compute_block,
+                                                                  (num_rows - 1) / block_size * block_size);
+    aln_results.traceback(mB, seq1, seq2, opt.get_aligned_strings);
+  }
+  else if (is_traceback)
+  {
+    aln_results.traceback(aln_cache.mB, seq1, seq2, opt.get_aligned_strings);
+  }
+
+  if (!is_continued)
+  {
+    paw::SIMDPP_ARCH_NAMESPACE::set_alignment_begin(seq1, seq2, opt);
+    return;
+  }
+
+  // A continued alignment is only traced back in the rows of seq2. It enters them from the last row of the previous
+  // segment, at the query position of the deletion which the traceback adds at the beginning of the CIGAR.
+  aln_results.query_begin = 0;
+  aln_results.database_begin = rows_before;
+  aln_results.database_end += rows_before;
+  std::vector<Cigar> & cigar = aln_results.cigar;
+
+  if (!is_traceback)
+  {
+    cigar.clear();
+    return;
+  }
+
+  if (!cigar.empty() && cigar.front().operation == DELETION)
+  {
+    aln_results.query_begin = cigar.front().count;
+    cigar.erase(cigar.begin());
+  }
+
   if (opt.get_aligned_strings)
   {
-    aln_results.get_aligned_strings(aln_cache, seq1, seq2);
+    get_aligned_strings(cigar,
+                        Tseq(std::next(seq1.begin(), aln_results.query_begin), seq1.end()),
+                        seq2,
+                        *aln_results.aligned_strings_ptr);
   }
 }
 
 
+/// \short Sets where the alignment begins in both sequences. The begin is only unknown when the left column or top
+/// row are free. In that case it is found from the CIGAR, or if the alignment was not traced back, by aligning the
+/// reversed sequences from the end of the alignment.
+template <typename Tseq, typename Tuint>
+void
+set_alignment_begin(Tseq const & seq1, Tseq const & seq2, AlignmentOptions<Tuint> & opt)
+{
+  AlignmentResults<Tuint> & aln_results = *opt.get_alignment_results();
+  aln_results.query_begin = 0;
+  aln_results.database_begin = 0;
+
+  if (!opt.left_column_free && !opt.top_row_free)
+    return;
+
+  if (opt.is_traceback())
+  {
+    // Skipped bases are at the beginning of the CIGAR
+    std::vector<Cigar> const & cigar = aln_results.cigar;
+
+    if (opt.left_column_free && !cigar.empty() && cigar.front().operation == INSERTION)
+      aln_results.database_begin = cigar.front().count;
+
+    if (opt.top_row_free && !cigar.empty() && cigar.front().operation == DELETION)
+      aln_results.query_begin = cigar.front().count;
+
+    return;
+  }
+
+  long const m = std::distance(begin(seq1), end(seq1));
+  long const n = std::distance(begin(seq2), end(seq2));
+  Tseq const rev_seq1(seq1.rbegin() + (m - aln_results.query_end), seq1.rend());
+  Tseq const rev_seq2(seq2.rbegin() + (n - aln_results.database_end), seq2.rend());
+
+  AlignmentOptions<Tuint> rev_opt(opt);
+  rev_opt.continuous_alignment = false;
+  rev_opt.x_drop = -1;
+  rev_opt.z_drop = -1;
+  rev_opt.left_column_free = false;
+  rev_opt.top_row_free = false;
+  rev_opt.right_column_free = opt.left_column_free;
+  rev_opt.bottom_row_free = opt.top_row_free;
+  paw::SIMDPP_ARCH_NAMESPACE::global_alignment(rev_seq1, rev_seq2, rev_opt);
+
+  AlignmentResults<Tuint> const & rev_results = *rev_opt.get_alignment_results();
+  assert(rev_results.score == aln_results.score);
+  aln_results.query_begin = aln_results.query_end - rev_results.query_end;
+  aln_results.database_begin = aln_results.database_end - rev_results.database_end;
+}
+
+
 } // namespace SIMDPP_ARCH_NAMESPACE
 } // namespace paw
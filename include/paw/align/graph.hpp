@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cassert> // assert
+#include <cstdlib> // std::exit
+#include <iostream> // std::cerr
+#include <string> // std::string
+#include <utility> // std::move
+#include <vector> // std::vector
+
+
+namespace paw
+{
+
+/// \short A directed acyclic graph of sequences, e.g. a reference with the alleles of variants as alternative
+/// vertices. Each path from a vertex without inbound edges to a vertex without outbound edges spells a sequence.
+/// Vertices can only be added, and the ID of a vertex is the order it was added in.
+class Graph
+{
+private:
+  std::vector<std::string> vertices; // Sequence of each vertex
+  std::vector<std::vector<long> > inbound_edges; // Vertices with an edge to each vertex
+  std::vector<std::vector<long> > outbound_edges; // Vertices with an edge from each vertex
+
+public:
+  /// \short Adds a vertex and returns its ID. The sequence may be empty, e.g. for the allele of a deletion.
+  inline long add_vertex(std::string seq);
+
+  inline void add_edge(long from, long to);
+
+  inline long
+  size() const {return static_cast<long>(vertices.size());}
+
+  inline std::vector<std::string> const &
+  get_vertices() const {return vertices;}
+
+  inline std::string const &
+  get_sequence(long const index) const {return vertices[index];}
+
+  inline std::vector<long> const &
+  get_indexes_inbound(long const index) const {return inbound_edges[index];}
+
+  inline std::vector<long> const &
+  get_indexes_outbound(long const index) const {return outbound_edges[index];}
+
+  /// \short Returns the vertices in an order where every vertex comes after all vertices with an edge to it
+  inline std::vector<long> get_topological_order() const;
+
+  /// \short Returns the sequence spelled by a path of vertices
+  inline std::string get_path_sequence(std::vector<long> const & path) const;
+
+};
+
+
+inline long
+Graph::add_vertex(std::string seq)
+{
+  vertices.push_back(std::move(seq));
+  inbound_edges.emplace_back();
+  outbound_edges.emplace_back();
+  return static_cast<long>(vertices.size()) - 1;
+}
+
+
+inline void
+Graph::add_edge(long const from, long const to)
+{
+  assert(from >= 0 && from < size());
+  assert(to >= 0 && to < size());
+  outbound_edges[from].push_back(to);
+  inbound_edges[to].push_back(from);
+}
+
+
+inline std::vector<long>
+Graph::get_topological_order() const
+{
+  std::vector<long> order;
+  std::vector<long> num_inbound(vertices.size());
+  order.reserve(vertices.size());
+
+  for (long v = 0; v < size(); ++v)
+  {
+    num_inbound[v] = inbound_edges[v].size();
+
+    if (num_inbound[v] == 0)
+      order.push_back(v);
+  }
+
+  // Vertices are added to the order when all vertices with an edge to them are in it
+  for (long k = 0; k < static_cast<long>(order.size()); ++k)
+  {
+    for (long const to : outbound_edges[order[k]])
+    {
+      if (--num_inbound[to] == 0)
+        order.push_back(to);
+    }
+  }
+
+  if (order.size() != vertices.size())
+  {
+    std::cerr << "ERROR: The graph has a cycle, so its vertices have no topological order." << std::endl;
+    std::exit(1);
+  }
+
+  return order;
+}
+
+
+inline std::string
+Graph::get_path_sequence(std::vector<long> const & path) const
+{
+  std::string seq;
+
+  for (long const v : path)
+    seq += vertices[v];
+
+  return seq;
+}
+
+
+} // namespace paw
@@ -0,0 +1,493 @@
+#pragma once
+
+#include <paw/align/alignment_cache.hpp>
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/global_alignment.hpp>
+#include <paw/align/graph.hpp>
+#include <paw/align/libsimdpp_utils.hpp>
+#include <paw/align/substitution_matrix.hpp>
+
+#include <simdpp/simd.h>
+
+#include <algorithm> // std::copy, std::min, std::reverse
+#include <array> // std::array
+#include <cassert> // assert
+#include <cstdint> // uint8_t, uint16_t
+#include <cstdlib> // std::exit
+#include <iostream> // std::cerr
+#include <iterator> // std::next
+#include <limits> // std::numeric_limits
+#include <memory> // std::unique_ptr
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+
+namespace paw
+{
+
+template <typename Tseq, typename Tuint>
+void
+graph_alignment(Tseq const & seq1,
+                Graph const & graph,
+                AlignmentOptions<Tuint> & opts);
+
+
+namespace arch_null
+{
+
+template <typename Tseq, typename Tuint>
+void
+graph_alignment(Tseq const & seq1,
+                Graph const & graph,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_sse2
+{
+
+template <typename Tseq, typename Tuint>
+void
+graph_alignment(Tseq const & seq1,
+                Graph const & graph,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_sse3
+{
+
+template <typename Tseq, typename Tuint>
+void
+graph_alignment(Tseq const & seq1,
+                Graph const & graph,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_sse4p1
+{
+
+template <typename Tseq, typename Tuint>
+void
+graph_alignment(Tseq const & seq1,
+                Graph const & graph,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_sse4p1_popcnt
+{
+
+template <typename Tseq, typename Tuint>
+void
+graph_alignment(Tseq const & seq1,
+                Graph const & graph,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_popcnt_avx
+{
+
+template <typename Tseq, typename Tuint>
+void
+graph_alignment(Tseq const & seq1,
+                Graph const & graph,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_popcnt_avx2
+{
+
+template <typename Tseq, typename Tuint>
+void
+graph_alignment(Tseq const & seq1,
+                Graph const & graph,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_popcnt_avx512bw_avx512dq_avx512vl
+{
+
+template <typename Tseq, typename Tuint>
+void
+graph_alignment(Tseq const & seq1,
+                Graph const & graph,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_neon
+{
+
+template <typename Tseq, typename Tuint>
+void
+graph_alignment(Tseq const & seq1,
+                Graph const & graph,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+} // namespace paw
+
+
+namespace paw
+{
+namespace SIMDPP_ARCH_NAMESPACE
+{
+
+/// \short Aligns the query (seq1) globally to the path through a graph which gives the best score. Paths start at a
+/// vertex without inbound edges and end at a vertex without outbound edges. The rows of each vertex are calculated in
+/// a topological order, starting from the rows below all vertices with an edge to it, which are merged by taking the
+/// best score of each cell. The path is stored in the results, and the database positions and the CIGAR are relative
+/// to the sequence of the path. The free ends of the options are supported, but the band width and the backtrack
+/// memory limit are not, since the alignment is always traced back to find the path.
+template <typename Tseq, typename Tuint>
+void
+graph_alignment(Tseq const & seq1, // seq1 is query
+                Graph const & graph,
+                AlignmentOptions<Tuint> & opt)
+{
+  using Tpack = typename T<Tuint>::pack;
+  using Tvec_pack = typename T<Tuint>::vec_pack;
+  using Tarr_uint = typename T<Tuint>::arr_uint;
+
+  if (graph.size() == 0)
+  {
+    std::cerr << "ERROR: Cannot align to a graph without vertices." << std::endl;
+    std::exit(1);
+  }
+
+  AlignmentCache<Tuint> & aln_cache = get_thread_alignment_cache<Tuint>();
+  paw::SIMDPP_ARCH_NAMESPACE::set_query<Tuint, Tseq>(opt, aln_cache, seq1);
+
+  long const m = aln_cache.query_size;
+  long const t = aln_cache.num_vectors;
+  long const num_vertices = graph.size();
+  long const top_row = num_vertices; // Index of the rows above the graph among the rows below each vertex
+  long const num_packs = aln_cache.is_dual_gap ? 3 : 2; // Rows of packs below each vertex
+  std::vector<long> const order = graph.get_topological_order();
+
+  // The backtracks of the vertices are stored in the topological order
+  std::vector<long> row_begins(num_vertices);
+  long n = 0;
+
+  for (long const u : order)
+  {
+    row_begins[u] = n;
+    n += graph.get_sequence(u).size();
+  }
+
+  aln_cache.mB.reset(n, t, aln_cache.get_backtrack_bits());
+
+  // The path is always traced back, so the backtracks are stored
+  GlobalAlignmentRow<Tuint> const alignment_row = get_global_alignment_row<Tuint>(aln_cache.is_dual_gap,
+                                                                                  opt.left_column_free ||
+                                                                                  opt.right_column_free,
+                                                                                  true);
+
+  AlignmentResults<Tuint> & aln_results = *opt.get_alignment_results();
+  aln_results.num_lazy_e_rows = 0;
+  aln_results.num_lazy_e_vectors = 0;
+
+  Tvec_pack & vH = aln_cache.vH;
+  Tvec_pack & vF = aln_cache.vF;
+  Tvec_pack & vE = aln_cache.vE;
+  vH.assign(static_cast<std::size_t>(t), simdpp::make_int(
+              2 * aln_cache.gap_open_val + std::numeric_limits<Tuint>::min()));
+  vF.assign(aln_cache.vF_up.begin(), aln_cache.vF_up.end());
+  vE.assign(aln_cache.vF_up.begin(), aln_cache.vF_up.end());
+
+  if (aln_cache.is_dual_gap)
+  {
+    aln_cache.vF2.assign(aln_cache.vF2_up.begin(), aln_cache.vF2_up.end());
+    aln_cache.vE2.assign(aln_cache.vF2_up.begin(), aln_cache.vF2_up.end());
+  }
+
+  std::array<Tvec_pack *, 3> const up_packs = {{&aln_cache.vH_up, &aln_cache.vF_up, &aln_cache.vF2_up}};
+  Tvec_pack & vertex_packs = aln_cache.vertex_packs;
+  std::vector<std::array<long, S / sizeof(Tuint)> > & vertex_reductions = aln_cache.vertex_reductions;
+  vertex_packs.resize(num_packs * (num_vertices + 1) * t);
+  vertex_reductions.resize(num_vertices + 1);
+
+  // Set for the rows below vertices which have no rows above them, i.e. the top row of the graph
+  std::vector<bool> is_top_row(num_vertices + 1, false);
+  is_top_row[top_row] = true;
+
+  auto store_rows_below =
+    [&](long const u)
+    {
+      for (long k = 0; k < num_packs; ++k)
+        std::copy(up_packs[k]->begin(), up_packs[k]->end(), vertex_packs.begin() + (u * num_packs + k) * t);
+
+      vertex_reductions[u] = aln_cache.reductions;
+    };
+
+  auto load_rows_below =
+    [&](long const u)
+    {
+      for (long k = 0; k < num_packs; ++k)
+      {
+        auto const packs_begin = vertex_packs.begin() + (u * num_packs + k) * t;
+        std::copy(packs_begin, packs_begin + t, up_packs[k]->begin());
+      }
+
+      aln_cache.reductions = vertex_reductions[u];
+      aln_cache.update_reduction_deltas();
+    };
+
+  // Merges the rows below vertex u into the rows in the cache. Both are first reduced to the highest reductions of
+  // each element, where scores which are reduced below the minimum value are never the best.
+  auto merge_rows_below =
+    [&](long const u)
+    {
+      Tarr_uint cache_reductions;
+      Tarr_uint vertex_reductions_u;
+      cache_reductions.fill(0);
+      vertex_reductions_u.fill(0);
+      long const max_value = std::numeric_limits<Tuint>::max();
+
+      for (long e = 0; e < static_cast<long>(aln_cache.reductions.size()); ++e)
+      {
+        long const delta = vertex_reductions[u][e] - aln_cache.reductions[e];
+
+        if (delta > 0)
+        {
+          cache_reductions[e] = static_cast<Tuint>(std::min(delta, max_value));
+          aln_cache.reductions[e] = vertex_reductions[u][e];
+        }
+        else
+        {
+          vertex_reductions_u[e] = static_cast<Tuint>(std::min(-delta, max_value));
+        }
+      }
+
+      Tpack const cache_reductions_pack = simdpp::load_u(&cache_reductions[0]);
+      Tpack const vertex_reductions_pack = simdpp::load_u(&vertex_reductions_u[0]);
+
+      for (long k = 0; k < num_packs; ++k)
+      {
+        Tvec_pack & vX_up = *up_packs[k];
+        auto const packs_begin = vertex_packs.begin() + (u * num_packs + k) * t;
+
+        for (long v = 0; v < t; ++v)
+        {
+          vX_up[v] = simdpp::max(simdpp::sub_sat(vX_up[v], cache_reductions_pack),
+                                 simdpp::sub_sat(*(packs_begin + v), vertex_reductions_pack));
+        }
+      }
+
+      aln_cache.update_reduction_deltas();
+    };
+
+  store_rows_below(top_row);
+  SubstitutionMatrix const * const matrix = opt.get_substitution_matrix();
+
+  for (long const u : order)
+  {
+    std::vector<long> const & inbound = graph.get_indexes_inbound(u);
+    load_rows_below(inbound.empty() ? top_row : inbound[0]);
+    bool is_top = inbound.empty() || is_top_row[inbound[0]];
+
+    for (long k = 1; k < static_cast<long>(inbound.size()); ++k)
+    {
+      merge_rows_below(inbound[k]);
+      is_top = is_top && is_top_row[inbound[k]];
+    }
+
+    std::string const & seq2 = graph.get_sequence(u);
+    long const num_rows = seq2.size();
+
+    for (long r = 0; r < num_rows; ++r)
+    {
+      char const c = seq2[r];
+      Tvec_pack const & vW = aln_cache.W_profile[matrix ? matrix->get_index(c) : magic_function(c)];
+      long const i = is_top ? r : r + 1; // Only the first row below the top row of the graph has i = 0
+
+      alignment_row(opt, aln_cache, aln_results, vW, i, row_begins[u] + r, vH, vF, vE);
+    }
+
+    // The gain of the rows is removed, so the rows below vertices at different depths can be merged
+    aln_cache.reduce_every_element(-num_rows * aln_cache.y_gain);
+    is_top_row[u] = is_top && num_rows == 0;
+    store_rows_below(u);
+  }
+
+  // Returns the score of column j in the rows below vertex u. Row k is vH_up, vF_up or vF2_up.
+  auto get_score_below =
+    [&](long const u, long const k, long const j) -> long
+    {
+      Tarr_uint arr;
+      simdpp::store_u(&arr[0], vertex_packs[(u * num_packs + k) * t + j % t]);
+      return static_cast<long>(arr[j / t]) + vertex_reductions[u][j / t] - aln_cache.x_gain * j;
+    };
+
+  // The alignment ends in the vertex without outbound edges which has the highest score
+  long end_vertex = -1;
+  aln_results.score = std::numeric_limits<long>::min();
+  aln_results.query_end = m;
+
+  for (long const u : order)
+  {
+    if (!graph.get_indexes_outbound(u).empty())
+      continue;
+
+    // Select the right-most column with the highest score when the bottom row is free
+    for (long j = m; j >= (opt.bottom_row_free ? 0 : m); --j)
+    {
+      long const score = get_score_below(u, 0, j);
+
+      if (score > aln_results.score)
+      {
+        aln_results.score = score;
+        aln_results.query_end = j;
+        end_vertex = u;
+      }
+    }
+  }
+
+  assert(end_vertex >= 0);
+
+  // Trace the alignment back through the graph. Above the top row of a vertex, the alignment continues in the
+  // inbound vertex which has the best score in the row of packs it came from.
+  std::vector<Cigar> & cigar = aln_results.cigar;
+  std::vector<long> & path = aln_results.path;
+  cigar.clear();
+  path.assign(1, end_vertex);
+
+  long u = end_vertex;
+  long r = graph.get_sequence(u).size(); // Row in the vertex, where 0 is the rows below its inbound vertices
+  long j = aln_results.query_end;
+
+  if (j < m)
+    add_cigar_operation(cigar, DELETION, m - j);
+
+  auto move_to_inbound =
+    [&](long const k) -> bool
+    {
+      while (r == 0)
+      {
+        std::vector<long> const & inbound = graph.get_indexes_inbound(u);
+
+        if (inbound.empty())
+          return false;
+
+        long best_u = inbound[0];
+        long best_score = get_score_below(best_u, k, j);
+
+        for (long p = 1; p < static_cast<long>(inbound.size()); ++p)
+        {
+          long const score = get_score_below(inbound[p], k, j);
+
+          if (score > best_score)
+          {
+            best_score = score;
+            best_u = inbound[p];
+          }
+        }
+
+        u = best_u;
+        r = graph.get_sequence(u).size();
+        path.push_back(u);
+      }
+
+      return true;
+    };
+
+  Backtrack<Tuint> const & mB = aln_cache.mB;
+
+  while (r > 0 || move_to_inbound(0 /*vH_up*/))
+  {
+    long const i = row_begins[u] + r; // Row of the cell in the backtrack matrix, starting from 1
+
+    if (j == 0)
+    {
+      add_cigar_operation(cigar, INSERTION, r);
+      r = 0;
+    }
+    else if (mB.is_del_at(i, j))
+    {
+      long j_open = j; // Column where the deletion was opened
+
+      if (mB.is_del2_at(i, j))
+      {
+        while (j_open > 1 && mB.is_del2_extend_at(i, j_open))
+          --j_open;
+      }
+      else
+      {
+        while (j_open > 1 && mB.is_del_extend_at(i, j_open))
+          --j_open;
+      }
+
+      add_cigar_operation(cigar, DELETION, j - j_open + 1);
+      j = j_open - 1;
+    }
+    else if (mB.is_ins_at(i, j))
+    {
+      bool const is_second = mB.is_ins2_at(i, j);
+
+      // Follow the extensions of the insertion, which may continue in an inbound vertex
+      while (true)
+      {
+        long const i_ins = row_begins[u] + r;
+        bool const is_extend = is_second ? mB.is_ins2_extend_at(i_ins, j) : mB.is_ins_extend_at(i_ins, j);
+        add_cigar_operation(cigar, INSERTION);
+        --r;
+
+        if (!is_extend || (r == 0 && !move_to_inbound(is_second ? 2 /*vF2_up*/ : 1 /*vF_up*/)))
+          break;
+      }
+    }
+    else
+    {
+      char const q_base = *std::next(seq1.begin(), j - 1);
+      char const d_base = graph.get_sequence(u)[r - 1];
+      bool const is_match = q_base == d_base || q_base == 'N' || d_base == 'N';
+      add_cigar_operation(cigar, is_match ? SEQUENCE_MATCH : MISMATCH);
+      --r;
+      --j;
+    }
+  }
+
+  // Query bases above the top row of the graph are deleted
+  if (j > 0)
+    add_cigar_operation(cigar, DELETION, j);
+
+  std::reverse(cigar.begin(), cigar.end());
+  std::reverse(path.begin(), path.end());
+
+  // Skipped bases are at the ends of the CIGAR
+  std::string const path_seq = graph.get_path_sequence(path);
+  aln_results.query_begin = 0;
+  aln_results.database_begin = 0;
+  aln_results.database_end = path_seq.size();
+
+  if (opt.left_column_free && !cigar.empty() && cigar.front().operation == INSERTION)
+    aln_results.database_begin = cigar.front().count;
+
+  if (opt.top_row_free && !cigar.empty() && cigar.front().operation == DELETION)
+    aln_results.query_begin = cigar.front().count;
+
+  if (opt.right_column_free && aln_results.query_end == m && !cigar.empty() && cigar.back().operation == INSERTION)
+    aln_results.database_end -= cigar.back().count;
+
+  if (opt.get_aligned_strings)
+  {
+    if (!aln_results.aligned_strings_ptr)
+      aln_results.aligned_strings_ptr = std::unique_ptr<std::pair<std::string, std::string> >(
+        new std::pair<std::string, std::string>());
+
+    get_aligned_strings(cigar, seq1, Tseq(path_seq.begin(), path_seq.end()), *aln_results.aligned_strings_ptr);
+  }
+}
+
+
+} // namespace SIMDPP_ARCH_NAMESPACE
+} // namespace paw
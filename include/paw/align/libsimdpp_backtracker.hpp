@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm> // std::fill
+#include <cassert> // assert
 #include <cstdint>
+#include <cstring> // std::memcpy
 #include <string> // std::string
 #include <vector> // std::vector<T>
 #include <iostream>
@@ -24,46 +27,129 @@ struct Backtrack
   using Tvec_pack = typename T<Tuint>::vec_pack;
   using Tarr_uint = typename T<Tuint>::arr_uint;
 
-  std::size_t static constexpr BACKTRACKS_PER_BYTE = 2;
-  std::size_t static constexpr BT_PER_CELL = sizeof(Tuint) * BACKTRACKS_PER_BYTE;
-
-  /// \short How many bits are required for one column of backtracks
-  std::size_t static constexpr N_BT_BITS = 8 / BACKTRACKS_PER_BYTE;
-
   Tuint static constexpr DEL_SHIFT = 0;
   Tuint static constexpr INS_SHIFT = 1;
   Tuint static constexpr DEL_E_SHIFT = 2;
   Tuint static constexpr INS_E_SHIFT = 3;
+  Tuint static constexpr DEL2_SHIFT = 4;
+  Tuint static constexpr INS2_SHIFT = 5;
+  Tuint static constexpr DEL2_E_SHIFT = 6;
+  Tuint static constexpr INS2_E_SHIFT = 7;
   Tuint static constexpr SUB_BT = 0; // substitution is represented with 0
   Tuint static constexpr DEL_BT = 1 << DEL_SHIFT;
   Tuint static constexpr INS_BT = 1 << INS_SHIFT;
   Tuint static constexpr DEL_E_BT = 1 << DEL_E_SHIFT;
   Tuint static constexpr INS_E_BT = 1 << INS_E_SHIFT;
+  Tuint static constexpr DEL2_BT = 1 << DEL2_SHIFT; // the deletion has the second gap cost
+  Tuint static constexpr INS2_BT = 1 << INS2_SHIFT; // the insertion has the second gap cost
+  Tuint static constexpr DEL2_E_BT = 1 << DEL2_E_SHIFT;
+  Tuint static constexpr INS2_E_BT = 1 << INS2_E_SHIFT;
 
   long t{0};
-  std::vector<Tvec_pack> matrix;
-  mutable Tarr_uint tmp_vec;
+  long n_bt_bits{4}; // Bits per backtrack, 4, 2 if the gap extension bits are not stored or 8 with two gap costs
+  long bt_per_cell_shift{0}; // Base 2 logarithm of the number of backtracks per element of a pack
+  long n_packs_per_row{0};
+  std::vector<Tpack, simdpp::aligned_allocator<Tpack, sizeof(Tpack)> > matrix; // All rows in one contiguous arena
 
   Backtrack()
     : Backtrack(0, 0)
   {}
 
 
-  Backtrack(long const n_row, long const n_vectors)
-    : t(n_vectors)
-    , matrix(static_cast<std::size_t>(n_row),
-             {(n_vectors + BT_PER_CELL - 1) / BT_PER_CELL, static_cast<Tpack>(simdpp::make_zero())})
+  /// \short Creates a backtrack matrix with all backtracks set to substitutions
+  /// \param[in] n_row number of rows
+  /// \param[in] n_vectors number of vectors in each row
+  /// \param[in] n_bits number of bits per backtrack. With two bits gap extensions are never reported, which is
+  ///                   only correct when opening and extending gaps cost the same. Eight bits are needed to store
+  ///                   the backtracks of the second gap cost.
+  Backtrack(long const n_row, long const n_vectors, long const n_bits = 4)
+  {
+    reset(n_row, n_vectors, n_bits);
+  }
+
+
+  /// \short Resizes the backtrack matrix and sets all backtracks to substitutions. The memory of the matrix is
+  /// reused when it is large enough.
+  inline void
+  reset(long const n_row, long const n_vectors, long const n_bits = 4)
   {
     assert(n_row >= 0);
-    tmp_vec.fill(0);
+    assert(n_bits == 2 || n_bits == 4 || n_bits == 8);
+    t = n_vectors;
+    n_bt_bits = n_bits;
+    long const bt_per_cell = sizeof(Tuint) * 8 / n_bt_bits;
+    bt_per_cell_shift = 0;
+
+    while ((1l << bt_per_cell_shift) < bt_per_cell)
+      ++bt_per_cell_shift;
+
+    n_packs_per_row = get_row_bytes(n_vectors, n_bits) / sizeof(Tpack);
+    matrix.assign(static_cast<std::size_t>(n_row * n_packs_per_row), static_cast<Tpack>(simdpp::make_zero()));
+  }
+
+
+  /// \short Returns the number of bytes needed to store the backtracks of one row
+  static long
+  get_row_bytes(long const n_vectors, long const n_bits)
+  {
+    long const bt_per_cell = sizeof(Tuint) * 8 / n_bits;
+    return (n_vectors + bt_per_cell - 1) / bt_per_cell * sizeof(Tpack);
+  }
+
+
+  /// \short Sets all backtracks of row i to substitutions, so the row can be reused
+  inline void
+  clear_row(long const i)
+  {
+    assert((i + 1) * n_packs_per_row <= static_cast<long>(matrix.size()));
+    std::fill(matrix.begin() + i * n_packs_per_row,
+              matrix.begin() + (i + 1) * n_packs_per_row,
+              static_cast<Tpack>(simdpp::make_zero()));
+  }
+
+
+  inline bool
+  is_compact() const
+  {
+    return n_bt_bits == 2;
   }
 
 
   inline Tpack const &
   get_pack(long const i /*row index*/, long const v /*vector index*/) const
   {
-    assert(i < static_cast<long>(matrix.size()));
-    return matrix[i][v / BT_PER_CELL];
+    assert(i * n_packs_per_row + (v >> bt_per_cell_shift) < static_cast<long>(matrix.size()));
+    return matrix[i * n_packs_per_row + (v >> bt_per_cell_shift)];
+  }
+
+
+  /// \short Sets a backtrack bit of vector v in row i for all elements in the mask
+  void inline
+  set(long const i /*row index*/,
+      long const v /*vector index*/,
+      Tuint const bt /*backtrack bit to set*/,
+      Tmask const mask /*mask to set*/)
+  {
+    Tpack & pack = matrix[i * n_packs_per_row + (v >> bt_per_cell_shift)];
+    assert(&pack < matrix.data() + matrix.size());
+    Tuint const shift = n_bt_bits * (v & ((1l << bt_per_cell_shift) - 1));
+    pack = pack | simdpp::blend(static_cast<Tpack>(simdpp::make_uint(static_cast<Tuint>(bt << shift))),
+                                static_cast<Tpack>(simdpp::make_zero()),
+                                mask);
+  }
+
+
+  /// \short Gets all backtrack bits of a single element without storing the whole pack
+  /// \param[in] i row index
+  /// \param[in] v vector index
+  /// \param[in] e element index
+  Tuint inline
+  get(long const i, long const v, long const e) const
+  {
+    Tuint element;
+    char const * bytes = reinterpret_cast<char const *>(&get_pack(i, v));
+    std::memcpy(&element, bytes + e * sizeof(Tuint), sizeof(Tuint));
+    return (element >> (n_bt_bits * (v & ((1l << bt_per_cell_shift) - 1)))) & ((1 << n_bt_bits) - 1);
   }
 
 
@@ -72,14 +158,7 @@ struct Backtrack
           long const v /*vector index*/,
           Tmask const mask /*mask to set*/)
   {
-    assert(i < static_cast<long>(matrix.size()));
-    matrix[i][v / BT_PER_CELL] = matrix[i][v / BT_PER_CELL]
-                                 | (simdpp::blend(static_cast<Tpack>(simdpp::make_uint(DEL_BT <<
-                                                                                       (N_BT_BITS *
-                                                                                        (v % BT_PER_CELL)))),
-                                                  static_cast<Tpack>(simdpp::make_zero()),
-                                                  mask)
-                                    );
+    set(i, v, DEL_BT, mask);
   }
 
 
@@ -88,13 +167,7 @@ struct Backtrack
           long const v /*vector index*/,
           Tmask const mask /*mask to set*/)
   {
-    assert(i < static_cast<long>(matrix.size()));
-    matrix[i][v / BT_PER_CELL] = matrix[i][v / BT_PER_CELL] |
-                                 (simdpp::blend(static_cast<Tpack>(simdpp::make_uint(INS_BT <<
-                                                                                     (N_BT_BITS * (v % BT_PER_CELL)))),
-                                                static_cast<Tpack>(simdpp::make_zero()),
-                                                mask)
-                                 );
+    set(i, v, INS_BT, mask);
   }
 
 
@@ -103,13 +176,8 @@ struct Backtrack
                  long const v /*vector index*/,
                  Tmask const mask /*mask to set*/)
   {
-    assert(i < static_cast<long>(matrix.size()));
-    matrix[i][v / BT_PER_CELL] = matrix[i][v / BT_PER_CELL] |
-                                 (simdpp::blend(static_cast<Tpack>(simdpp::make_uint(DEL_E_BT <<
-                                                                                     (N_BT_BITS * (v % BT_PER_CELL)))),
-                                                static_cast<Tpack>(simdpp::make_zero()),
-                                                mask)
-                                 );
+    if (!is_compact())
+      set(i, v, DEL_E_BT, mask);
   }
 
 
@@ -118,13 +186,41 @@ struct Backtrack
                  long const v /*vector index*/,
                  Tmask const mask /*mask to set*/)
   {
-    assert(i < static_cast<long>(matrix.size()));
-    matrix[i][v / BT_PER_CELL] = matrix[i][v / BT_PER_CELL] |
-                                 (simdpp::blend(static_cast<Tpack>(simdpp::make_uint(INS_E_BT <<
-                                                                                     (N_BT_BITS * (v % BT_PER_CELL)))),
-                                                static_cast<Tpack>(simdpp::make_zero()),
-                                                mask)
-                                 );
+    if (!is_compact())
+      set(i, v, INS_E_BT, mask);
+  }
+
+
+  /// \short Setters of the backtracks of the second gap cost, which may only be used with eight bits per backtrack
+  void inline
+  set_del2(long const i, long const v, Tmask const mask)
+  {
+    assert(n_bt_bits == 8);
+    set(i, v, DEL2_BT, mask);
+  }
+
+
+  void inline
+  set_ins2(long const i, long const v, Tmask const mask)
+  {
+    assert(n_bt_bits == 8);
+    set(i, v, INS2_BT, mask);
+  }
+
+
+  void inline
+  set_del2_extend(long const i, long const v, Tmask const mask)
+  {
+    assert(n_bt_bits == 8);
+    set(i, v, DEL2_E_BT, mask);
+  }
+
+
+  void inline
+  set_ins2_extend(long const i, long const v, Tmask const mask)
+  {
+    assert(n_bt_bits == 8);
+    set(i, v, INS2_E_BT, mask);
   }
 
 
@@ -139,9 +235,7 @@ struct Backtrack
          long const e
          ) const
   {
-    assert(i < static_cast<long>(matrix.size()));
-    simdpp::store_u(&tmp_vec[0], matrix[i][v / BT_PER_CELL]);
-    return (tmp_vec[e] >> (N_BT_BITS * (v % BT_PER_CELL))) & DEL_BT;
+    return get(i, v, e) & DEL_BT;
   }
 
 
@@ -156,8 +250,7 @@ struct Backtrack
          long const e
          ) const
   {
-    simdpp::store_u(&tmp_vec[0], matrix[i][v / BT_PER_CELL]);
-    return (tmp_vec[e] >> (N_BT_BITS * (v % BT_PER_CELL))) & INS_BT;
+    return get(i, v, e) & INS_BT;
   }
 
 
@@ -167,9 +260,7 @@ struct Backtrack
                 long const e /*element index*/
                 ) const
   {
-    assert(i < static_cast<long>(matrix.size()));
-    simdpp::store_u(&tmp_vec[0], matrix[i][v / BT_PER_CELL]);
-    return (tmp_vec[e] >> (N_BT_BITS * (v % BT_PER_CELL))) & DEL_E_BT;
+    return get(i, v, e) & DEL_E_BT;
   }
 
 
@@ -179,9 +270,163 @@ struct Backtrack
                 long const e /*element index*/
                 ) const
   {
-    assert(i < static_cast<long>(matrix.size()));
-    simdpp::store_u(&tmp_vec[0], matrix[i][v / BT_PER_CELL]);
-    return (tmp_vec[e] >> (N_BT_BITS * (v % BT_PER_CELL))) & INS_E_BT;
+    return get(i, v, e) & INS_E_BT;
+  }
+
+
+  /// \short Cell based accessors, where i is the database row (1-based) and j the query column of the cell
+  bool inline
+  is_del_at(long const i, long const j) const
+  {
+    return is_del(i - 1, j % t, j / t);
+  }
+
+
+  bool inline
+  is_ins_at(long const i, long const j) const
+  {
+    return is_ins(i - 1, j % t, j / t);
+  }
+
+
+  bool inline
+  is_del_extend_at(long const i, long const j) const
+  {
+    return is_del_extend(i - 1, j % t, j / t);
+  }
+
+
+  bool inline
+  is_ins_extend_at(long const i, long const j) const
+  {
+    return is_ins_extend(i - 1, j % t, j / t);
+  }
+
+
+  bool inline
+  is_del2_at(long const i, long const j) const
+  {
+    return get(i - 1, j % t, j / t) & DEL2_BT;
+  }
+
+
+  bool inline
+  is_ins2_at(long const i, long const j) const
+  {
+    return get(i - 1, j % t, j / t) & INS2_BT;
+  }
+
+
+  bool inline
+  is_del2_extend_at(long const i, long const j) const
+  {
+    return get(i - 1, j % t, j / t) & DEL2_E_BT;
+  }
+
+
+  bool inline
+  is_ins2_extend_at(long const i, long const j) const
+  {
+    return get(i - 1, j % t, j / t) & INS2_E_BT;
+  }
+
+
+};
+
+
+/// \short Backtrack which only keeps the rows of one block in memory. When a row outside of the block is queried,
+/// the block containing it is recomputed from a checkpoint by calling compute_block with the first row of the block.
+/// The rows must be queried from the bottom up, like the traceback does, so each block is only recomputed once.
+template <typename Tuint, typename Tcompute_block>
+struct CheckpointedBacktrack
+{
+  Backtrack<Tuint> const & mB; // Backtracks of the rows in the current block
+  long const block_size;
+  Tcompute_block compute_block; // Computes the backtracks of the block beginning at a row into mB
+  long mutable block_begin; // First row of the current block
+
+  CheckpointedBacktrack(Backtrack<Tuint> const & _mB,
+                        long const _block_size,
+                        Tcompute_block _compute_block,
+                        long const _block_begin)
+    : mB(_mB)
+    , block_size(_block_size)
+    , compute_block(_compute_block)
+    , block_begin(_block_begin)
+  {}
+
+
+  /// \short Makes sure the cell row i, which is 1-based like in is_del_at, is in the current block and returns the
+  /// cell row of it in mB
+  long inline
+  get_block_row(long const i) const
+  {
+    assert(i >= 1);
+
+    if (i - 1 < block_begin)
+    {
+      block_begin = (i - 1) / block_size * block_size;
+      compute_block(block_begin);
+    }
+
+    assert(i - 1 - block_begin < block_size);
+    return i - block_begin;
+  }
+
+
+  bool inline
+  is_del_at(long const i, long const j) const
+  {
+    return mB.is_del_at(get_block_row(i), j);
+  }
+
+
+  bool inline
+  is_ins_at(long const i, long const j) const
+  {
+    return mB.is_ins_at(get_block_row(i), j);
+  }
+
+
+  bool inline
+  is_del_extend_at(long const i, long const j) const
+  {
+    return mB.is_del_extend_at(get_block_row(i), j);
+  }
+
+
+  bool inline
+  is_ins_extend_at(long const i, long const j) const
+  {
+    return mB.is_ins_extend_at(get_block_row(i), j);
+  }
+
+
+  bool inline
+  is_del2_at(long const i, long const j) const
+  {
+    return mB.is_del2_at(get_block_row(i), j);
+  }
+
+
+  bool inline
+  is_ins2_at(long const i, long const j) const
+  {
+    return mB.is_ins2_at(get_block_row(i), j);
+  }
+
+
+  bool inline
+  is_del2_extend_at(long const i, long const j) const
+  {
+    return mB.is_del2_extend_at(get_block_row(i), j);
+  }
+
+
+  bool inline
+  is_ins2_extend_at(long const i, long const j) const
+  {
+    return mB.is_ins2_extend_at(get_block_row(i), j);
   }
 
 
@@ -275,12 +520,6 @@ print_backtrack(Backtrack const & mB)
 }
 */
 
-template <typename Tuint>
-std::size_t constexpr Backtrack<Tuint>::BACKTRACKS_PER_BYTE;
-template <typename Tuint>
-std::size_t constexpr Backtrack<Tuint>::BT_PER_CELL;
-template <typename Tuint>
-std::size_t constexpr Backtrack<Tuint>::N_BT_BITS;
 template <typename Tuint>
 Tuint constexpr Backtrack<Tuint>::DEL_SHIFT;
 template <typename Tuint>
@@ -299,6 +538,22 @@ template <typename Tuint>
 Tuint constexpr Backtrack<Tuint>::DEL_E_BT;
 template <typename Tuint>
 Tuint constexpr Backtrack<Tuint>::INS_E_BT;
+template <typename Tuint>
+Tuint constexpr Backtrack<Tuint>::DEL2_SHIFT;
+template <typename Tuint>
+Tuint constexpr Backtrack<Tuint>::INS2_SHIFT;
+template <typename Tuint>
+Tuint constexpr Backtrack<Tuint>::DEL2_E_SHIFT;
+template <typename Tuint>
+Tuint constexpr Backtrack<Tuint>::INS2_E_SHIFT;
+template <typename Tuint>
+Tuint constexpr Backtrack<Tuint>::DEL2_BT;
+template <typename Tuint>
+Tuint constexpr Backtrack<Tuint>::INS2_BT;
+template <typename Tuint>
+Tuint constexpr Backtrack<Tuint>::DEL2_E_BT;
+template <typename Tuint>
+Tuint constexpr Backtrack<Tuint>::INS2_E_BT;
 
 
 } // namespace SIMDPP_ARCH_NAMESPACE
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <vector>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 
 #include <simdpp/simd.h>
 
@@ -37,7 +39,6 @@ struct T<uint8_t>
   using uint = pack::element_type;
   using vec_pack = std::vector<pack>;
   using arr_uint = std::array<uint, S / sizeof(uint)>;
-  using arr_vec_pack = std::array<vec_pack, 5>;
 };
 
 template <>
@@ -48,9 +49,10 @@ struct T<uint16_t>
   using uint = pack::element_type;
   using vec_pack = std::vector<pack>;
   using arr_uint = std::array<uint, S / sizeof(uint)>;
-  using arr_vec_pack = std::array<vec_pack, 5>;
 };
 
+/// \short Shifts all elements of a pack one to the right and moves them between the reductions of neighbouring
+/// elements. Reference implementation which goes through memory, see the overload with reduction delta packs.
 template <typename Tuint>
 inline typename T<Tuint>::pack
 shift_one_right(typename T<Tuint>::pack pack,
@@ -72,6 +74,108 @@ shift_one_right(typename T<Tuint>::pack pack,
 }
 
 
+/// \short Shifts all elements of a pack one to the right across the whole vector and sets the left-most element to
+/// zero. The libsimdpp move_r functions shift each 128-bit lane separately, so wider vectors are handled natively.
+template <typename Tuint>
+inline typename T<Tuint>::pack
+shift_elements_right(typename T<Tuint>::pack const & pack)
+{
+  using Tpack = typename T<Tuint>::pack;
+
+#if SIMDPP_USE_AVX512BW
+  // Move each 128-bit lane one lane up and take the last element of the lane below
+  __m512i const lanes_up = _mm512_alignr_epi64(pack.native(), _mm512_setzero_si512(), 6);
+  return Tpack(_mm512_alignr_epi8(pack.native(), lanes_up, 16 - sizeof(Tuint)));
+#elif SIMDPP_USE_AVX2
+  __m256i const lanes_up = _mm256_permute2x128_si256(pack.native(), pack.native(), 0x08);
+  return Tpack(_mm256_alignr_epi8(pack.native(), lanes_up, 16 - sizeof(Tuint)));
+#else
+  static_assert(S == 16, "Only 128-bit vectors can be shifted with move16_r.");
+  simdpp::uint8<S> const bytes = simdpp::bit_cast<simdpp::uint8<S> >(pack);
+  return simdpp::bit_cast<Tpack>(simdpp::move16_r<sizeof(Tuint)>(bytes));
+#endif
+}
+
+
+/// \short Shifts all elements one to the right and moves them between the reductions of neighbouring elements,
+/// without leaving the registers. The reduction differences must be split into the packs delta_add and delta_sub,
+/// which have a zero left-most element, and left_mask must only have the bits of the left-most element set.
+template <typename Tuint>
+inline typename T<Tuint>::pack
+shift_one_right(typename T<Tuint>::pack const & pack,
+                typename T<Tuint>::uint const left,
+                typename T<Tuint>::pack const & delta_add,
+                typename T<Tuint>::pack const & delta_sub,
+                typename T<Tuint>::pack const & left_mask)
+{
+  using Tpack = typename T<Tuint>::pack;
+
+  Tpack const shifted = simdpp::sub_sat(static_cast<Tpack>(shift_elements_right<Tuint>(pack) + delta_add), delta_sub);
+  return shifted | (static_cast<Tpack>(simdpp::make_uint(left)) & left_mask);
+}
+
+
+/// \short Shifts all elements one to the right like shift_one_right, but each element also carries the running
+/// maximum of all elements to its left. This gives the best deletion from any previous element of a row.
+template <typename Tuint>
+inline typename T<Tuint>::pack
+shift_one_right_carry(typename T<Tuint>::pack pack,
+                      typename T<Tuint>::uint const left,
+                      std::array<long, S / sizeof(typename T<Tuint>::uint)> const & reductions)
+{
+  std::array<typename T<Tuint>::uint, T<Tuint>::pack::length + 1> vec;
+  vec[0] = left;
+  simdpp::store_u(&vec[1], pack);
+  Tuint const min_value = std::numeric_limits<Tuint>::min();
+
+  for (long e = 1; e < static_cast<long>(T<Tuint>::pack::length); ++e)
+  {
+    long const val = static_cast<long>(std::max(vec[e], vec[e - 1])) + reductions[e - 1] - reductions[e];
+    vec[e] = val >= min_value ? val : min_value;
+  }
+
+  return simdpp::load_u(&vec[0]);
+}
+
+
+/// \short Like shift_one_right_carry, but a carried value increases by gain for every column it is carried, which is
+/// n_vectors columns for each element. Elements with the minimum value are not scores and are never carried.
+template <typename Tuint>
+inline typename T<Tuint>::pack
+shift_one_right_carry_gain(typename T<Tuint>::pack pack,
+                           typename T<Tuint>::uint const left,
+                           std::array<long, S / sizeof(typename T<Tuint>::uint)> const & reductions,
+                           Tuint const gain,
+                           long const n_vectors)
+{
+  std::array<typename T<Tuint>::uint, T<Tuint>::pack::length + 1> vec;
+  vec[0] = left;
+  simdpp::store_u(&vec[1], pack);
+  Tuint const min_value = std::numeric_limits<Tuint>::min();
+  long const max_value = std::numeric_limits<Tuint>::max();
+
+  for (long e = 1; e < static_cast<long>(T<Tuint>::pack::length); ++e)
+  {
+    // vec[e - 1] is the value carried into element e - 1 and vec[e] is the last value of element e - 1
+    long best = vec[e] == min_value ? min_value : static_cast<long>(vec[e]) + gain;
+
+    if (vec[e - 1] != min_value)
+      best = std::max(best, static_cast<long>(vec[e - 1]) + gain * n_vectors);
+
+    if (best == min_value)
+    {
+      vec[e] = min_value;
+      continue;
+    }
+
+    long const val = best + reductions[e - 1] - reductions[e];
+    vec[e] = val >= min_value ? std::min(val, max_value) : min_value;
+  }
+
+  return simdpp::load_u(&vec[0]);
+}
+
+
 inline long
 magic_function(char const c)
 {
@@ -0,0 +1,424 @@
+#pragma once
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/global_alignment.hpp>
+#include <paw/align/libsimdpp_utils.hpp>
+#include <paw/align/substitution_matrix.hpp>
+
+#include <simdpp/simd.h>
+
+#include <array> // std::array
+#include <cassert> // assert
+#include <cstdint> // uint8_t, uint16_t
+#include <iterator> // std::next
+#include <limits> // std::numeric_limits
+#include <string> // std::string
+#include <utility> // std::move
+#include <vector> // std::vector
+
+
+namespace paw
+{
+
+template <typename Tseq, typename Tuint>
+void
+local_alignment(Tseq const & seq1,
+                Tseq const & seq2,
+                AlignmentOptions<Tuint> & opts);
+
+
+namespace arch_null
+{
+
+template <typename Tseq, typename Tuint>
+void
+local_alignment(Tseq const & seq1,
+                Tseq const & seq2,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_sse2
+{
+
+template <typename Tseq, typename Tuint>
+void
+local_alignment(Tseq const & seq1,
+                Tseq const & seq2,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_sse3
+{
+
+template <typename Tseq, typename Tuint>
+void
+local_alignment(Tseq const & seq1,
+                Tseq const & seq2,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_sse4p1
+{
+
+template <typename Tseq, typename Tuint>
+void
+local_alignment(Tseq const & seq1,
+                Tseq const & seq2,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_sse4p1_popcnt
+{
+
+template <typename Tseq, typename Tuint>
+void
+local_alignment(Tseq const & seq1,
+                Tseq const & seq2,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_popcnt_avx
+{
+
+template <typename Tseq, typename Tuint>
+void
+local_alignment(Tseq const & seq1,
+                Tseq const & seq2,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_popcnt_avx2
+{
+
+template <typename Tseq, typename Tuint>
+void
+local_alignment(Tseq const & seq1,
+                Tseq const & seq2,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_popcnt_avx512bw_avx512dq_avx512vl
+{
+
+template <typename Tseq, typename Tuint>
+void
+local_alignment(Tseq const & seq1,
+                Tseq const & seq2,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+namespace arch_neon
+{
+
+template <typename Tseq, typename Tuint>
+void
+local_alignment(Tseq const & seq1,
+                Tseq const & seq2,
+                AlignmentOptions<Tuint> & opts);
+
+}
+
+} // namespace paw
+
+
+namespace paw
+{
+namespace SIMDPP_ARCH_NAMESPACE
+{
+
+/// \short End of the best local alignment
+struct LocalAlignmentEnd
+{
+  long score{0}; // Highest score in the matrix
+  long query_end{0}; // One past the last query position of the alignment
+  long database_end{0}; // One past the last database position of the alignment
+  bool is_overflow{false}; // Set if the scores did not fit in the integer type
+};
+
+
+/// \short Shifts all elements of a pack one to the right and inserts a new left-most element
+template <typename Tuint>
+inline typename T<Tuint>::pack
+shift_in_left(typename T<Tuint>::pack const & pack, Tuint const left)
+{
+  typename T<Tuint>::arr_uint vec;
+  simdpp::store_u(&vec[0], pack);
+
+  for (long e = static_cast<long>(vec.size()) - 1; e > 0; --e)
+    vec[e] = vec[e - 1];
+
+  vec[0] = left;
+  return simdpp::load_u(&vec[0]);
+}
+
+
+/// \short Finds the end of the best local alignment using a striped Smith-Waterman kernel.
+/// Scores are stored biased by the mismatch penalty in saturating unsigned integers, so cells with negative scores
+/// are clamped to zero. The top-left cell can be given a score (corner) so the alignment from it can be found.
+/// When a substitution matrix is given, match and mismatch must be its highest score and highest penalty.
+template <typename Tuint>
+LocalAlignmentEnd
+local_alignment_end(std::string const & q,
+                    std::string const & d,
+                    long const match,
+                    long const mismatch,
+                    long const gap_open,
+                    long const gap_extend,
+                    long const corner,
+                    SubstitutionMatrix const * const matrix = nullptr)
+{
+  using Tpack = typename T<Tuint>::pack;
+  using Tvec_pack = typename T<Tuint>::vec_pack;
+  using Tarr_uint = typename T<Tuint>::arr_uint;
+
+  long constexpr L = Tpack::length;
+  long const max_val = std::numeric_limits<Tuint>::max();
+
+  LocalAlignmentEnd res;
+  long const m = q.size();
+  long const n = d.size();
+  long const bias = mismatch;
+
+  if (match + bias + corner > max_val || gap_open > max_val || gap_extend > max_val)
+  {
+    res.is_overflow = true;
+    return res;
+  }
+
+  if (m == 0 || n == 0)
+  {
+    res.score = corner;
+    return res;
+  }
+
+  long const t = (m + L - 1) / L;
+
+  // Striped query profile for each database base, or each symbol of the substitution matrix
+  std::vector<Tvec_pack> W_profile(matrix ? matrix->get_alphabet_size() : 5);
+
+  {
+    std::array<char, 4> constexpr DNA_BASES = {{'A', 'C', 'G', 'T'}};
+
+    for (long c = 0; c < static_cast<long>(W_profile.size()); ++c)
+    {
+      auto & W = W_profile[c];
+      W.reserve(t);
+
+      for (long v = 0; v < t; ++v)
+      {
+        Tarr_uint vec;
+        vec.fill(0);
+
+        for (long e = 0, j = v; j < m; j += t, ++e)
+        {
+          if (matrix)
+            vec[e] = bias + matrix->get_score_by_index(matrix->get_index(q[j]), c);
+          else if (c == 4 || q[j] == 'N' || q[j] == DNA_BASES[c])
+            vec[e] = match + bias;
+          else
+            vec[e] = bias - mismatch;
+        }
+
+        W.push_back(static_cast<Tpack>(simdpp::load_u(&vec[0])));
+      }
+    }
+  }
+
+  Tpack const zero_pack = simdpp::make_zero();
+  Tpack const one_pack = simdpp::make_int(1);
+  Tpack const bias_pack = simdpp::make_int(bias);
+  Tpack const gap_open_pack = simdpp::make_int(gap_open);
+  Tpack const gap_extend_pack = simdpp::make_int(gap_extend);
+
+  Tvec_pack vH_up(t, zero_pack);
+  Tvec_pack vH(t, zero_pack);
+  Tvec_pack vF(t, zero_pack); // Insertions, i.e. vertical gaps
+  Tvec_pack vH_best;
+  long best_score = 0;
+  long best_row = -1;
+
+  for (long i = 0; i < n; ++i)
+  {
+    Tvec_pack const & vW = W_profile[matrix ? matrix->get_index(d[i]) : magic_function(d[i])];
+    Tpack vE = zero_pack; // Deletions, i.e. horizontal gaps
+    Tpack vMax = zero_pack;
+    Tpack vH_diagonal = shift_in_left<Tuint>(vH_up[t - 1], static_cast<Tuint>(i == 0 ? corner : 0));
+
+    for (long v = 0; v < t; ++v)
+    {
+      Tpack h = simdpp::sub_sat(simdpp::add_sat(vH_diagonal, vW[v]), bias_pack);
+      h = simdpp::max(h, vE);
+      h = simdpp::max(h, vF[v]);
+      vMax = simdpp::max(vMax, h);
+      vH[v] = h;
+
+      Tpack const h_open = simdpp::sub_sat(h, gap_open_pack);
+      vF[v] = simdpp::max(simdpp::sub_sat(vF[v], gap_extend_pack), h_open);
+      vE = simdpp::max(simdpp::sub_sat(vE, gap_extend_pack), h_open);
+      vH_diagonal = vH_up[v];
+    }
+
+    // Deletions crossing between elements of the vectors. Stop when they can no longer improve any score.
+    for (long k = 0; k < L; ++k)
+    {
+      vE = shift_in_left<Tuint>(vE, 0);
+      bool is_done = false;
+
+      for (long v = 0; v < t; ++v)
+      {
+        Tpack const h = simdpp::max(vH[v], vE);
+        vMax = simdpp::max(vMax, h);
+        vH[v] = h;
+
+        Tpack const h_open = simdpp::sub_sat(h, gap_open_pack);
+        vF[v] = simdpp::max(vF[v], h_open);
+        vE = simdpp::sub_sat(vE, gap_extend_pack);
+
+        // Continue while any deletion has a positive score at least as high as a newly opened one
+        if (simdpp::reduce_max(simdpp::min(vE, simdpp::sub_sat(simdpp::add_sat(vE, one_pack), h_open))) == 0)
+        {
+          is_done = true;
+          break;
+        }
+      }
+
+      if (is_done)
+        break;
+    }
+
+    long const row_max = simdpp::reduce_max(vMax);
+
+    if (row_max > best_score)
+    {
+      best_score = row_max;
+      best_row = i;
+      vH_best = vH;
+    }
+
+    std::swap(vH, vH_up);
+  }
+
+  res.score = best_score;
+  res.is_overflow = best_score + match + bias > max_val;
+
+  if (best_row == -1)
+    return res;
+
+  // Find the first column with the highest score in the best row
+  res.database_end = best_row + 1;
+  res.query_end = m;
+
+  for (long v = 0; v < t; ++v)
+  {
+    Tarr_uint vec;
+    simdpp::store_u(&vec[0], vH_best[v]);
+
+    for (long e = 0, j = v; j < m; j += t, ++e)
+    {
+      if (static_cast<long>(vec[e]) == best_score && j + 1 < res.query_end)
+        res.query_end = j + 1;
+    }
+  }
+
+  return res;
+}
+
+
+/// \short Finds the end of the best local alignment using 8-bit scores and 16-bit scores if those overflow
+inline LocalAlignmentEnd
+local_alignment_end(std::string const & q,
+                    std::string const & d,
+                    long const match,
+                    long const mismatch,
+                    long const gap_open,
+                    long const gap_extend,
+                    long const corner,
+                    SubstitutionMatrix const * const matrix = nullptr)
+{
+  LocalAlignmentEnd res = local_alignment_end<uint8_t>(q, d, match, mismatch, gap_open, gap_extend, corner, matrix);
+
+  if (res.is_overflow)
+    res = local_alignment_end<uint16_t>(q, d, match, mismatch, gap_open, gap_extend, corner, matrix);
+
+  return res;
+}
+
+
+/// \short Local (Smith-Waterman) alignment of seq1 (query) and seq2 (database).
+/// The end of the alignment is found with a striped SIMD kernel and its begin by aligning the reversed sequences
+/// from the end. If aligned strings are requested they are found by a global alignment of the aligned parts only.
+template <typename Tseq, typename Tuint>
+void
+local_alignment(Tseq const & seq1, // seq1 is query
+                Tseq const & seq2, // seq2 is database
+                AlignmentOptions<Tuint> & opt)
+{
+  assert(opt.get_alignment_results());
+  AlignmentResults<Tuint> & aln_results = *opt.get_alignment_results();
+
+  std::string const q(begin(seq1), end(seq1));
+  std::string const d(begin(seq2), end(seq2));
+  SubstitutionMatrix const * const matrix = opt.get_substitution_matrix();
+  long const match = matrix ? std::max(0l, matrix->get_max_score()) : static_cast<long>(opt.get_match());
+  long const mismatch = matrix ? std::max(0l, -matrix->get_min_score()) : static_cast<long>(opt.get_mismatch());
+  long const gap_open = opt.get_gap_open();
+  long const gap_extend = opt.get_gap_extend();
+
+  LocalAlignmentEnd const fw = local_alignment_end(q, d, match, mismatch, gap_open, gap_extend, 0, matrix);
+  aln_results.score = fw.score;
+  aln_results.query_begin = fw.query_end;
+  aln_results.query_end = fw.query_end;
+  aln_results.database_begin = fw.database_end;
+  aln_results.database_end = fw.database_end;
+  aln_results.is_overflow = fw.is_overflow;
+
+  if (fw.score > 0 && !fw.is_overflow)
+  {
+    // Align the reversed sequences from the end. The top-left cell has a score of one, so the cell that has a score
+    // one higher than the best score is the begin of an alignment which ends at the end found above.
+    std::string const q_rev(q.rbegin() + (q.size() - fw.query_end), q.rend());
+    std::string const d_rev(d.rbegin() + (d.size() - fw.database_end), d.rend());
+    LocalAlignmentEnd const rv = local_alignment_end(q_rev, d_rev, match, mismatch, gap_open, gap_extend, 1, matrix);
+    assert(rv.is_overflow || rv.score == fw.score + 1);
+    aln_results.query_begin = fw.query_end - rv.query_end;
+    aln_results.database_begin = fw.database_end - rv.database_end;
+    aln_results.is_overflow = rv.is_overflow;
+  }
+
+  if (opt.is_traceback())
+  {
+    Tseq const q_aligned(std::next(begin(seq1), aln_results.query_begin),
+                         std::next(begin(seq1), aln_results.query_end));
+    Tseq const d_aligned(std::next(begin(seq2), aln_results.database_begin),
+                         std::next(begin(seq2), aln_results.database_end));
+
+    AlignmentOptions<Tuint> aligned_opt(opt);
+    aligned_opt.left_column_free = false;
+    aligned_opt.right_column_free = false;
+    aligned_opt.top_row_free = false;
+    aligned_opt.bottom_row_free = false;
+    aligned_opt.band_width = -1;
+    aligned_opt.set_gap_open_2(0); // The end was found with the first gap cost only
+    aligned_opt.get_aligned_strings = opt.get_aligned_strings;
+    aligned_opt.get_cigar = opt.get_cigar;
+    paw::SIMDPP_ARCH_NAMESPACE::global_alignment(q_aligned, d_aligned, aligned_opt);
+
+    AlignmentResults<Tuint> & aligned_results = *aligned_opt.get_alignment_results();
+    assert(aln_results.is_overflow || aligned_results.score == aln_results.score);
+    aln_results.aligned_strings_ptr = std::move(aligned_results.aligned_strings_ptr);
+    aln_results.cigar = std::move(aligned_results.cigar);
+  }
+}
+
+
+} // namespace SIMDPP_ARCH_NAMESPACE
+} // namespace paw
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm> // std::max, std::min
+#include <cassert> // assert
+#include <limits> // std::numeric_limits
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/substitution_matrix.hpp>
+
+
+namespace paw
+{
+
+/// \short Returns the penalty of a gap of length k, which is the lower of the two gap costs when the options have two
+template <typename Tuint>
+inline long
+get_gap_penalty(AlignmentOptions<Tuint> const & opt, long const k)
+{
+  if (k == 0)
+    return 0;
+
+  long const gap_1 = static_cast<long>(opt.get_gap_open()) + (k - 1) * static_cast<long>(opt.get_gap_extend());
+
+  if (!opt.is_dual_gap())
+    return gap_1;
+
+  long const gap_2 = static_cast<long>(opt.get_gap_open_2()) + (k - 1) * static_cast<long>(opt.get_gap_extend_2());
+  return std::min(gap_1, gap_2);
+}
+
+
+/// \short Returns the score of aligning a query base to a database base. Without a substitution matrix, N matches any
+/// base.
+template <typename Tuint>
+inline long
+get_substitution_score(AlignmentOptions<Tuint> const & opt, char const q, char const d)
+{
+  if (SubstitutionMatrix const * matrix = opt.get_substitution_matrix())
+    return matrix->get_score(q, d);
+
+  if (q == d || q == 'N' || d == 'N')
+    return static_cast<long>(opt.get_match());
+
+  return -static_cast<long>(opt.get_mismatch());
+}
+
+
+/// \short Returns the score of the best global alignment of the query to the database, computed one cell at a time with
+/// Gotoh's algorithm. It uses the scores, gap costs, substitution matrix and free ends of the options, but is much
+/// slower than global_alignment. It is meant as a reference to check and benchmark the vectorized alignments against.
+template <typename Tuint>
+inline long
+get_reference_global_score(std::string const & query,
+                           std::string const & database,
+                           AlignmentOptions<Tuint> const & opt)
+{
+  long const NEG_INF = std::numeric_limits<long>::min() / 4;
+  long const m = query.size();
+  long const n = database.size();
+  bool const is_dual = opt.is_dual_gap();
+  long const gap_open = opt.get_gap_open();
+  long const gap_extend = opt.get_gap_extend();
+  long const gap_open_2 = opt.get_gap_open_2();
+  long const gap_extend_2 = opt.get_gap_extend_2();
+
+  // Rows are database bases and columns are query bases, like in global_alignment. F has the gaps in the query.
+  std::vector<long> H(m + 1);
+  std::vector<long> F(m + 1, NEG_INF);
+  std::vector<long> F2(m + 1, NEG_INF);
+
+  for (long j = 0; j <= m; ++j)
+    H[j] = opt.top_row_free ? 0 : -get_gap_penalty(opt, j);
+
+  long best = NEG_INF;
+
+  auto update_best_in_row =
+    [&](long const i)
+    {
+      if (opt.right_column_free || i == n)
+        best = std::max(best, H[m]);
+
+      if (opt.bottom_row_free && i == n)
+      {
+        for (long j = 0; j <= m; ++j)
+          best = std::max(best, H[j]);
+      }
+    };
+
+  update_best_in_row(0);
+
+  for (long i = 1; i <= n; ++i)
+  {
+    long h_diagonal = H[0];
+    H[0] = opt.left_column_free ? 0 : -get_gap_penalty(opt, i);
+    long E = NEG_INF;
+    long E2 = NEG_INF;
+
+    for (long j = 1; j <= m; ++j)
+    {
+      E = std::max(E - gap_extend, H[j - 1] - gap_open);
+      F[j] = std::max(F[j] - gap_extend, H[j] - gap_open);
+      long h = std::max({h_diagonal + get_substitution_score(opt, query[j - 1], database[i - 1]), E, F[j]});
+
+      if (is_dual)
+      {
+        E2 = std::max(E2 - gap_extend_2, H[j - 1] - gap_open_2);
+        F2[j] = std::max(F2[j] - gap_extend_2, H[j] - gap_open_2);
+        h = std::max({h, E2, F2[j]});
+      }
+
+      h_diagonal = H[j];
+      H[j] = h;
+    }
+
+    update_best_in_row(i);
+  }
+
+  return best;
+}
+
+
+/// \short Returns the score of aligned strings, where the first string is the query and the second the database. Gaps
+/// at the ends which are free in the options do not count, so the score is the score of the alignment they were traced
+/// back from.
+template <typename Tuint>
+inline long
+get_aligned_strings_score(std::pair<std::string, std::string> const & aligned_strings,
+                          AlignmentOptions<Tuint> const & opt)
+{
+  std::string const & q = aligned_strings.first;
+  std::string const & d = aligned_strings.second;
+  assert(q.size() == d.size());
+  long const size = q.size();
+  long score = 0;
+
+  for (long j = 0; j < size;)
+  {
+    if (q[j] != '-' && d[j] != '-')
+    {
+      score += get_substitution_score(opt, q[j], d[j]);
+      ++j;
+      continue;
+    }
+
+    // A run of gaps in one of the sequences
+    std::string const & gap_seq = q[j] == '-' ? q : d;
+    long k = 0;
+
+    while (j + k < size && gap_seq[j + k] == '-')
+      ++k;
+
+    bool const is_free = &gap_seq == &q ?
+                         (j == 0 && opt.left_column_free) || (j + k == size && opt.right_column_free) :
+                         (j == 0 && opt.top_row_free) || (j + k == size && opt.bottom_row_free);
+
+    if (!is_free)
+      score -= get_gap_penalty(opt, k);
+
+    j += k;
+  }
+
+  return score;
+}
+
+
+} // namespace paw
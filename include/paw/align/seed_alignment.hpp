@@ -0,0 +1,444 @@
+#pragma once
+
+#include <algorithm> // std::max, std::min
+#include <cstdint> // uint64_t
+#include <memory> // std::unique_ptr
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/global_alignment.hpp>
+
+
+namespace paw
+{
+
+/// \short A k-mer with the lowest hash in a window of consecutive k-mers of a sequence
+struct Minimizer
+{
+  uint64_t hash;
+  long pos; // Position of the first base of the k-mer
+};
+
+
+/// \short A k-mer which is both in the query and the database
+struct Anchor
+{
+  long query_pos;
+  long database_pos;
+};
+
+
+/// \short Returns the minimizers of every window of w consecutive k-mers in a sequence, in the order of their
+/// positions. K-mers with other bases than A, C, G and T are skipped. k can be at most 31.
+std::vector<Minimizer> get_minimizers(std::string const & seq, long k, long w);
+
+/// \short Returns the highest scoring chain of anchors of k-mers, where both the query and database positions
+/// increase. Anchors score the bases they add to the chain, and the difference in the distances between two anchors in
+/// the query and the database is penalized. Anchors further apart than max_gap are not chained.
+std::vector<Anchor> chain_anchors(std::vector<Anchor> anchors, long k, long max_gap);
+
+
+/// \short An index of the minimizers of a database sequence
+class MinimizerIndex
+{
+public:
+  /// \short Indexes the minimizers of a sequence. Minimizers found more than max_occurrences times are repetitive
+  /// and are not used as anchors.
+  MinimizerIndex(std::string const & seq, long k = 15, long w = 10, long max_occurrences = 64);
+
+  /// \short Returns the anchors of the minimizers of a query which are in the index
+  std::vector<Anchor> get_anchors(std::string const & query) const;
+
+  inline long
+  get_k() const {return k;}
+
+  inline long
+  get_w() const {return w;}
+
+private:
+  long k{15};
+  long w{10};
+  long max_occurrences{64};
+  std::vector<Minimizer> minimizers; // Sorted by hash and position
+};
+
+
+/// \short Aligns the query globally to a long database with the seeds of an index of the database. The anchors of the
+/// best chain are aligned as matches, and only the parts of the sequences between them are aligned with
+/// global_alignment. The parts before the first and after the last anchor are aligned to a window of the database
+/// when the left or right column is free, respectively. The results are set like the results of global_alignment of
+/// the whole sequences, and if there is no chain the whole sequences are aligned.
+template <typename Tuint>
+void
+seed_alignment(std::string const & query,
+               std::string const & database,
+               MinimizerIndex const & index,
+               AlignmentOptions<Tuint> & opts);
+
+
+template <typename Tuint>
+void
+seed_alignment(std::string const & query,
+               std::string const & database,
+               MinimizerIndex const & index,
+               AlignmentOptions<Tuint> & opt)
+{
+  long const m = query.size();
+  long const n = database.size();
+  long const k = index.get_k();
+  std::vector<Anchor> const chain = chain_anchors(index.get_anchors(query), k, 5000);
+
+  if (chain.empty())
+  {
+    paw::global_alignment(query, database, opt);
+    return;
+  }
+
+  // Anchors on the same diagonal are merged into longer matches and anchors overlapping the previous match are
+  // skipped, so the matches are separated by (possibly empty) parts of the sequences
+  struct Match
+  {
+    long query_pos;
+    long database_pos;
+    long length;
+  };
+
+  std::vector<Match> matches;
+
+  for (Anchor const & a : chain)
+  {
+    if (!matches.empty())
+    {
+      Match & prev = matches.back();
+
+      if (a.query_pos - a.database_pos == prev.query_pos - prev.database_pos &&
+          a.query_pos <= prev.query_pos + prev.length)
+      {
+        prev.length = a.query_pos + k - prev.query_pos;
+        continue;
+      }
+
+      if (a.query_pos < prev.query_pos + prev.length || a.database_pos < prev.database_pos + prev.length)
+        continue;
+    }
+
+    matches.push_back({a.query_pos, a.database_pos, k});
+  }
+
+  AlignmentResults<Tuint> & aln_results = *opt.get_alignment_results();
+  aln_results.score = 0;
+  aln_results.is_overflow = false;
+  aln_results.num_lazy_e_rows = 0;
+  aln_results.num_lazy_e_vectors = 0;
+  aln_results.last_row.num_rows = 0; // There is no row to continue from
+  std::vector<Cigar> & cigar = aln_results.cigar;
+  cigar.clear();
+
+  // The parts between the matches are aligned with a copy of the options, which only has the free ends of the first
+  // and last part
+  AlignmentOptions<Tuint> part_opt(opt);
+  part_opt.continuous_alignment = false;
+  part_opt.get_cigar = true;
+  part_opt.get_aligned_strings = false;
+  AlignmentResults<Tuint> const & part_results = *part_opt.get_alignment_results();
+
+  auto align_part =
+    [&](long const query_begin, long const query_end, long const database_begin, long const database_end,
+        bool const is_first, bool const is_last)
+    {
+      part_opt.left_column_free = is_first && opt.left_column_free;
+      part_opt.top_row_free = is_first && opt.top_row_free;
+      part_opt.right_column_free = is_last && opt.right_column_free;
+      part_opt.bottom_row_free = is_last && opt.bottom_row_free;
+
+      if (query_begin == query_end && database_begin == database_end)
+        return;
+
+      paw::global_alignment(query.substr(query_begin, query_end - query_begin),
+                            database.substr(database_begin, database_end - database_begin),
+                            part_opt);
+
+      aln_results.score += part_results.score;
+      aln_results.is_overflow |= part_results.is_overflow;
+      aln_results.num_lazy_e_rows += part_results.num_lazy_e_rows;
+      aln_results.num_lazy_e_vectors += part_results.num_lazy_e_vectors;
+
+      for (Cigar const & c : part_results.cigar)
+        add_cigar_operation(cigar, c.operation, c.count);
+    };
+
+  // Before the first match the database is cut to a window around the query, unless the left column is not free
+  {
+    Match const & first = matches.front();
+    long const margin = first.query_pos / 2 + 64;
+    long const window_begin = opt.left_column_free ?
+                              std::max(0l, first.database_pos - first.query_pos - margin) : 0;
+
+    if (window_begin > 0)
+      add_cigar_operation(cigar, INSERTION, window_begin);
+
+    align_part(0, first.query_pos, window_begin, first.database_pos, true, false);
+  }
+
+  for (long i = 0; i < static_cast<long>(matches.size()); ++i)
+  {
+    Match const & match = matches[i];
+    add_cigar_operation(cigar, SEQUENCE_MATCH, match.length);
+    aln_results.score += match.length * opt.get_match();
+
+    if (i + 1 < static_cast<long>(matches.size()))
+    {
+      Match const & next = matches[i + 1];
+      align_part(match.query_pos + match.length, next.query_pos,
+                 match.database_pos + match.length, next.database_pos,
+                 false, false);
+    }
+  }
+
+  {
+    Match const & last = matches.back();
+    long const query_begin = last.query_pos + last.length;
+    long const database_begin = last.database_pos + last.length;
+    long const margin = (m - query_begin) / 2 + 64;
+    long const window_end = opt.right_column_free ? std::min(n, database_begin + (m - query_begin) + margin) : n;
+    align_part(query_begin, m, database_begin, window_end, false, true);
+
+    if (window_end < n)
+      add_cigar_operation(cigar, INSERTION, n - window_end);
+  }
+
+  // Skipped bases at the ends of the alignment are at the ends of the CIGAR
+  aln_results.query_begin = 0;
+  aln_results.query_end = m;
+  aln_results.database_begin = 0;
+  aln_results.database_end = n;
+
+  if (opt.left_column_free && cigar.front().operation == INSERTION)
+    aln_results.database_begin = cigar.front().count;
+  else if (opt.top_row_free && cigar.front().operation == DELETION)
+    aln_results.query_begin = cigar.front().count;
+
+  if (opt.right_column_free && cigar.back().operation == INSERTION)
+    aln_results.database_end = n - cigar.back().count;
+  else if (opt.bottom_row_free && cigar.back().operation == DELETION)
+    aln_results.query_end = m - cigar.back().count;
+
+  if (opt.get_aligned_strings)
+  {
+    if (!aln_results.aligned_strings_ptr)
+      aln_results.aligned_strings_ptr = std::unique_ptr<std::pair<std::string, std::string> >(
+        new std::pair<std::string, std::string>());
+
+    get_aligned_strings(cigar, query, database, *aln_results.aligned_strings_ptr);
+  }
+}
+
+
+} // namespace paw
+
+
+#if defined(IMPLEMENT_PAW) || defined(__JETBRAINS_IDE__)
+
+#include <algorithm> // std::equal_range, std::min, std::reverse, std::sort
+#include <cstdlib> // std::abs, std::exit
+#include <deque> // std::deque
+#include <iostream> // std::cerr
+#include <iterator> // std::distance
+
+
+namespace
+{
+
+/// \short Invertible hash of a k-mer with 2 * k bits, so different k-mers have different hashes
+uint64_t
+hash_kmer(uint64_t key, uint64_t const mask)
+{
+  key = (~key + (key << 21)) & mask;
+  key = key ^ key >> 24;
+  key = ((key + (key << 3)) + (key << 8)) & mask;
+  key = key ^ key >> 14;
+  key = ((key + (key << 2)) + (key << 4)) & mask;
+  key = key ^ key >> 28;
+  key = (key + (key << 31)) & mask;
+  return key;
+}
+
+
+/// \short Returns the 2-bit code of a base, or 4 if it is not A, C, G or T
+long
+get_base_code(char const c)
+{
+  switch (c)
+  {
+  case 'A':
+  case 'a':
+    return 0;
+
+  case 'C':
+  case 'c':
+    return 1;
+
+  case 'G':
+  case 'g':
+    return 2;
+
+  case 'T':
+  case 't':
+    return 3;
+
+  default:
+    return 4;
+  }
+}
+
+
+} // anon namespace
+
+
+namespace paw
+{
+
+std::vector<Minimizer>
+get_minimizers(std::string const & seq, long const k, long const w)
+{
+  if (k < 1 || k > 31 || w < 1)
+  {
+    std::cerr << "ERROR: Minimizers need a k-mer size between 1 and 31 and a positive window size." << std::endl;
+    std::exit(1);
+  }
+
+  uint64_t const mask = (static_cast<uint64_t>(1) << (2 * k)) - 1;
+  std::vector<Minimizer> minimizers;
+  std::deque<Minimizer> window; // Increasing hashes of the k-mers which can still be the minimizer of a window
+  uint64_t kmer = 0;
+  long num_bases = 0; // Number of valid bases in a row
+
+  for (long i = 0; i < static_cast<long>(seq.size()); ++i)
+  {
+    long const code = get_base_code(seq[i]);
+
+    if (code == 4)
+    {
+      num_bases = 0;
+      window.clear();
+      continue;
+    }
+
+    kmer = ((kmer << 2) | code) & mask;
+    ++num_bases;
+
+    if (num_bases < k)
+      continue;
+
+    Minimizer const new_kmer{hash_kmer(kmer, mask), i - k + 1};
+
+    while (!window.empty() && window.back().hash > new_kmer.hash)
+      window.pop_back();
+
+    window.push_back(new_kmer);
+
+    while (window.front().pos <= new_kmer.pos - w)
+      window.pop_front();
+
+    // The window is full when it has w k-mers
+    if (num_bases >= k + w - 1 && (minimizers.empty() || minimizers.back().pos != window.front().pos))
+      minimizers.push_back(window.front());
+  }
+
+  return minimizers;
+}
+
+
+std::vector<Anchor>
+chain_anchors(std::vector<Anchor> anchors, long const k, long const max_gap)
+{
+  long const MAX_PREDECESSORS = 64; // Number of previous anchors which are checked as predecessors
+
+  std::sort(anchors.begin(), anchors.end(), [](Anchor const & a, Anchor const & b)
+    {
+      return a.database_pos < b.database_pos || (a.database_pos == b.database_pos && a.query_pos < b.query_pos);
+    });
+
+  long const num_anchors = anchors.size();
+  std::vector<long> scores(num_anchors, k);
+  std::vector<long> predecessors(num_anchors, -1);
+  long best = -1;
+
+  for (long i = 0; i < num_anchors; ++i)
+  {
+    for (long j = i - 1; j >= 0 && j >= i - MAX_PREDECESSORS; --j)
+    {
+      long const database_dist = anchors[i].database_pos - anchors[j].database_pos;
+      long const query_dist = anchors[i].query_pos - anchors[j].query_pos;
+
+      if (database_dist <= 0 || query_dist <= 0 || database_dist > max_gap || query_dist > max_gap)
+        continue;
+
+      long const diff = std::abs(database_dist - query_dist);
+      long const score = scores[j] + std::min(std::min(database_dist, query_dist), k) - (diff > 0 ? 1 + diff / 10 : 0);
+
+      if (score > scores[i])
+      {
+        scores[i] = score;
+        predecessors[i] = j;
+      }
+    }
+
+    if (best == -1 || scores[i] > scores[best])
+      best = i;
+  }
+
+  std::vector<Anchor> chain;
+
+  for (long i = best; i != -1; i = predecessors[i])
+    chain.push_back(anchors[i]);
+
+  std::reverse(chain.begin(), chain.end());
+  return chain;
+}
+
+
+MinimizerIndex::MinimizerIndex(std::string const & seq, long const _k, long const _w, long const _max_occurrences)
+  : k(_k)
+  , w(_w)
+  , max_occurrences(_max_occurrences)
+  , minimizers(get_minimizers(seq, _k, _w))
+{
+  std::sort(minimizers.begin(), minimizers.end(), [](Minimizer const & a, Minimizer const & b)
+    {
+      return a.hash < b.hash || (a.hash == b.hash && a.pos < b.pos);
+    });
+}
+
+
+std::vector<Anchor>
+MinimizerIndex::get_anchors(std::string const & query) const
+{
+  std::vector<Anchor> anchors;
+
+  for (Minimizer const & q_minimizer : get_minimizers(query, k, w))
+  {
+    auto const range = std::equal_range(minimizers.begin(), minimizers.end(), q_minimizer,
+                                        [](Minimizer const & a, Minimizer const & b)
+      {
+        return a.hash < b.hash;
+      });
+
+    if (std::distance(range.first, range.second) > max_occurrences)
+      continue;
+
+    for (auto it = range.first; it != range.second; ++it)
+      anchors.push_back({q_minimizer.pos, it->pos});
+  }
+
+  return anchors;
+}
+
+
+} // namespace paw
+
+#endif // IMPLEMENT_PAW
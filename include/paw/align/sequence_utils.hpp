@@ -1,48 +1,88 @@
 #pragma once
 
-#include <sstream>
-#include <string>
+#include <array> // std::array
+#include <cstdlib> // std::exit
+#include <iostream> // std::cerr
+#include <string> // std::string
 
 namespace paw
 {
 
-std::string
-reverse_complement(std::string const & sequence)
+/// \short Returns a table with the complement of each base, or 0 for characters which are not bases. Lower case bases
+/// are complemented to upper case bases.
+inline std::array<char, 256> const &
+get_complement_table()
 {
-  std::ostringstream r;
+  static std::array<char, 256> const table = []()
+                                             {
+                                               std::array<char, 256> t;
+                                               t.fill(0);
+                                               t['A'] = 'T'; t['a'] = 'T';
+                                               t['C'] = 'G'; t['c'] = 'G';
+                                               t['G'] = 'C'; t['g'] = 'C';
+                                               t['T'] = 'A'; t['t'] = 'A';
+                                               t['N'] = 'N'; t['n'] = 'N';
+                                               return t;
+                                             }();
 
-  for (auto it = sequence.rbegin(); it != sequence.rend(); ++it)
-  {
-    switch (*it)
-    {
-    case 'A':
-    case 'a':
-      r << 'T'; break;
+  return table;
+}
 
-    case 'C':
-    case 'c':
-      r << 'G'; break;
 
-    case 'G':
-    case 'g':
-      r << 'C'; break;
+inline char
+complement_base(char const base)
+{
+  char const c = get_complement_table()[static_cast<unsigned char>(base)];
 
-    case 'T':
-    case 't':
-      r << 'A'; break;
+  if (c == 0)
+  {
+    std::cerr << "ERROR: Unexpected base: " << base << std::endl;
+    std::exit(1);
+  }
+
+  return c;
+}
 
-    case 'N':
-    case 'n':
-      r << 'N'; break;
 
-    default:
-      std::cerr << "Unexpected base: " << *it << std::endl;
-      std::exit(1);
+/// \short Reverse complements a sequence in place, swapping the complements of the bases from both ends
+template <typename Tseq>
+inline void
+reverse_complement_in_place(Tseq & seq)
+{
+  long i = 0;
+  long j = static_cast<long>(seq.size()) - 1;
 
-    }
+  for (; i < j; ++i, --j)
+  {
+    char const c = complement_base(seq[i]);
+    seq[i] = complement_base(seq[j]);
+    seq[j] = c;
   }
 
-  return r.str();
+  if (i == j)
+    seq[i] = complement_base(seq[i]);
+}
+
+
+/// \short Writes the reverse complement of a sequence to out, which keeps its memory between calls
+template <typename Tseq>
+inline void
+reverse_complement(Tseq const & seq, Tseq & out)
+{
+  long const size = seq.size();
+  out.resize(size);
+
+  for (long i = 0; i < size; ++i)
+    out[size - 1 - i] = complement_base(seq[i]);
+}
+
+
+inline std::string
+reverse_complement(std::string const & seq)
+{
+  std::string r;
+  reverse_complement(seq, r);
+  return r;
 }
 
 
@@ -196,7 +196,7 @@ Skyr::find_all_edits(bool const is_normalize)
   Tscores scores(seqs.size(), std::numeric_limits<long>::min());
   using Tuint = uint8_t;
   AlignmentOptions<Tuint> opts;
-  opts.get_aligned_strings = true;
+  opts.get_cigar = true;
 
   while (std::find(is_done.begin() + 1, is_done.end(), 0) != is_done.end())
   {
@@ -220,10 +220,7 @@ Skyr::find_all_edits(bool const is_normalize)
       assert(ar);
       scores[i] = ar->score;
 
-      assert(ar->aligned_strings_ptr);
-      auto const & aligned_strings = *(ar->aligned_strings_ptr);
-      //std::cerr << aligned_strings.first << "\n" << aligned_strings.second << "\n";
-      edits[i] = get_edit_script(aligned_strings, is_normalize, false);
+      edits[i] = get_edit_script(ar->cigar, seqs[0], seqs[i], is_normalize, false);
       all_edits.insert(edits[i].begin(), edits[i].end());
     }
 
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm> // std::copy, std::max_element, std::min_element
+#include <array> // std::array
+#include <cctype> // std::isupper, std::tolower
+#include <cstdlib> // std::exit
+#include <fstream> // std::ifstream
+#include <iostream> // std::cerr
+#include <istream> // std::istream
+#include <sstream> // std::istringstream
+#include <string> // std::string
+#include <vector> // std::vector
+
+
+namespace paw
+{
+
+/// \short Scores of aligning each pair of symbols of an alphabet, e.g. BLOSUM or PAM matrices of amino acids.
+/// Characters which are not in the alphabet are scored as its last symbol, which is '*' in the NCBI matrices and
+/// 'N' in the IUPAC DNA matrix. Lowercase characters are scored as uppercase ones unless they are in the alphabet.
+class SubstitutionMatrix
+{
+private:
+  std::string alphabet; // Symbols in the order of the rows and columns of the matrix
+  std::vector<long> scores; // Scores of the matrix, row by row
+  std::array<long, 256> symbol_indexes; // Index of the symbol of each character
+
+public:
+  SubstitutionMatrix();
+  SubstitutionMatrix(std::string const & alphabet, std::vector<long> const & scores);
+
+  /// \short Reads a matrix in the NCBI text format, i.e. a header line with the symbols of the columns followed by
+  /// one line per row starting with its symbol. Lines starting with '#' are comments.
+  void read(std::istream & is);
+  void load(std::string const & fn);
+
+  inline bool
+  empty() const {return alphabet.empty();}
+
+  inline std::string const &
+  get_alphabet() const {return alphabet;}
+
+  inline long
+  get_alphabet_size() const {return static_cast<long>(alphabet.size());}
+
+  /// \short Returns the index of the symbol of a character
+  inline long
+  get_index(char const c) const {return symbol_indexes[static_cast<unsigned char>(c)];}
+
+  /// \short Returns the score of aligning the symbols with indexes i and j
+  inline long
+  get_score_by_index(long const i, long const j) const {return scores[i * alphabet.size() + j];}
+
+  /// \short Returns the score of aligning characters a and b
+  inline long
+  get_score(char const a, char const b) const {return get_score_by_index(get_index(a), get_index(b));}
+
+  long get_max_score() const;
+  long get_min_score() const;
+
+};
+
+
+/// \short Returns the BLOSUM62 matrix of amino acids
+inline SubstitutionMatrix get_blosum62_matrix();
+
+/// \short Returns a matrix of the IUPAC nucleotide codes. Two codes match if they have any base in common, so for
+/// example N matches every base and R (A or G) matches A, G and S (C or G). The mismatch is a penalty, like in the
+/// alignment options.
+inline SubstitutionMatrix get_iupac_dna_matrix(long match, long mismatch);
+
+
+} // namespace paw
+
+
+namespace paw
+{
+
+inline
+SubstitutionMatrix::SubstitutionMatrix()
+{
+  symbol_indexes.fill(0);
+}
+
+
+inline
+SubstitutionMatrix::SubstitutionMatrix(std::string const & _alphabet, std::vector<long> const & _scores)
+  : alphabet(_alphabet)
+  , scores(_scores)
+{
+  if (alphabet.empty() || scores.size() != alphabet.size() * alphabet.size())
+  {
+    std::cerr << "ERROR: A substitution matrix of " << alphabet.size() << " symbols cannot have " << scores.size()
+              << " scores." << std::endl;
+    std::exit(1);
+  }
+
+  symbol_indexes.fill(alphabet.size() - 1);
+
+  for (long i = 0; i < static_cast<long>(alphabet.size()); ++i)
+    symbol_indexes[static_cast<unsigned char>(alphabet[i])] = i;
+
+  // Lowercase characters have the index of their uppercase symbol unless they are symbols themselves
+  for (long i = 0; i < static_cast<long>(alphabet.size()); ++i)
+  {
+    char const lower = static_cast<char>(std::tolower(static_cast<unsigned char>(alphabet[i])));
+
+    if (std::isupper(static_cast<unsigned char>(alphabet[i])) && alphabet.find(lower) == std::string::npos)
+      symbol_indexes[static_cast<unsigned char>(lower)] = i;
+  }
+}
+
+
+inline void
+SubstitutionMatrix::read(std::istream & is)
+{
+  std::string columns;
+  std::string rows;
+  std::vector<std::vector<long> > row_scores;
+  std::string line;
+
+  while (std::getline(is, line))
+  {
+    std::istringstream ss(line);
+    std::string symbol;
+
+    if (!(ss >> symbol) || symbol[0] == '#')
+      continue;
+
+    if (symbol.size() != 1)
+    {
+      std::cerr << "ERROR: Unexpected symbol '" << symbol << "' in a substitution matrix." << std::endl;
+      std::exit(1);
+    }
+
+    if (columns.empty())
+    {
+      // The header line with the symbols of the columns
+      do
+      {
+        columns.push_back(symbol[0]);
+      } while (ss >> symbol);
+
+      continue;
+    }
+
+    rows.push_back(symbol[0]);
+    row_scores.emplace_back();
+    long score;
+
+    while (ss >> score)
+      row_scores.back().push_back(score);
+
+    if (row_scores.back().size() != columns.size())
+    {
+      std::cerr << "ERROR: Row '" << symbol << "' of a substitution matrix has " << row_scores.back().size()
+                << " scores but there are " << columns.size() << " columns." << std::endl;
+      std::exit(1);
+    }
+  }
+
+  if (columns.empty() || rows.size() != columns.size())
+  {
+    std::cerr << "ERROR: A substitution matrix must have the same symbols in its rows and columns." << std::endl;
+    std::exit(1);
+  }
+
+  // The rows are stored in the order of the columns
+  std::vector<long> new_scores(columns.size() * columns.size());
+
+  for (long r = 0; r < static_cast<long>(rows.size()); ++r)
+  {
+    std::size_t const i = columns.find(rows[r]);
+
+    if (i == std::string::npos)
+    {
+      std::cerr << "ERROR: Row '" << rows[r] << "' of a substitution matrix has no column." << std::endl;
+      std::exit(1);
+    }
+
+    std::copy(row_scores[r].begin(), row_scores[r].end(), new_scores.begin() + i * columns.size());
+  }
+
+  *this = SubstitutionMatrix(columns, new_scores);
+}
+
+
+inline void
+SubstitutionMatrix::load(std::string const & fn)
+{
+  std::ifstream ifs(fn);
+
+  if (!ifs.is_open())
+  {
+    std::cerr << "ERROR: Could not open substitution matrix " << fn << std::endl;
+    std::exit(1);
+  }
+
+  read(ifs);
+}
+
+
+inline long
+SubstitutionMatrix::get_max_score() const
+{
+  return scores.empty() ? 0 : *std::max_element(scores.begin(), scores.end());
+}
+
+
+inline long
+SubstitutionMatrix::get_min_score() const
+{
+  return scores.empty() ? 0 : *std::min_element(scores.begin(), scores.end());
+}
+
+
+inline SubstitutionMatrix
+get_blosum62_matrix()
+{
+  std::istringstream ss(
+    "#  Matrix made by matblas from blosum62.iij\n"
+    "   A  R  N  D  C  Q  E  G  H  I  L  K  M  F  P  S  T  W  Y  V  B  Z  X  *\n"
+    "A  4 -1 -2 -2  0 -1 -1  0 -2 -1 -1 -1 -1 -2 -1  1  0 -3 -2  0 -2 -1  0 -4\n"
+    "R -1  5  0 -2 -3  1  0 -2  0 -3 -2  2 -1 -3 -2 -1 -1 -3 -2 -3 -1  0 -1 -4\n"
+    "N -2  0  6  1 -3  0  0  0  1 -3 -3  0 -2 -3 -2  1  0 -4 -2 -3  3  0 -1 -4\n"
+    "D -2 -2  1  6 -3  0  2 -1 -1 -3 -4 -1 -3 -3 -1  0 -1 -4 -3 -3  4  1 -1 -4\n"
+    "C  0 -3 -3 -3  9 -3 -4 -3 -3 -1 -1 -3 -1 -2 -3 -1 -1 -2 -2 -1 -3 -3 -2 -4\n"
+    "Q -1  1  0  0 -3  5  2 -2  0 -3 -2  1  0 -3 -1  0 -1 -2 -1 -2  0  3 -1 -4\n"
+    "E -1  0  0  2 -4  2  5 -2  0 -3 -3  1 -2 -3 -1  0 -1 -3 -2 -2  1  4 -1 -4\n"
+    "G  0 -2  0 -1 -3 -2 -2  6 -2 -4 -4 -2 -3 -3 -2  0 -2 -2 -3 -3 -1 -2 -1 -4\n"
+    "H -2  0  1 -1 -3  0  0 -2  8 -3 -3 -1 -2 -1 -2 -1 -2 -2  2 -3  0  0 -1 -4\n"
+    "I -1 -3 -3 -3 -1 -3 -3 -4 -3  4  2 -3  1  0 -3 -2 -1 -3 -1  3 -3 -3 -1 -4\n"
+    "L -1 -2 -3 -4 -1 -2 -3 -4 -3  2  4 -2  2  0 -3 -2 -1 -2 -1  1 -4 -3 -1 -4\n"
+    "K -1  2  0 -1 -3  1  1 -2 -1 -3 -2  5 -1 -3 -1  0 -1 -3 -2 -2  0  1 -1 -4\n"
+    "M -1 -1 -2 -3 -1  0 -2 -3 -2  1  2 -1  5  0 -2 -1 -1 -1 -1  1 -3 -1 -1 -4\n"
+    "F -2 -3 -3 -3 -2 -3 -3 -3 -1  0  0 -3  0  6 -4 -2 -2  1  3 -1 -3 -3 -1 -4\n"
+    "P -1 -2 -2 -1 -3 -1 -1 -2 -2 -3 -3 -1 -2 -4  7 -1 -1 -4 -3 -2 -2 -1 -2 -4\n"
+    "S  1 -1  1  0 -1  0  0  0 -1 -2 -2  0 -1 -2 -1  4  1 -3 -2 -2  0  0  0 -4\n"
+    "T  0 -1  0 -1 -1 -1 -1 -2 -2 -1 -1 -1 -1 -2 -1  1  5 -2 -2  0 -1 -1  0 -4\n"
+    "W -3 -3 -4 -4 -2 -2 -3 -2 -2 -3 -2 -3 -1  1 -4 -3 -2 11  2 -3 -4 -3 -2 -4\n"
+    "Y -2 -2 -2 -3 -2 -1 -2 -3  2 -1 -1 -2 -1  3 -3 -2 -2  2  7 -1 -3 -2 -1 -4\n"
+    "V  0 -3 -3 -3 -1 -2 -2 -3 -3  3  1 -2  1 -1 -2 -2  0 -3 -1  4 -3 -2 -1 -4\n"
+    "B -2 -1  3  4 -3  0  1 -1  0 -3 -4  0 -3 -3 -2  0 -1 -4 -3 -3  4  1 -1 -4\n"
+    "Z -1  0  0  1 -3  3  4 -2  0 -3 -3  1 -1 -3 -1  0 -1 -3 -2 -2  1  4 -1 -4\n"
+    "X  0 -1 -1 -1 -2 -1 -1 -1 -1 -1 -1 -1 -1 -1 -2  0  0 -2 -1 -1 -1 -1 -1 -4\n"
+    "* -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4 -4  1\n");
+
+  SubstitutionMatrix matrix;
+  matrix.read(ss);
+  return matrix;
+}
+
+
+inline SubstitutionMatrix
+get_iupac_dna_matrix(long const match, long const mismatch)
+{
+  std::string const alphabet = "ACGTRYSWKMBDHVN";
+
+  // Bases of each code, one bit per base in the order A, C, G and T
+  std::array<int, 15> constexpr BASES = {{1, 2, 4, 8, 5, 10, 6, 9, 12, 3, 14, 13, 11, 7, 15}};
+  std::vector<long> scores;
+  scores.reserve(alphabet.size() * alphabet.size());
+
+  for (long i = 0; i < static_cast<long>(alphabet.size()); ++i)
+  {
+    for (long j = 0; j < static_cast<long>(alphabet.size()); ++j)
+      scores.push_back((BASES[i] & BASES[j]) != 0 ? match : -mismatch);
+  }
+
+  return SubstitutionMatrix(alphabet, scores);
+}
+
+
+} // namespace paw
+
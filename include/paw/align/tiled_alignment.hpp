@@ -0,0 +1,394 @@
+#pragma once
+
+#include <paw/align/alignment_cache.hpp>
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/global_alignment.hpp>
+#include <paw/align/libsimdpp_backtracker.hpp>
+#include <paw/align/libsimdpp_utils.hpp>
+#include <paw/align/substitution_matrix.hpp>
+#include <paw/station/station.hpp>
+
+#include <simdpp/simd.h>
+
+#include <algorithm> // std::max, std::min
+#include <cassert> // assert
+#include <cstdint> // uint8_t
+#include <iterator> // std::distance, std::next
+#include <limits> // std::numeric_limits
+#include <memory> // std::unique_ptr
+#include <utility> // std::swap
+#include <vector> // std::vector
+
+
+namespace paw
+{
+namespace SIMDPP_ARCH_NAMESPACE
+{
+
+/// \short Backtrack of a score matrix which was computed in tiles. Cells are looked up in the backtrack of the tile
+/// they are in, where column 0 of each tile is the right column of the tile to its left and is never looked up.
+template <typename Tuint>
+struct TiledBacktrack
+{
+  std::vector<Backtrack<Tuint> > const & tiles; // Backtracks of each tile, one row of tiles after another
+  std::vector<long> const & row_begins; // First database row of each row of tiles, and the number of rows at the end
+  std::vector<long> const & column_begins; // First query column of each column of tiles, and the query size
+
+  TiledBacktrack(std::vector<Backtrack<Tuint> > const & _tiles,
+                 std::vector<long> const & _row_begins,
+                 std::vector<long> const & _column_begins)
+    : tiles(_tiles)
+    , row_begins(_row_begins)
+    , column_begins(_column_begins)
+  {}
+
+
+  /// \short Returns the backtrack of the tile with cell (i, j), which are 1-based like in is_del_at, and sets i and j
+  /// to the cell in the tile
+  inline Backtrack<Tuint> const &
+  get_tile(long & i, long & j) const
+  {
+    assert(i >= 1);
+    assert(j >= 1);
+    long const a = std::distance(row_begins.begin(),
+                                 std::lower_bound(row_begins.begin() + 1, row_begins.end(), i)) - 1;
+    long const b = std::distance(column_begins.begin(),
+                                 std::lower_bound(column_begins.begin() + 1, column_begins.end(), j)) - 1;
+    long const num_column_tiles = column_begins.size() - 1;
+    i -= row_begins[a];
+    j -= column_begins[b];
+    return tiles[a * num_column_tiles + b];
+  }
+
+
+  bool inline
+  is_del_at(long i, long j) const
+  {
+    Backtrack<Tuint> const & mB = get_tile(i, j);
+    return mB.is_del_at(i, j);
+  }
+
+
+  bool inline
+  is_ins_at(long i, long j) const
+  {
+    Backtrack<Tuint> const & mB = get_tile(i, j);
+    return mB.is_ins_at(i, j);
+  }
+
+
+  bool inline
+  is_del_extend_at(long i, long j) const
+  {
+    Backtrack<Tuint> const & mB = get_tile(i, j);
+    return mB.is_del_extend_at(i, j);
+  }
+
+
+  bool inline
+  is_ins_extend_at(long i, long j) const
+  {
+    Backtrack<Tuint> const & mB = get_tile(i, j);
+    return mB.is_ins_extend_at(i, j);
+  }
+
+
+  bool inline
+  is_del2_at(long i, long j) const
+  {
+    Backtrack<Tuint> const & mB = get_tile(i, j);
+    return mB.is_del2_at(i, j);
+  }
+
+
+  bool inline
+  is_ins2_at(long i, long j) const
+  {
+    Backtrack<Tuint> const & mB = get_tile(i, j);
+    return mB.is_ins2_at(i, j);
+  }
+
+
+  bool inline
+  is_del2_extend_at(long i, long j) const
+  {
+    Backtrack<Tuint> const & mB = get_tile(i, j);
+    return mB.is_del2_extend_at(i, j);
+  }
+
+
+  bool inline
+  is_ins2_extend_at(long i, long j) const
+  {
+    Backtrack<Tuint> const & mB = get_tile(i, j);
+    return mB.is_ins2_extend_at(i, j);
+  }
+
+
+};
+
+
+/// \short Returns where each of num_tiles tiles begins when size rows or columns are split into tiles of
+/// tile_size, with size at the end. If tile_size is 0, the size is split evenly into num_tiles tiles.
+inline std::vector<long>
+get_tile_begins(long const size, long const tile_size, long num_tiles)
+{
+  if (tile_size > 0)
+    num_tiles = (size + tile_size - 1) / tile_size;
+
+  num_tiles = std::max(1l, std::min(num_tiles, size));
+  std::vector<long> begins(num_tiles + 1);
+
+  for (long k = 0; k <= num_tiles; ++k)
+    begins[k] = tile_size > 0 ? std::min(k * tile_size, size) : k * size / num_tiles;
+
+  return begins;
+}
+
+
+/// \short Aligns the query (seq1) globally to the database (seq2) like global_alignment, but splits the score matrix
+/// into tiles which are computed on opt.num_threads threads of a paw::Station. Tiles depend on the tiles above and to
+/// the left of them, so the tiles of each anti-diagonal are computed in parallel after the previous anti-diagonal.
+/// Each tile starts from the bottom row of the tile above it and gets column 0 of each row from the right column of
+/// the tile to its left, which are exchanged as scores so the tiles can reduce their scores independently. The
+/// backtracks of all tiles are kept in memory.
+template <typename Tseq, typename Tuint>
+void
+tiled_global_alignment(Tseq const & seq1, // seq1 is query
+                       Tseq const & seq2, // seq2 is database
+                       AlignmentOptions<Tuint> & opt)
+{
+  using Tarr_uint = typename T<Tuint>::arr_uint;
+  using Tvec_pack = typename T<Tuint>::vec_pack;
+
+  long const m = std::distance(seq1.begin(), seq1.end());
+  long const n = std::distance(seq2.begin(), seq2.end());
+  assert(m > 0);
+  assert(n > 0);
+
+  // Each thread gets a column of tiles unless the tile size is set. There are more rows of tiles than columns, so
+  // most anti-diagonals have a tile for every column.
+  long const num_threads = std::max(1l, opt.num_threads);
+  std::vector<long> const column_begins = get_tile_begins(m, opt.tile_size, num_threads);
+  std::vector<long> const row_begins = get_tile_begins(n, opt.tile_size, 8 * num_threads);
+  long const num_column_tiles = column_begins.size() - 1;
+  long const num_row_tiles = row_begins.size() - 1;
+
+  assert(opt.get_alignment_results());
+  AlignmentResults<Tuint> & aln_results = *opt.get_alignment_results();
+  bool const is_dual_gap = opt.is_dual_gap();
+  bool const is_traceback = opt.is_traceback();
+  SubstitutionMatrix const * const matrix = opt.get_substitution_matrix();
+
+  // The database is encoded once and the codes are shared by the tiles of all threads
+  std::vector<uint8_t> database_codes;
+  paw::SIMDPP_ARCH_NAMESPACE::set_database_codes(database_codes, seq2, matrix);
+
+  // Tiles of each column have options where only the sides of the score matrix can be free. Tiles of the same column
+  // are never computed at the same time, so they also share the results which count the lazy deletions.
+  std::vector<std::unique_ptr<AlignmentOptions<Tuint> > > column_opts;
+
+  for (long b = 0; b < num_column_tiles; ++b)
+  {
+    column_opts.emplace_back(new AlignmentOptions<Tuint>(opt));
+    column_opts[b]->left_column_free = opt.left_column_free && b == 0;
+    column_opts[b]->right_column_free = opt.right_column_free && b == num_column_tiles - 1;
+  }
+
+  auto get_top_row_score =
+    [&](long const j) -> long
+    {
+      if (j == 0 || opt.top_row_free)
+        return 0;
+
+      long const gap_1 = static_cast<long>(opt.get_gap_open()) + (j - 1) * opt.get_gap_extend();
+
+      if (!is_dual_gap)
+        return -gap_1;
+
+      long const gap_2 = static_cast<long>(opt.get_gap_open_2()) + (j - 1) * opt.get_gap_extend_2();
+      return -std::min(gap_1, gap_2);
+    };
+
+  // The row below the last computed tile of each column, which begins as the top row of the score matrix
+  std::vector<AlignmentRow> bottom_rows(num_column_tiles);
+
+  {
+    long const no_insertion = std::numeric_limits<long>::min() / 2;
+
+    for (long b = 0; b < num_column_tiles; ++b)
+    {
+      AlignmentRow & row = bottom_rows[b];
+
+      for (long j = column_begins[b]; j <= column_begins[b + 1]; ++j)
+        row.scores.push_back(get_top_row_score(j));
+
+      row.insertion_scores.assign(row.scores.size(), no_insertion);
+
+      if (is_dual_gap)
+        row.insertion_scores_2.assign(row.scores.size(), no_insertion);
+    }
+  }
+
+  // Right column of the tiles in each column, which is column 0 of the tiles to their right, by database row
+  std::vector<std::vector<long> > right_H(num_column_tiles, std::vector<long>(n + 1));
+  std::vector<std::vector<long> > right_E(num_column_tiles, std::vector<long>(n + 1));
+  std::vector<std::vector<long> > right_E2(num_column_tiles, std::vector<long>(is_dual_gap ? n + 1 : 0));
+  std::vector<Backtrack<Tuint> > tiles(is_traceback ? num_row_tiles * num_column_tiles : 0);
+
+  // Computes tile (a, b) with the alignment cache of the thread it runs on
+  auto compute_tile =
+    [&](long const a, long const b)
+    {
+      AlignmentOptions<Tuint> & tile_opt = *column_opts[b];
+      AlignmentCache<Tuint> & aln_cache = get_thread_alignment_cache<Tuint>();
+      Tseq const tile_query(std::next(seq1.begin(), column_begins[b]), std::next(seq1.begin(), column_begins[b + 1]));
+      paw::SIMDPP_ARCH_NAMESPACE::set_query<Tuint, Tseq>(tile_opt, aln_cache, tile_query);
+      paw::SIMDPP_ARCH_NAMESPACE::set_rows_up(aln_cache, bottom_rows[b]);
+
+      long const w = aln_cache.query_size;
+      long const t = aln_cache.num_vectors;
+      long const right_v = w % t;
+      long const right_e = w / t;
+      long const row_begin = row_begins[a];
+      long const h = row_begins[a + 1] - row_begin;
+
+      if (is_traceback)
+        std::swap(aln_cache.mB, tiles[a * num_column_tiles + b]);
+
+      aln_cache.mB.reset(is_traceback ? h : 0, t, aln_cache.get_backtrack_bits());
+      GlobalAlignmentRow<Tuint> const alignment_row =
+        get_global_alignment_row<Tuint>(is_dual_gap,
+                                        tile_opt.left_column_free || tile_opt.right_column_free,
+                                        is_traceback);
+      aln_cache.is_left_boundary = b > 0;
+
+      Tvec_pack & vH = aln_cache.vH;
+      Tvec_pack & vF = aln_cache.vF;
+      Tvec_pack & vE = aln_cache.vE;
+      vH.assign(static_cast<std::size_t>(t), simdpp::make_int(
+                  2 * aln_cache.gap_open_val + std::numeric_limits<Tuint>::min()));
+      vF.assign(aln_cache.vF_up.begin(), aln_cache.vF_up.end());
+      vE.assign(aln_cache.vF_up.begin(), aln_cache.vF_up.end());
+
+      if (is_dual_gap)
+      {
+        aln_cache.vF2.assign(aln_cache.vF2_up.begin(), aln_cache.vF2_up.end());
+        aln_cache.vE2.assign(aln_cache.vF2_up.begin(), aln_cache.vF2_up.end());
+      }
+
+      // Returns the score of the right column in pack vX of row k of the tile
+      auto get_right_score =
+        [&](Tvec_pack const & vX, long const k) -> long
+        {
+          Tarr_uint arr;
+          simdpp::store_u(&arr[0], vX[right_v]);
+          return static_cast<long>(arr[right_e]) + aln_cache.reductions[right_e] - aln_cache.x_gain * w -
+                 aln_cache.y_gain * k;
+        };
+
+      for (long k = 1; k <= h; ++k)
+      {
+        long const i = row_begin + k;
+
+        if (b > 0)
+        {
+          aln_cache.left_boundary_H = right_H[b - 1][i] + aln_cache.y_gain * k;
+          aln_cache.left_boundary_E = right_E[b - 1][i] + aln_cache.y_gain * k;
+
+          if (is_dual_gap)
+            aln_cache.left_boundary_E2 = right_E2[b - 1][i] + aln_cache.y_gain * k;
+        }
+
+        Tvec_pack const & vW = aln_cache.W_profile[database_codes[i - 1]];
+
+        // The row is numbered in the whole score matrix, so the insertions from the tile above are extended
+        alignment_row(tile_opt, aln_cache, *tile_opt.get_alignment_results(), vW, i - 1, k - 1, vH, vF, vE);
+
+        right_H[b][i] = get_right_score(aln_cache.vH_up, k);
+        right_E[b][i] = get_right_score(vE, k);
+
+        if (is_dual_gap)
+          right_E2[b][i] = get_right_score(aln_cache.vE2, k);
+      }
+
+      AlignmentRow & bottom_row = bottom_rows[b];
+      aln_cache.reduce_every_element(-h * aln_cache.y_gain);
+      get_score_row(aln_cache, 0, aln_cache.vH_up, bottom_row.scores);
+      get_score_row(aln_cache, 0, aln_cache.vF_up, bottom_row.insertion_scores);
+
+      if (is_dual_gap)
+        get_score_row(aln_cache, 0, aln_cache.vF2_up, bottom_row.insertion_scores_2);
+
+      aln_cache.is_left_boundary = false;
+
+      if (is_traceback)
+        std::swap(aln_cache.mB, tiles[a * num_column_tiles + b]);
+    };
+
+  /// Start of the wavefront over the anti-diagonals of tiles
+  for (long d = 0; d < num_row_tiles + num_column_tiles - 1; ++d)
+  {
+    long const b_begin = std::max(0l, d - num_row_tiles + 1);
+    long const b_end = std::min(num_column_tiles, d + 1);
+    Station station(std::min(num_threads, b_end - b_begin));
+
+    // The main thread runs every num_threads-th tile when it is added, which is the last one unless there are more
+    // tiles than threads
+    for (long b = b_begin; b < b_end; ++b)
+      station.add_to_thread(b - b_begin, compute_tile, d - b, b);
+
+    station.join();
+  } /// End of the wavefront
+
+  aln_results.num_lazy_e_rows = 0;
+  aln_results.num_lazy_e_vectors = 0;
+
+  for (auto const & tile_opt : column_opts)
+  {
+    aln_results.num_lazy_e_rows += tile_opt->get_alignment_results()->num_lazy_e_rows;
+    aln_results.num_lazy_e_vectors += tile_opt->get_alignment_results()->num_lazy_e_vectors;
+  }
+
+  aln_results.query_end = m;
+  aln_results.database_end = n;
+  aln_results.score = bottom_rows.back().scores.back();
+
+  if (opt.bottom_row_free)
+  {
+    // Select the right-most column with the highest score in the last row
+    for (long b = num_column_tiles - 1; b >= 0; --b)
+    {
+      std::vector<long> const & scores = bottom_rows[b].scores;
+
+      for (long j = scores.size() - 1; j >= 0; --j)
+      {
+        if (scores[j] > aln_results.score)
+        {
+          aln_results.score = scores[j];
+          aln_results.query_end = column_begins[b] + j;
+        }
+      }
+    }
+  }
+
+  if (opt.right_column_free && aln_results.query_end == m)
+  {
+    // The alignment ends in the first row with the best score of the right column
+    std::vector<long> & right_column = right_H.back();
+    right_column[0] = get_top_row_score(m);
+    aln_results.database_end = std::distance(right_column.begin(),
+                                             std::max_element(right_column.begin(), right_column.end()));
+  }
+
+  if (is_traceback)
+  {
+    TiledBacktrack<Tuint> const mB(tiles, row_begins, column_begins);
+    aln_results.traceback(mB, seq1, seq2, opt.get_aligned_strings);
+  }
+}
+
+
+} // namespace SIMDPP_ARCH_NAMESPACE
+} // namespace paw
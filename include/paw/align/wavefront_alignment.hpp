@@ -0,0 +1,456 @@
+#pragma once
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/libsimdpp_utils.hpp>
+
+#include <simdpp/simd.h>
+
+#include <algorithm> // std::max, std::reverse
+#include <cassert> // assert
+#include <cstdint> // uint8_t
+#include <cstdlib> // std::abs
+#include <initializer_list> // std::initializer_list
+#include <iterator> // std::distance
+#include <limits> // std::numeric_limits
+#include <memory> // std::unique_ptr
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+
+namespace paw
+{
+
+/// \short Aligns the query (seq1) globally to the database (seq2) with the wavefront algorithm, see the
+/// implementation. Returns false without changing the results if the options are not supported or the alignment has
+/// a higher penalty than max_edits mismatches or gap bases, when max_edits is not negative.
+template <typename Tseq, typename Tuint>
+bool
+wavefront_alignment(Tseq const & seq1,
+                    Tseq const & seq2,
+                    AlignmentOptions<Tuint> & opts,
+                    long max_edits = -1);
+
+
+namespace arch_null
+{
+
+template <typename Tseq, typename Tuint>
+bool
+wavefront_alignment(Tseq const & seq1,
+                    Tseq const & seq2,
+                    AlignmentOptions<Tuint> & opts,
+                    long max_edits);
+
+}
+
+namespace arch_sse2
+{
+
+template <typename Tseq, typename Tuint>
+bool
+wavefront_alignment(Tseq const & seq1,
+                    Tseq const & seq2,
+                    AlignmentOptions<Tuint> & opts,
+                    long max_edits);
+
+}
+
+namespace arch_sse3
+{
+
+template <typename Tseq, typename Tuint>
+bool
+wavefront_alignment(Tseq const & seq1,
+                    Tseq const & seq2,
+                    AlignmentOptions<Tuint> & opts,
+                    long max_edits);
+
+}
+
+namespace arch_sse4p1
+{
+
+template <typename Tseq, typename Tuint>
+bool
+wavefront_alignment(Tseq const & seq1,
+                    Tseq const & seq2,
+                    AlignmentOptions<Tuint> & opts,
+                    long max_edits);
+
+}
+
+namespace arch_sse4p1_popcnt
+{
+
+template <typename Tseq, typename Tuint>
+bool
+wavefront_alignment(Tseq const & seq1,
+                    Tseq const & seq2,
+                    AlignmentOptions<Tuint> & opts,
+                    long max_edits);
+
+}
+
+namespace arch_popcnt_avx
+{
+
+template <typename Tseq, typename Tuint>
+bool
+wavefront_alignment(Tseq const & seq1,
+                    Tseq const & seq2,
+                    AlignmentOptions<Tuint> & opts,
+                    long max_edits);
+
+}
+
+namespace arch_popcnt_avx2
+{
+
+template <typename Tseq, typename Tuint>
+bool
+wavefront_alignment(Tseq const & seq1,
+                    Tseq const & seq2,
+                    AlignmentOptions<Tuint> & opts,
+                    long max_edits);
+
+}
+
+namespace arch_popcnt_avx512bw_avx512dq_avx512vl
+{
+
+template <typename Tseq, typename Tuint>
+bool
+wavefront_alignment(Tseq const & seq1,
+                    Tseq const & seq2,
+                    AlignmentOptions<Tuint> & opts,
+                    long max_edits);
+
+}
+
+namespace arch_neon
+{
+
+template <typename Tseq, typename Tuint>
+bool
+wavefront_alignment(Tseq const & seq1,
+                    Tseq const & seq2,
+                    AlignmentOptions<Tuint> & opts,
+                    long max_edits);
+
+}
+
+} // namespace paw
+
+
+namespace paw
+{
+namespace SIMDPP_ARCH_NAMESPACE
+{
+
+/// \short Furthest reaching database offsets on the diagonals (i - j) of the alignments with one penalty
+struct Wavefront
+{
+  long static constexpr NONE = std::numeric_limits<long>::min() / 2; // Offset of diagonals which are not reached
+
+  uint8_t static constexpr FROM_SUB = 0; // Sources of offsets in M
+  uint8_t static constexpr FROM_INS = 1;
+  uint8_t static constexpr FROM_DEL = 2;
+  uint8_t static constexpr FROM_START = 3;
+  uint8_t static constexpr INS_EXTEND = 4; // Set when the offset in I extends an insertion
+  uint8_t static constexpr DEL_EXTEND = 8; // Set when the offset in D extends a deletion
+
+  long lo{0}; // Lowest diagonal
+  long hi{-1}; // Highest diagonal
+  std::vector<long> M{}; // Offsets of alignments ending with any operation
+  std::vector<long> I{}; // Offsets of alignments ending with an insertion
+  std::vector<long> D{}; // Offsets of alignments ending with a deletion
+  std::vector<uint8_t> sources{}; // Where each offset came from, used in the traceback
+
+  inline bool
+  is_null() const {return lo > hi;}
+
+  inline long
+  get_M(long const k) const {return k >= lo && k <= hi ? M[k - lo] : NONE;}
+
+  inline long
+  get_I(long const k) const {return k >= lo && k <= hi ? I[k - lo] : NONE;}
+
+  inline long
+  get_D(long const k) const {return k >= lo && k <= hi ? D[k - lo] : NONE;}
+};
+
+
+/// \short Checks if a query base matches a database base with the match and mismatch values, like the profile of the
+/// striped alignment does
+inline bool
+is_wavefront_match(char const q_base, char const d_base)
+{
+  long const d_code = magic_function(d_base);
+  return d_code == 4 || q_base == 'N' || q_base == "ACGT"[d_code];
+}
+
+
+/// \short Aligns the query (seq1) globally to the database (seq2) with the gap-affine wavefront algorithm (Marco-Sola
+/// et al. 2021), which takes time proportional to the length of the sequences times the alignment penalty, so it is
+/// much faster than the full score matrix for similar sequences. The match score is moved into the penalties, which
+/// gives the same optimal alignments: with penalties x = 2 * (mismatch + match), o = 2 * (gap_open - gap_extend) and
+/// e = 2 * gap_extend + match, an alignment with penalty p has the score (match * (m + n) - p) / 2.
+/// Only global alignments with the match and mismatch values and a single gap cost are supported. The wavefronts of
+/// every penalty are kept for the traceback, so max_edits also limits the memory used.
+template <typename Tseq, typename Tuint>
+bool
+wavefront_alignment(Tseq const & seq1, // seq1 is query
+                    Tseq const & seq2, // seq2 is database
+                    AlignmentOptions<Tuint> & opt,
+                    long const max_edits)
+{
+  long const match = opt.get_match();
+  long const x = 2 * (static_cast<long>(opt.get_mismatch()) + match);
+  long const o = 2 * (static_cast<long>(opt.get_gap_open()) - static_cast<long>(opt.get_gap_extend()));
+  long const e = 2 * static_cast<long>(opt.get_gap_extend()) + match;
+
+  if (opt.left_column_free || opt.right_column_free || opt.top_row_free || opt.bottom_row_free ||
+      opt.continuous_alignment || opt.is_dual_gap() || opt.get_substitution_matrix() || x <= 0 || o < 0 || e <= 0)
+  {
+    return false;
+  }
+
+  long const m = std::distance(seq1.begin(), seq1.end());
+  long const n = std::distance(seq2.begin(), seq2.end());
+
+  // The length difference alone needs that many gap bases
+  if (max_edits >= 0 && std::abs(m - n) > max_edits)
+    return false;
+
+  long const max_penalty = max_edits >= 0 ? max_edits * std::max(x, o + e) : std::numeric_limits<long>::max();
+  long const end_k = n - m;
+
+  auto extend =
+    [&](long const k, long offset) -> long
+    {
+      while (offset < n && offset - k < m && is_wavefront_match(seq1[offset - k], seq2[offset]))
+        ++offset;
+
+      return offset;
+    };
+
+  std::vector<Wavefront> wavefronts(1);
+
+  {
+    Wavefront & wf = wavefronts[0];
+    wf.lo = 0;
+    wf.hi = 0;
+    wf.M.assign(1, extend(0, 0));
+    wf.I.assign(1, Wavefront::NONE);
+    wf.D.assign(1, Wavefront::NONE);
+    wf.sources.assign(1, Wavefront::FROM_START);
+  }
+
+  Wavefront const null_wavefront;
+
+  auto get_wavefront =
+    [&](long const s) -> Wavefront const &
+    {
+      return s >= 0 ? wavefronts[s] : null_wavefront;
+    };
+
+  long s = 0; // Penalty of the wavefront
+
+  while (wavefronts[s].get_M(end_k) < n)
+  {
+    ++s;
+
+    if (s > max_penalty)
+      return false;
+
+    wavefronts.emplace_back();
+    Wavefront const & wf_x = get_wavefront(s - x);
+    Wavefront const & wf_oe = get_wavefront(s - o - e);
+    Wavefront const & wf_e = get_wavefront(s - e);
+
+    // Substitutions stay on the diagonal and gaps move one diagonal up or down
+    long lo = std::numeric_limits<long>::max();
+    long hi = std::numeric_limits<long>::min();
+
+    if (!wf_x.is_null())
+    {
+      lo = wf_x.lo;
+      hi = wf_x.hi;
+    }
+
+    for (Wavefront const * wf_gap : {&wf_oe, &wf_e})
+    {
+      if (!wf_gap->is_null())
+      {
+        lo = std::min(lo, wf_gap->lo - 1);
+        hi = std::max(hi, wf_gap->hi + 1);
+      }
+    }
+
+    Wavefront & wf = wavefronts[s];
+    wf.lo = std::max(lo, -m);
+    wf.hi = std::min(hi, n);
+
+    if (wf.is_null())
+      continue;
+
+    long const size = wf.hi - wf.lo + 1;
+    wf.M.resize(size);
+    wf.I.resize(size);
+    wf.D.resize(size);
+    wf.sources.resize(size);
+
+    for (long k = wf.lo; k <= wf.hi; ++k)
+    {
+      // Offsets which are outside of the matrix are not reached
+      long const ins_open = wf_oe.get_M(k - 1) + 1;
+      long const ins_extend = wf_e.get_I(k - 1) + 1;
+      long ins = std::max(ins_open, ins_extend);
+
+      if (ins > n || ins < 0)
+        ins = Wavefront::NONE;
+
+      long const del_open = wf_oe.get_M(k + 1);
+      long const del_extend = wf_e.get_D(k + 1);
+      long del = std::max(del_open, del_extend);
+
+      if (del - k > m || del < 0)
+        del = Wavefront::NONE;
+
+      long sub = wf_x.get_M(k) + 1;
+
+      if (sub > n || sub - k > m || sub < 0)
+        sub = Wavefront::NONE;
+
+      uint8_t source = Wavefront::FROM_SUB;
+      long best = sub;
+
+      if (del > best)
+      {
+        best = del;
+        source = Wavefront::FROM_DEL;
+      }
+
+      if (ins > best)
+      {
+        best = ins;
+        source = Wavefront::FROM_INS;
+      }
+
+      if (ins_extend > ins_open)
+        source |= Wavefront::INS_EXTEND;
+
+      if (del_extend > del_open)
+        source |= Wavefront::DEL_EXTEND;
+
+      long const i = k - wf.lo;
+      wf.I[i] = ins;
+      wf.D[i] = del;
+      wf.M[i] = best == Wavefront::NONE ? Wavefront::NONE : extend(k, best);
+      wf.sources[i] = source;
+    }
+  }
+
+  AlignmentResults<Tuint> & aln_results = *opt.get_alignment_results();
+  aln_results.score = (match * (m + n) - s) / 2;
+  aln_results.query_begin = 0;
+  aln_results.query_end = m;
+  aln_results.database_begin = 0;
+  aln_results.database_end = n;
+  aln_results.is_overflow = false;
+  aln_results.num_lazy_e_rows = 0;
+  aln_results.num_lazy_e_vectors = 0;
+  aln_results.last_row.num_rows = 0; // There is no row to continue from
+
+  std::vector<Cigar> & cigar = aln_results.cigar;
+  cigar.clear();
+
+  if (!opt.is_traceback())
+    return true;
+
+  // The CIGAR is created backwards from the end of the alignment and reversed at the end
+  long k = end_k;
+  long offset = n;
+  enum {STATE_M, STATE_I, STATE_D} state = STATE_M;
+
+  auto add_sub =
+    [&]()
+    {
+      char const q_base = seq1[offset - k - 1];
+      char const d_base = seq2[offset - 1];
+      bool const is_match = q_base == d_base || q_base == 'N' || d_base == 'N';
+      add_cigar_operation(cigar, is_match ? SEQUENCE_MATCH : MISMATCH);
+      --offset;
+    };
+
+  while (true)
+  {
+    Wavefront const & wf = wavefronts[s];
+    uint8_t const source = wf.sources[k - wf.lo];
+
+    if (state == STATE_M)
+    {
+      uint8_t const from = source & 3;
+      long const begin = from == Wavefront::FROM_SUB ? wavefronts[s - x].get_M(k) + 1 :
+                         from == Wavefront::FROM_INS ? wf.get_I(k) :
+                         from == Wavefront::FROM_DEL ? wf.get_D(k) : 0;
+
+      // Matches found when the offset was extended
+      while (offset > begin)
+        add_sub();
+
+      if (from == Wavefront::FROM_START)
+        break;
+
+      if (from == Wavefront::FROM_SUB)
+      {
+        add_sub();
+        s -= x;
+      }
+      else
+      {
+        state = from == Wavefront::FROM_INS ? STATE_I : STATE_D;
+      }
+    }
+    else if (state == STATE_I)
+    {
+      bool const is_extend = (source & Wavefront::INS_EXTEND) != 0;
+      add_cigar_operation(cigar, INSERTION);
+      --offset;
+      --k;
+      s -= is_extend ? e : o + e;
+      state = is_extend ? STATE_I : STATE_M;
+    }
+    else
+    {
+      bool const is_extend = (source & Wavefront::DEL_EXTEND) != 0;
+      add_cigar_operation(cigar, DELETION);
+      ++k;
+      s -= is_extend ? e : o + e;
+      state = is_extend ? STATE_D : STATE_M;
+    }
+  }
+
+  assert(s == 0);
+  assert(k == 0);
+  assert(offset == 0);
+  std::reverse(cigar.begin(), cigar.end());
+
+  if (opt.get_aligned_strings)
+  {
+    if (!aln_results.aligned_strings_ptr)
+      aln_results.aligned_strings_ptr = std::unique_ptr<std::pair<std::string, std::string> >(
+        new std::pair<std::string, std::string>());
+
+    get_aligned_strings(cigar, seq1, seq2, *aln_results.aligned_strings_ptr);
+  }
+
+  return true;
+}
+
+
+} // namespace SIMDPP_ARCH_NAMESPACE
+} // namespace paw
@@ -1,17 +1,31 @@
+// The station is implemented in paw.cpp, so it is included before the implementations are enabled for each
+// architecture
+#include <paw/station/station.hpp>
+
 #define IMPLEMENT_PAW
 
 #include <iomanip>
 #include <iostream>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <simdpp/simd.h>
 #include <simdpp/dispatch/get_arch_linux_cpuinfo.h>
 
+#include <paw/align/alignment_archs.hpp>
 #include <paw/align/alignment_options.hpp>
 #include <paw/align/alignment_results.hpp>
+#include <paw/align/dna_seq.hpp>
+#include <paw/align/edit_distance.hpp>
 #include <paw/align/global_alignment.hpp>
+#include <paw/align/graph.hpp>
+#include <paw/align/graph_alignment.hpp>
 #include <paw/align/libsimdpp_backtracker.hpp>
 #include <paw/align/libsimdpp_utils.hpp>
+#include <paw/align/local_alignment.hpp>
+#include <paw/align/tiled_alignment.hpp>
+#include <paw/align/wavefront_alignment.hpp>
 #include <paw/internal/config.hpp>
 
 
@@ -36,6 +50,17 @@ get_current_arch()
     ss << sep << "NONE_NULL"; sep = ",";
   }
 
+#if defined(__arm__) || defined(__aarch64__)
+  if (static_cast<bool>(current_arch & simdpp::Arch::ARM_NEON))
+  {
+    ss << sep << "NEON"; sep = ",";
+  }
+
+  if (static_cast<bool>(current_arch & simdpp::Arch::ARM_NEON_FLT_SP))
+  {
+    ss << sep << "NEON_FLT_SP";
+  }
+#else
   if (static_cast<bool>(current_arch & simdpp::Arch::X86_SSE2))
   {
     ss << sep << "SSE2"; sep = ",";
@@ -46,11 +71,21 @@ get_current_arch()
     ss << sep << "SSE3"; sep = ",";
   }
 
+  if (static_cast<bool>(current_arch & simdpp::Arch::X86_SSSE3))
+  {
+    ss << sep << "SSSE3"; sep = ",";
+  }
+
   if (static_cast<bool>(current_arch & simdpp::Arch::X86_SSE4_1))
   {
     ss << sep << "SSE4_1"; sep = ",";
   }
 
+  if (static_cast<bool>(current_arch & simdpp::Arch::X86_POPCNT_INSN))
+  {
+    ss << sep << "POPCNT"; sep = ",";
+  }
+
   if (static_cast<bool>(current_arch & simdpp::Arch::X86_AVX))
   {
     ss << sep << "AVX"; sep = ",";
@@ -95,11 +130,38 @@ get_current_arch()
   {
     ss << sep << "AVX512VL";
   }
+#endif
 
   return ss.str();
 }
 
 
+namespace
+{
+
+/// \short Adds this architecture to the list of compiled architectures when the library is loaded
+struct AlignmentArchRegistrar
+{
+  AlignmentArchRegistrar()
+  {
+    simdpp::Arch const compile_arch = simdpp::this_compile_arch();
+
+    AlignmentArch arch;
+    arch.name = paw::SIMDPP_ARCH_NAMESPACE::get_current_arch();
+    arch.is_runnable = (compile_arch & SIMDPP_USER_ARCH_INFO) == compile_arch;
+    arch.global_alignment_uint8 = &paw::SIMDPP_ARCH_NAMESPACE::global_alignment<std::string, uint8_t>;
+    arch.global_alignment_uint16 = &paw::SIMDPP_ARCH_NAMESPACE::global_alignment<std::string, uint16_t>;
+    arch.local_alignment_uint8 = &paw::SIMDPP_ARCH_NAMESPACE::local_alignment<std::string, uint8_t>;
+    arch.local_alignment_uint16 = &paw::SIMDPP_ARCH_NAMESPACE::local_alignment<std::string, uint16_t>;
+    add_alignment_arch(std::move(arch));
+  }
+};
+
+AlignmentArchRegistrar const alignment_arch_registrar;
+
+} // anon namespace
+
+
 } // namespace SIMDPP_ARCH_NAMESPACE
 
 
@@ -121,6 +183,40 @@ SIMDPP_MAKE_DISPATCHER((template <typename Tseq, typename Tuint>)
                          )
                        )
 
+SIMDPP_MAKE_DISPATCHER((template <typename Tseq, typename Tuint>)
+                         (< Tseq, Tuint >)
+                         (void)
+                         (graph_alignment)
+                         ((Tseq const &) x, (Graph const &) g, (
+                           AlignmentOptions<Tuint>&)z
+                         )
+                       )
+
+SIMDPP_MAKE_DISPATCHER((template <typename Tseq>)
+                         (< Tseq >)
+                         (long)
+                         (edit_distance)
+                         ((Tseq const &) x, (Tseq const &) y, (long) max_distance)
+                       )
+
+SIMDPP_MAKE_DISPATCHER((template <typename Tseq, typename Tuint>)
+                         (< Tseq, Tuint >)
+                         (void)
+                         (local_alignment)
+                         ((Tseq const &) x, (Tseq const &) y, (
+                           AlignmentOptions<Tuint>&)z
+                         )
+                       )
+
+SIMDPP_MAKE_DISPATCHER((template <typename Tseq, typename Tuint>)
+                         (< Tseq, Tuint >)
+                         (bool)
+                         (wavefront_alignment)
+                         ((Tseq const &) x, (Tseq const &) y, (
+                           AlignmentOptions<Tuint>&)z, (long) max_edits
+                         )
+                       )
+
 SIMDPP_INSTANTIATE_DISPATCHER(
   (template void global_alignment<std::string, uint8_t>(
      std::string const & s1, std::string const & s2,
@@ -139,5 +235,66 @@ SIMDPP_INSTANTIATE_DISPATCHER(
      AlignmentOptions<uint16_t>&o))
   )
 
+SIMDPP_INSTANTIATE_DISPATCHER(
+  (template void global_alignment<DnaSeq, uint8_t>(
+     DnaSeq const & s1, DnaSeq const & s2,
+     AlignmentOptions<uint8_t>&o)),
+  (template void global_alignment<DnaSeq, uint16_t>(
+     DnaSeq const & s1, DnaSeq const & s2,
+     AlignmentOptions<uint16_t>&o))
+  )
+
+SIMDPP_INSTANTIATE_DISPATCHER(
+  (template long edit_distance<std::string>(
+     std::string const & s1, std::string const & s2, long max_distance)),
+  (template long edit_distance<std::vector<char> >(
+     std::vector<char> const & s1, std::vector<char> const & s2, long max_distance))
+  )
+
+SIMDPP_INSTANTIATE_DISPATCHER(
+  (template void local_alignment<std::string, uint8_t>(
+     std::string const & s1, std::string const & s2,
+     AlignmentOptions<uint8_t>&o)),
+  (template void local_alignment<std::string, uint16_t>(
+     std::string const & s1, std::string const & s2,
+     AlignmentOptions<uint16_t>&o))
+  )
+
+SIMDPP_INSTANTIATE_DISPATCHER(
+  (template void local_alignment<std::vector<char>, uint8_t>(
+     std::vector<char> const & s1, std::vector<char> const & s2,
+     AlignmentOptions<uint8_t>&o)),
+  (template void local_alignment<std::vector<char>, uint16_t>(
+     std::vector<char> const & s1, std::vector<char> const & s2,
+     AlignmentOptions<uint16_t>&o))
+  )
+
+SIMDPP_INSTANTIATE_DISPATCHER(
+  (template void graph_alignment<std::string, uint8_t>(
+     std::string const & s1, Graph const & g,
+     AlignmentOptions<uint8_t>&o)),
+  (template void graph_alignment<std::string, uint16_t>(
+     std::string const & s1, Graph const & g,
+     AlignmentOptions<uint16_t>&o))
+  )
+
+SIMDPP_INSTANTIATE_DISPATCHER(
+  (template bool wavefront_alignment<std::string, uint8_t>(
+     std::string const & s1, std::string const & s2,
+     AlignmentOptions<uint8_t>&o, long max_edits)),
+  (template bool wavefront_alignment<std::string, uint16_t>(
+     std::string const & s1, std::string const & s2,
+     AlignmentOptions<uint16_t>&o, long max_edits))
+  )
+
+SIMDPP_INSTANTIATE_DISPATCHER(
+  (template bool wavefront_alignment<std::vector<char>, uint8_t>(
+     std::vector<char> const & s1, std::vector<char> const & s2,
+     AlignmentOptions<uint8_t>&o, long max_edits)),
+  (template bool wavefront_alignment<std::vector<char>, uint16_t>(
+     std::vector<char> const & s1, std::vector<char> const & s2,
+     AlignmentOptions<uint16_t>&o, long max_edits))
+  )
+
 
 } // namespace paw
@@ -0,0 +1,143 @@
+#include "../include/catch.hpp"
+
+#include <algorithm> // std::find_if
+#include <cstdint> // uint8_t, uint16_t
+#include <random> // std::mt19937
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+#include <paw/align/alignment_archs.hpp>
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/global_alignment.hpp>
+
+
+namespace
+{
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGT"[rng() % 4]);
+
+  return seq;
+}
+
+
+/// \short Generates a pair of similar sequences with mismatches, insertions and deletions
+std::pair<std::string, std::string>
+random_pair(std::mt19937 & rng, long const size)
+{
+  std::string const q = random_dna(rng, size);
+  std::string d = q;
+
+  for (long k = 0; k < 1 + size / 20; ++k)
+  {
+    long const pos = rng() % d.size();
+
+    switch (rng() % 3)
+    {
+    case 0: d[pos] = "ACGT"[rng() % 4]; break;
+    case 1: d.insert(pos, random_dna(rng, 1 + rng() % 8)); break;
+    default: d.erase(pos, 1 + rng() % 8); break;
+    }
+
+    if (d.empty())
+      d = "A";
+  }
+
+  return {q, d};
+}
+
+
+paw::AlignmentArch const &
+get_null_arch()
+{
+  auto const & archs = paw::get_alignment_archs();
+  auto it = std::find_if(archs.begin(), archs.end(),
+                         [](paw::AlignmentArch const & arch){return arch.name == "NONE_NULL";});
+  REQUIRE(it != archs.end());
+  return *it;
+}
+
+
+template <typename Tuint>
+void
+check_same_as_null_arch(void (* paw::AlignmentArch::* function)(std::string const &,
+                                                                std::string const &,
+                                                                paw::AlignmentOptions<Tuint> &),
+                        long const max_size)
+{
+  paw::AlignmentArch const & null_arch = get_null_arch();
+  std::mt19937 rng(5);
+
+  for (long k = 0; k < 50; ++k)
+  {
+    auto const p = random_pair(rng, 1 + rng() % max_size);
+
+    paw::AlignmentOptions<Tuint> opts;
+    opts.set_match(2).set_mismatch(3).set_gap_open(5).set_gap_extend(1);
+    opts.left_column_free = k % 4 == 1;
+    opts.right_column_free = k % 4 == 2;
+    opts.get_aligned_strings = true;
+    (null_arch.*function)(p.first, p.second, opts);
+    paw::AlignmentResults<Tuint> const & null_ar = *opts.get_alignment_results();
+    std::vector<long> const expected = {null_ar.score, null_ar.query_begin, null_ar.query_end,
+                                        null_ar.database_begin, null_ar.database_end};
+    std::pair<std::string, std::string> const expected_aligned_strings = *null_ar.aligned_strings_ptr;
+
+    for (paw::AlignmentArch const & arch : paw::get_alignment_archs())
+    {
+      if (!arch.is_runnable)
+        continue;
+
+      INFO("arch " << arch.name << ", query " << p.first << ", database " << p.second);
+      (arch.*function)(p.first, p.second, opts);
+      paw::AlignmentResults<Tuint> const & ar = *opts.get_alignment_results();
+      REQUIRE(std::vector<long>({ar.score, ar.query_begin, ar.query_end, ar.database_begin, ar.database_end}) ==
+              expected);
+      REQUIRE(*ar.aligned_strings_ptr == expected_aligned_strings);
+    }
+  }
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("The library registers the null architecture and the one used by the dispatcher")
+{
+  auto const & archs = paw::get_alignment_archs();
+  REQUIRE(archs.size() > 0);
+  REQUIRE(get_null_arch().is_runnable);
+
+  std::string const current_arch = paw::get_current_arch();
+  auto it = std::find_if(archs.begin(), archs.end(),
+                         [&](paw::AlignmentArch const & arch){return arch.name == current_arch;});
+  REQUIRE(it != archs.end());
+  REQUIRE(it->is_runnable);
+}
+
+
+TEST_CASE("Every runnable architecture gives the same global alignment as the null architecture")
+{
+  SECTION("8-bit scores")
+  {
+    check_same_as_null_arch(&paw::AlignmentArch::global_alignment_uint8, 40);
+  }
+
+  SECTION("16-bit scores")
+  {
+    check_same_as_null_arch(&paw::AlignmentArch::global_alignment_uint16, 300);
+  }
+}
+
+
+TEST_CASE("Every runnable architecture gives the same local alignment as the null architecture")
+{
+  check_same_as_null_arch(&paw::AlignmentArch::local_alignment_uint16, 300);
+}
@@ -0,0 +1,139 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint8_t, uint16_t
+#include <cstdlib> // std::malloc, std::free
+#include <new> // std::bad_alloc, std::align_val_t
+#include <string> // std::string
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/global_alignment.hpp>
+
+
+// Every allocation of the test program is counted, including the ones made by the library
+namespace
+{
+
+long num_allocations{0};
+
+
+void *
+counted_malloc(std::size_t const size)
+{
+  ++num_allocations;
+
+  if (void * ptr = std::malloc(size > 0 ? size : 1))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+
+#if defined(__cpp_aligned_new)
+
+void *
+counted_aligned_alloc(std::size_t const size, std::align_val_t const alignment)
+{
+  ++num_allocations;
+  std::size_t const align = static_cast<std::size_t>(alignment);
+
+  if (void * ptr = std::aligned_alloc(align, (size + align - 1) / align * align))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+#endif // defined(__cpp_aligned_new)
+
+} // anon namespace
+
+
+void * operator new(std::size_t size) {return counted_malloc(size);}
+void * operator new[](std::size_t size) {return counted_malloc(size);}
+void operator delete(void * ptr) noexcept {std::free(ptr);}
+void operator delete[](void * ptr) noexcept {std::free(ptr);}
+void operator delete(void * ptr, std::size_t) noexcept {std::free(ptr);}
+void operator delete[](void * ptr, std::size_t) noexcept {std::free(ptr);}
+
+#if defined(__cpp_aligned_new)
+void * operator new(std::size_t size, std::align_val_t al) {return counted_aligned_alloc(size, al);}
+void * operator new[](std::size_t size, std::align_val_t al) {return counted_aligned_alloc(size, al);}
+void operator delete(void * ptr, std::align_val_t) noexcept {std::free(ptr);}
+void operator delete[](void * ptr, std::align_val_t) noexcept {std::free(ptr);}
+void operator delete(void * ptr, std::size_t, std::align_val_t) noexcept {std::free(ptr);}
+void operator delete[](void * ptr, std::size_t, std::align_val_t) noexcept {std::free(ptr);}
+#endif // defined(__cpp_aligned_new)
+
+
+namespace
+{
+
+/// \short Returns the number of allocations made by aligning the sequences again after a first alignment
+template <typename Tuint>
+long
+count_allocations_of_second_alignment(std::string const & q,
+                                      std::string const & d,
+                                      paw::AlignmentOptions<Tuint> & opts)
+{
+  paw::global_alignment(q, d, opts);
+  long const num_before = num_allocations;
+  paw::global_alignment(q, d, opts);
+  return num_allocations - num_before;
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Global alignments do not allocate memory once the buffers are large enough")
+{
+  std::string q;
+
+  for (long k = 0; k < 500; ++k)
+    q.push_back("ACGT"[(k * k + k / 3) % 4]);
+
+  std::string const d = q.substr(0, 200) + "GATTACA" + q.substr(230);
+
+  SECTION("Scores only")
+  {
+    paw::AlignmentOptions<uint16_t> opts;
+    REQUIRE(count_allocations_of_second_alignment(q, d, opts) == 0);
+
+    opts.bottom_row_free = true;
+    REQUIRE(count_allocations_of_second_alignment(q, d, opts) == 0);
+  }
+
+  SECTION("Traceback into a CIGAR and aligned strings")
+  {
+    paw::AlignmentOptions<uint8_t> opts;
+    opts.get_cigar = true;
+    REQUIRE(count_allocations_of_second_alignment(q, d, opts) == 0);
+
+    opts.get_aligned_strings = true;
+    opts.left_column_free = true;
+    opts.top_row_free = true;
+    REQUIRE(count_allocations_of_second_alignment(q, d, opts) == 0);
+    REQUIRE(opts.get_alignment_results()->aligned_strings_ptr->first.size() >= q.size());
+  }
+
+  SECTION("Traceback from checkpoints")
+  {
+    paw::AlignmentOptions<uint16_t> opts;
+    opts.get_cigar = true;
+    opts.backtrack_memory_limit = 10000;
+    REQUIRE(count_allocations_of_second_alignment(q, d, opts) == 0);
+  }
+
+  SECTION("Shorter sequences after longer ones")
+  {
+    std::string const short_q = q.substr(0, 300);
+    std::string const short_d = d.substr(100);
+    paw::AlignmentOptions<uint16_t> opts;
+    opts.get_aligned_strings = true;
+    paw::global_alignment(q, d, opts);
+    long const num_before = num_allocations;
+    paw::global_alignment(short_q, short_d, opts);
+    long const num_new_allocations = num_allocations - num_before;
+    REQUIRE(num_new_allocations == 0);
+  }
+}
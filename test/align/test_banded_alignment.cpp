@@ -0,0 +1,172 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint8_t, uint16_t
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/global_alignment.hpp>
+
+
+namespace
+{
+
+/// \short Scores a pair of aligned strings, where a gap of length k costs gap_open + (k - 1) * gap_extend
+template <typename Tuint>
+long
+score_aligned_strings(std::pair<std::string, std::string> const & aligned_strings,
+                      paw::AlignmentOptions<Tuint> const & opts)
+{
+  std::string const & q = aligned_strings.first;
+  std::string const & d = aligned_strings.second;
+  REQUIRE(q.size() == d.size());
+  long score = 0;
+
+  for (long k = 0; k < static_cast<long>(q.size()); ++k)
+  {
+    if (q[k] == '-' || d[k] == '-')
+    {
+      bool const is_del = d[k] == '-';
+      bool const is_extend = k > 0 && (is_del ? d[k - 1] == '-' : q[k - 1] == '-');
+      score -= is_extend ? opts.get_gap_extend() : opts.get_gap_open();
+    }
+    else if (q[k] == d[k] || q[k] == 'N' || d[k] == 'N')
+    {
+      score += opts.get_match();
+    }
+    else
+    {
+      score -= opts.get_mismatch();
+    }
+  }
+
+  return score;
+}
+
+
+template <typename Tuint>
+long
+get_score(std::string const & q, std::string const & d, paw::AlignmentOptions<Tuint> & opts)
+{
+  paw::global_alignment(q, d, opts);
+  return opts.get_alignment_results()->score;
+}
+
+
+std::vector<std::pair<std::string, std::string> > const sequence_pairs =
+{
+  {"GGGACGTACGTACGT", "GGCCTTTTGGGACGTACTACGTT"},
+  {"ACGTACGTACGTACGTACGTACGTACGTACGT", "ACGTACGTACGTACCTACGTACGTACGTACGT"},
+  {"AAAAAAAAAACCCCCCCCCCGGGGGGGGGG", "AAAAAAAAAACCCCCGGGGGGGGGG"},
+  {"TTTCACTTGCTCTGGTTATTTGTAAAGCTTTTCC", "TTTCACTTGCTCTGGTTATTTATAAAGCTTTTCC"},
+  {"ANNA", "AGTA"},
+  {"A", "TTTTTTTTTTT"},
+  {"", "ACGT"},
+  {"ACGT", ""}
+};
+
+} // anon namespace
+
+
+TEST_CASE("Banded alignment with a band covering the whole matrix is the same as the global alignment")
+{
+  paw::AlignmentOptions<uint8_t> opts;
+  opts.set_match(2).set_mismatch(2).set_gap_open(5).set_gap_extend(1);
+
+  for (auto const & p : sequence_pairs)
+  {
+    if (p.first.size() == 0 || p.second.size() == 0)
+      continue;
+
+    opts.band_width = -1;
+    long const expected_score = get_score(p.first, p.second, opts);
+    opts.band_width = static_cast<long>(p.first.size() + p.second.size());
+    REQUIRE(get_score(p.first, p.second, opts) == expected_score);
+  }
+}
+
+
+TEST_CASE("Banded alignment with free ends")
+{
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.set_match(2).set_mismatch(2).set_gap_open(5).set_gap_extend(1);
+
+  SECTION("Both columns free")
+  {
+    opts.left_column_free = true;
+    opts.right_column_free = true;
+    opts.band_width = 20;
+    REQUIRE(get_score(std::string("GGG"), std::string("TTTTGGGTTTT"), opts) == 6);
+  }
+
+  SECTION("Left column free")
+  {
+    opts.left_column_free = true;
+    opts.band_width = 30;
+    REQUIRE(get_score(std::string("GGGACGTACGTACGT"), std::string("GGCCTTTTGGGACGTACTACGTT"), opts) == 18);
+  }
+}
+
+
+TEST_CASE("Narrow band on similar sequences")
+{
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.set_match(1).set_mismatch(4).set_gap_open(7).set_gap_extend(1);
+
+  std::string const q = "TTTCACTTGCTCTGGTTATTTGTAAAGCTTTTCCTATTTCATCATTAAATTATCCTTGTATTNTAGCAACTGCATTT";
+  std::string d = q;
+  d[10] = 'A';
+  d.erase(40, 3);
+  d.insert(60, "GG");
+
+  opts.band_width = -1;
+  long const expected_score = get_score(q, d, opts);
+  opts.band_width = 4;
+  opts.get_aligned_strings = true;
+  REQUIRE(get_score(q, d, opts) == expected_score);
+
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.aligned_strings_ptr);
+  REQUIRE(score_aligned_strings(*ar.aligned_strings_ptr, opts) == expected_score);
+}
+
+
+TEST_CASE("Banded alignment returns aligned strings matching its score")
+{
+  paw::AlignmentOptions<uint8_t> opts;
+  opts.set_match(2).set_mismatch(2).set_gap_open(5).set_gap_extend(1);
+  opts.get_aligned_strings = true;
+
+  for (auto const & p : sequence_pairs)
+  {
+    for (long w : {0l, 2l, 8l})
+    {
+      opts.band_width = w;
+      long const score = get_score(p.first, p.second, opts);
+      paw::AlignmentResults<uint8_t> const & ar = *opts.get_alignment_results();
+      REQUIRE(ar.aligned_strings_ptr);
+
+      std::pair<std::string, std::string> const & aligned_strings = *ar.aligned_strings_ptr;
+      std::string q_no_gaps;
+      std::string d_no_gaps;
+
+      for (char c : aligned_strings.first)
+      {
+        if (c != '-')
+          q_no_gaps.push_back(c);
+      }
+
+      for (char c : aligned_strings.second)
+      {
+        if (c != '-')
+          d_no_gaps.push_back(c);
+      }
+
+      REQUIRE(q_no_gaps == p.first);
+      REQUIRE(d_no_gaps == p.second);
+      REQUIRE(score_aligned_strings(aligned_strings, opts) == score);
+    }
+  }
+}
@@ -0,0 +1,92 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint8_t, uint16_t
+#include <random> // std::mt19937
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/both_strand_alignment.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/global_alignment.hpp>
+#include <paw/align/seed_alignment.hpp>
+#include <paw/align/sequence_utils.hpp>
+
+
+namespace
+{
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGT"[rng() % 4]);
+
+  return seq;
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Reverse complement")
+{
+  REQUIRE(paw::reverse_complement(std::string("")) == "");
+  REQUIRE(paw::reverse_complement(std::string("A")) == "T");
+  REQUIRE(paw::reverse_complement(std::string("AACGTN")) == "NACGTT");
+  REQUIRE(paw::reverse_complement(std::string("acgtn")) == "NACGT");
+
+  std::string seq = "GATTACA";
+  paw::reverse_complement_in_place(seq);
+  REQUIRE(seq == "TGTAATC");
+  paw::reverse_complement_in_place(seq);
+  REQUIRE(seq == "GATTACA");
+
+  seq = "ACCG";
+  paw::reverse_complement_in_place(seq);
+  REQUIRE(seq == "CGGT");
+
+  // The buffer is resized to the sequence
+  std::vector<char> const v = {'A', 'C', 'C'};
+  std::vector<char> out(10, 'A');
+  paw::reverse_complement(v, out);
+  REQUIRE(out == std::vector<char>({'G', 'G', 'T'}));
+}
+
+
+TEST_CASE("Both strands of a query are aligned and the better strand is kept")
+{
+  std::mt19937 rng(44);
+  std::string const database = random_dna(rng, 2000);
+  std::string query = database.substr(500, 600);
+  query[100] = query[100] == 'A' ? 'C' : 'A';
+
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.left_column_free = true;
+  opts.right_column_free = true;
+  opts.get_cigar = true;
+  paw::global_alignment(query, database, opts);
+  long const score = opts.get_alignment_results()->score;
+  std::string const cigar = paw::get_cigar_string(opts.get_alignment_results()->cigar);
+
+  REQUIRE(!paw::global_alignment_both_strands(query, database, opts));
+  REQUIRE(opts.get_alignment_results()->score == score);
+  REQUIRE(paw::get_cigar_string(opts.get_alignment_results()->cigar) == cigar);
+
+  std::string const rc_query = paw::reverse_complement(query);
+  REQUIRE(paw::global_alignment_both_strands(rc_query, database, opts));
+  REQUIRE(opts.get_alignment_results()->score == score);
+  REQUIRE(paw::get_cigar_string(opts.get_alignment_results()->cigar) == cigar);
+  REQUIRE(opts.get_alignment_results()->database_begin == 500);
+
+  // The same index of the database is used for both strands
+  paw::MinimizerIndex const index(database);
+  REQUIRE(paw::seed_alignment_both_strands(rc_query, database, index, opts));
+  REQUIRE(opts.get_alignment_results()->score == score);
+  REQUIRE(!paw::seed_alignment_both_strands(query, database, index, opts));
+  REQUIRE(opts.get_alignment_results()->score == score);
+  REQUIRE(opts.get_alignment_results()->database_end == 1100);
+}
@@ -0,0 +1,88 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint16_t
+#include <set> // std::set
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/event.hpp>
+#include <paw/align/global_alignment.hpp>
+#include <paw/align/local_alignment.hpp>
+
+
+TEST_CASE("CIGARs are created from aligned strings and back")
+{
+  std::pair<std::string, std::string> const s = {"ACGT--ACNTTA-C", "ACTTGGAC-ATAAC"};
+  std::vector<paw::Cigar> const cigar = paw::get_cigar(s);
+  REQUIRE(paw::get_cigar_string(cigar) == "2=1X1=2I2=1D1X2=1I1=");
+  REQUIRE(paw::get_aligned_strings(cigar, std::string("ACGTACNTTAC"), std::string("ACTTGGACATAAC")) == s);
+}
+
+
+TEST_CASE("Global alignment is traced back into a CIGAR without the aligned strings")
+{
+  std::string const q = "ACGTACGACCCCGGTTAACGTTTGCA";
+  std::string const d = "ACGTACGAGGTTAACTTTTGCA";
+
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.get_cigar = true;
+  paw::global_alignment(q, d, opts);
+
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(!ar.aligned_strings_ptr);
+  REQUIRE(paw::get_cigar_string(ar.cigar) == "8=4D7=1X6=");
+
+  opts.get_aligned_strings = true;
+  paw::global_alignment(q, d, opts);
+  REQUIRE(ar.aligned_strings_ptr);
+  REQUIRE(paw::get_cigar_string(paw::get_cigar(*ar.aligned_strings_ptr)) == paw::get_cigar_string(ar.cigar));
+}
+
+
+TEST_CASE("The begin of semi-global and local alignments is found from the CIGAR")
+{
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.get_cigar = true;
+  opts.left_column_free = true;
+  opts.right_column_free = true;
+  paw::global_alignment(std::string("ACGTTGCA"), std::string("GGGGGACGTTGCAGG"), opts);
+
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.database_begin == 5);
+  REQUIRE(ar.database_end == 13);
+  REQUIRE(paw::get_cigar_string(ar.cigar) == "5I8=2I");
+
+  paw::AlignmentOptions<uint16_t> local_opts;
+  local_opts.get_cigar = true;
+  paw::local_alignment(std::string("TTTTACGTACGTTTTT"), std::string("GGGACGAACGGGG"), local_opts);
+  REQUIRE(paw::get_cigar_string(local_opts.get_alignment_results()->cigar) == "3=1X3=");
+}
+
+
+TEST_CASE("Edit scripts from CIGARs and aligned strings are the same")
+{
+  std::pair<std::string, std::string> const s = {"ACGTTT--ACGTACNTTA-C", "ACTTTTGGAC-TAC-ATAAC"};
+  std::string const first = "ACGTTTACGTACNTTAC";
+  std::string const second = "ACTTTTGGACTACATAAC";
+  std::vector<paw::Cigar> const cigar = paw::get_cigar(s);
+
+  for (bool const is_normalize : {false, true})
+  {
+    std::set<paw::Event2> const edits = paw::get_edit_script(cigar, first, second, is_normalize, false);
+    REQUIRE(edits == paw::get_edit_script(s, is_normalize, false));
+    REQUIRE(edits.size() == 6);
+  }
+
+  // 'M' operations are compared base by base
+  std::vector<paw::Cigar> const m_cigar = {{4, paw::MATCH}, {2, paw::INSERTION}, {3, paw::MATCH}};
+  std::set<paw::Event2> const edits = paw::get_edit_script(m_cigar, std::string("ACGTACG"),
+                                                           std::string("ACCTGGATG"), false, false);
+  REQUIRE(edits.size() == 3);
+  REQUIRE(edits.count(paw::Event2(2, 2, "G", "C")) == 1);
+  REQUIRE(edits.count(paw::Event2(4, 4, "", "GG")) == 1);
+  REQUIRE(edits.count(paw::Event2(5, 7, "C", "T")) == 1);
+}
@@ -0,0 +1,139 @@
+#include "../include/catch.hpp"
+
+#include <algorithm> // std::min
+#include <cstdint> // uint8_t, uint16_t
+#include <random> // std::mt19937
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/global_alignment.hpp>
+
+
+namespace
+{
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGT"[rng() % 4]);
+
+  return seq;
+}
+
+
+/// \short Checks that aligning the database in segments gives the same alignment end as aligning it at once
+template <typename Tuint>
+void
+check_segments(std::string const & q,
+               std::string const & d,
+               std::vector<long> const & segment_sizes,
+               paw::AlignmentOptions<Tuint> & opts)
+{
+  paw::global_alignment(q, d, opts);
+  paw::AlignmentResults<Tuint> const & ar = *opts.get_alignment_results();
+  long const expected_score = ar.score;
+  long const expected_database_end = ar.database_end;
+
+  opts.continuous_alignment = true;
+  long pos = 0;
+
+  for (long const size : segment_sizes)
+  {
+    paw::global_alignment(q, d.substr(pos, size), opts);
+    pos += size;
+    REQUIRE(ar.last_row.num_rows == pos);
+  }
+
+  REQUIRE(pos == static_cast<long>(d.size()));
+  REQUIRE(ar.score == expected_score);
+  REQUIRE(ar.database_end == expected_database_end);
+  opts.continuous_alignment = false;
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Continuous alignments of database segments have the score of the whole database")
+{
+  std::mt19937 rng(38);
+
+  for (long k = 0; k < 50; ++k)
+  {
+    std::string const q = random_dna(rng, 1 + rng() % 150);
+    std::string d = q;
+
+    for (long e = 0; e < 4 && !d.empty(); ++e)
+    {
+      long const pos = rng() % d.size();
+
+      if (rng() % 2 == 0)
+        d[pos] = "ACGT"[rng() % 4];
+      else
+        d.insert(pos, random_dna(rng, 1 + rng() % 10));
+    }
+
+    // The database is split into segments, some of which may be empty
+    std::vector<long> segment_sizes;
+
+    for (long left = d.size(); left > 0;)
+    {
+      long const size = std::min(left, static_cast<long>(rng() % 40));
+      segment_sizes.push_back(size);
+      left -= size;
+    }
+
+    INFO("query " << q << ", database " << d);
+
+    paw::AlignmentOptions<uint16_t> opts;
+    check_segments(q, d, segment_sizes, opts);
+
+    paw::AlignmentOptions<uint8_t> opts8;
+    check_segments(q, d, segment_sizes, opts8);
+
+    opts.set_gap_open(5).set_gap_extend(2).set_gap_open_2(12).set_gap_extend_2(1);
+    check_segments(q, d, segment_sizes, opts);
+
+    paw::AlignmentOptions<uint16_t> free_opts;
+    free_opts.left_column_free = true;
+    free_opts.right_column_free = true;
+    check_segments(q, d, segment_sizes, free_opts);
+  }
+}
+
+
+TEST_CASE("Continuous alignments are traced back in the last segment")
+{
+  std::string const q = "ACGTTGCAAGGCTTACGATCGATCGGATCC";
+  std::string const d = "ACGTTGCAAGGCTTACGTTCGATCGGATCC";
+
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.continuous_alignment = true;
+  opts.get_aligned_strings = true;
+  paw::global_alignment(q, d.substr(0, 20), opts);
+
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.database_begin == 0);
+  REQUIRE(ar.database_end == 20);
+
+  paw::global_alignment(q, d.substr(20), opts);
+  REQUIRE(ar.score == 2 * 29 - 2);
+  REQUIRE(ar.query_begin == 20);
+  REQUIRE(ar.query_end == 30);
+  REQUIRE(ar.database_begin == 20);
+  REQUIRE(ar.database_end == 30);
+  REQUIRE(paw::get_cigar_string(ar.cigar) == "10=");
+  REQUIRE(ar.aligned_strings_ptr->first == q.substr(20));
+
+  // Another query starts a new alignment
+  paw::global_alignment(q.substr(20), d.substr(20), opts);
+  REQUIRE(ar.score == 2 * 10);
+  REQUIRE(ar.database_begin == 0);
+  REQUIRE(ar.database_end == 10);
+}
@@ -0,0 +1,111 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint8_t, uint16_t
+#include <random> // std::mt19937
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/dna_seq.hpp>
+#include <paw/align/global_alignment.hpp>
+
+
+namespace
+{
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGTN"[rng() % 20 == 0 ? 4 : rng() % 4]);
+
+  return seq;
+}
+
+
+/// \short Checks that the packed sequences have the same alignment as the strings
+template <typename Tuint>
+void
+check_dna_seq_alignment(std::string const & q, std::string const & d, paw::AlignmentOptions<Tuint> & opts)
+{
+  opts.get_cigar = true;
+  paw::global_alignment(q, d, opts);
+  paw::AlignmentResults<Tuint> const & ar = *opts.get_alignment_results();
+  long const score = ar.score;
+  long const query_begin = ar.query_begin;
+  long const database_begin = ar.database_begin;
+  std::string const cigar = paw::get_cigar_string(ar.cigar);
+
+  paw::global_alignment(paw::DnaSeq(q), paw::DnaSeq(d), opts);
+  REQUIRE(ar.score == score);
+  REQUIRE(ar.query_begin == query_begin);
+  REQUIRE(ar.database_begin == database_begin);
+  REQUIRE(paw::get_cigar_string(ar.cigar) == cigar);
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Packed DNA sequences")
+{
+  std::string const seq = "ACGTNNacgtnR" + std::string(53, 'A') + "GN";
+  paw::DnaSeq const dna_seq(seq);
+  REQUIRE(dna_seq.size() == seq.size());
+  std::string const expected = "ACGTNNACGTNN" + std::string(53, 'A') + "GN";
+  REQUIRE(dna_seq.to_string() == expected);
+  REQUIRE(dna_seq.get_code(2) == 2);
+  REQUIRE(dna_seq.get_code(5) == 4);
+  REQUIRE(dna_seq.get_code(6) == 0);
+  REQUIRE(std::string(dna_seq.rbegin(), dna_seq.rend()) == std::string(expected.rbegin(), expected.rend()));
+
+  // Subsequences share the bases of the sequence
+  paw::DnaSeq const sub = dna_seq.subseq(3, 60);
+  REQUIRE(sub.to_string() == dna_seq.to_string().substr(3, 60));
+  REQUIRE(sub.subseq(7, 2).to_string() == "NN");
+  REQUIRE(sub.subseq(0, 0).empty());
+
+  // Runs of N are clipped to the subsequence when it is decoded
+  std::vector<uint8_t> codes;
+  sub.subseq(2, 4).get_codes(codes);
+  REQUIRE(codes == std::vector<uint8_t>({4, 0, 1, 2}));
+  sub.subseq(8, 4).get_codes(codes);
+  REQUIRE(codes == std::vector<uint8_t>({4, 0, 0, 0}));
+  REQUIRE(paw::DnaSeq(std::string("")).empty());
+}
+
+
+TEST_CASE("Packed DNA sequences have the same alignments as strings")
+{
+  std::mt19937 rng(45);
+
+  for (long k = 0; k < 30; ++k)
+  {
+    std::string const q = random_dna(rng, 1 + rng() % 100);
+    std::string d = q;
+
+    for (long e = 0; e < 4 && !d.empty(); ++e)
+    {
+      long const pos = rng() % d.size();
+
+      if (rng() % 2 == 0)
+        d[pos] = "ACGT"[rng() % 4];
+      else
+        d.insert(pos, random_dna(rng, 1 + rng() % 10));
+    }
+
+    INFO("query " << q << ", database " << d);
+
+    paw::AlignmentOptions<uint16_t> opts;
+    check_dna_seq_alignment(q, d, opts);
+
+    paw::AlignmentOptions<uint8_t> opts8;
+    opts8.left_column_free = true;
+    opts8.right_column_free = true;
+    check_dna_seq_alignment(q, d, opts8);
+  }
+}
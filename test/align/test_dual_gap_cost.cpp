@@ -0,0 +1,202 @@
+#include "../include/catch.hpp"
+
+#include <algorithm> // std::max, std::min
+#include <cstdint> // uint8_t, uint16_t
+#include <limits> // std::numeric_limits
+#include <random> // std::mt19937
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/global_alignment.hpp>
+
+
+namespace
+{
+
+long const MATCH = 2;
+long const MISMATCH = 2;
+long const GAP_OPEN = 5;
+long const GAP_EXTEND = 2;
+long const GAP_OPEN_2 = 16;
+long const GAP_EXTEND_2 = 1;
+
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGT"[rng() % 4]);
+
+  return seq;
+}
+
+
+/// \short Cost of a gap of length k, which is the lower of the two affine gap costs
+long
+get_gap_cost(long const k)
+{
+  return std::min(GAP_OPEN + (k - 1) * GAP_EXTEND, GAP_OPEN_2 + (k - 1) * GAP_EXTEND_2);
+}
+
+
+/// \short Score of the best global alignment, computed one cell at a time with both gap costs
+long
+get_global_score(std::string const & q, std::string const & d)
+{
+  long const NEG_INF = std::numeric_limits<long>::min() / 2;
+  long const m = q.size();
+  std::vector<long> H(m + 1);
+  std::vector<long> F(m + 1, NEG_INF);
+  std::vector<long> F2(m + 1, NEG_INF);
+
+  for (long j = 1; j <= m; ++j)
+    H[j] = -get_gap_cost(j);
+
+  for (long i = 1; i <= static_cast<long>(d.size()); ++i)
+  {
+    long h_diagonal = H[0];
+    H[0] = -get_gap_cost(i);
+    long E = NEG_INF;
+    long E2 = NEG_INF;
+
+    for (long j = 1; j <= m; ++j)
+    {
+      E = std::max(E - GAP_EXTEND, H[j - 1] - GAP_OPEN);
+      E2 = std::max(E2 - GAP_EXTEND_2, H[j - 1] - GAP_OPEN_2);
+      F[j] = std::max(F[j] - GAP_EXTEND, H[j] - GAP_OPEN);
+      F2[j] = std::max(F2[j] - GAP_EXTEND_2, H[j] - GAP_OPEN_2);
+      bool const is_match = q[j - 1] == d[i - 1];
+      long const h = h_diagonal + (is_match ? MATCH : -MISMATCH);
+      h_diagonal = H[j];
+      H[j] = std::max({h, E, E2, F[j], F2[j]});
+    }
+  }
+
+  return H[m];
+}
+
+
+/// \short Score of aligned strings, where each gap costs the lower of the two gap costs
+long
+get_aligned_strings_score(std::pair<std::string, std::string> const & s)
+{
+  long score = 0;
+
+  for (long j = 0; j < static_cast<long>(s.first.size());)
+  {
+    if (s.first[j] == '-' || s.second[j] == '-')
+    {
+      std::string const & gap_seq = s.first[j] == '-' ? s.first : s.second;
+      long k = 0;
+
+      while (j + k < static_cast<long>(gap_seq.size()) && gap_seq[j + k] == '-')
+        ++k;
+
+      score -= get_gap_cost(k);
+      j += k;
+    }
+    else
+    {
+      score += s.first[j] == s.second[j] ? MATCH : -MISMATCH;
+      ++j;
+    }
+  }
+
+  return score;
+}
+
+
+template <typename Tuint>
+paw::AlignmentOptions<Tuint>
+get_dual_gap_options()
+{
+  paw::AlignmentOptions<Tuint> opts;
+  opts.set_match(MATCH).set_mismatch(MISMATCH).set_gap_open(GAP_OPEN).set_gap_extend(GAP_EXTEND);
+  opts.set_gap_open_2(GAP_OPEN_2).set_gap_extend_2(GAP_EXTEND_2);
+  return opts;
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Long gaps have the second gap cost")
+{
+  std::string const q = "ACGTTGCAAGGCTTACGATCGATCGGATCCATGCAAGTCCGATGCA";
+  std::string const d = q.substr(0, 20) + q.substr(40);
+
+  paw::AlignmentOptions<uint16_t> opts = get_dual_gap_options<uint16_t>();
+  REQUIRE(opts.is_dual_gap());
+  opts.get_aligned_strings = true;
+  paw::global_alignment(q, d, opts);
+
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.score == static_cast<long>(d.size()) * MATCH - (GAP_OPEN_2 + 19 * GAP_EXTEND_2));
+  REQUIRE(get_aligned_strings_score(*ar.aligned_strings_ptr) == ar.score);
+
+  // Without the second gap cost the gap is much more expensive
+  opts.set_gap_open_2(0);
+  REQUIRE(!opts.is_dual_gap());
+  paw::global_alignment(q, d, opts);
+  REQUIRE(ar.score == static_cast<long>(d.size()) * MATCH - (GAP_OPEN + 19 * GAP_EXTEND));
+}
+
+
+TEST_CASE("Alignments with two gap costs have the best score")
+{
+  std::mt19937 rng(36);
+
+  for (long k = 0; k < 60; ++k)
+  {
+    std::string const q = random_dna(rng, 1 + rng() % 200);
+    std::string d = q;
+
+    // Short and long insertions and deletions
+    for (long e = 0; e < 3 && !d.empty(); ++e)
+    {
+      long const pos = rng() % d.size();
+      long const len = rng() % 2 == 0 ? 1 + rng() % 3 : 10 + rng() % 30;
+
+      if (rng() % 2 == 0)
+        d.erase(pos, len);
+      else
+        d.insert(pos, random_dna(rng, len));
+    }
+
+    if (d.empty())
+      d = "A";
+
+    long const expected = get_global_score(q, d);
+    INFO("query " << q << ", database " << d);
+
+    paw::AlignmentOptions<uint16_t> opts = get_dual_gap_options<uint16_t>();
+    opts.get_aligned_strings = true;
+    paw::global_alignment(q, d, opts);
+    paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+    REQUIRE(ar.score == expected);
+    REQUIRE(get_aligned_strings_score(*ar.aligned_strings_ptr) == expected);
+
+    paw::AlignmentOptions<uint8_t> opts8 = get_dual_gap_options<uint8_t>();
+    opts8.get_aligned_strings = true;
+    paw::global_alignment(q, d, opts8);
+    REQUIRE(opts8.get_alignment_results()->score == expected);
+    REQUIRE(get_aligned_strings_score(*opts8.get_alignment_results()->aligned_strings_ptr) == expected);
+
+    // Backtracks which are recomputed from checkpoints
+    opts.backtrack_memory_limit = 1000;
+    paw::global_alignment(q, d, opts);
+    REQUIRE(ar.score == expected);
+    REQUIRE(get_aligned_strings_score(*ar.aligned_strings_ptr) == expected);
+
+    opts.backtrack_memory_limit = -1;
+    opts.band_width = q.size() + d.size();
+    paw::global_alignment(q, d, opts);
+    REQUIRE(ar.score == expected);
+    REQUIRE(get_aligned_strings_score(*ar.aligned_strings_ptr) == expected);
+  }
+}
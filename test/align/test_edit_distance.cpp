@@ -0,0 +1,112 @@
+#include "../include/catch.hpp"
+
+#include <algorithm> // std::min
+#include <random> // std::mt19937
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <paw/align/edit_distance.hpp>
+
+
+namespace
+{
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGTN"[rng() % 20 == 0 ? 4 : rng() % 4]);
+
+  return seq;
+}
+
+
+/// \short Calculates the edit distance with the full dynamic programming matrix
+long
+get_edit_distance_dp(std::string const & q, std::string const & d)
+{
+  std::vector<long> row(q.size() + 1);
+
+  for (long j = 0; j <= static_cast<long>(q.size()); ++j)
+    row[j] = j;
+
+  for (long i = 1; i <= static_cast<long>(d.size()); ++i)
+  {
+    long diagonal = row[0];
+    row[0] = i;
+
+    for (long j = 1; j <= static_cast<long>(q.size()); ++j)
+    {
+      bool const is_match = q[j - 1] == d[i - 1] || q[j - 1] == 'N' || d[i - 1] == 'N';
+      long const cell = std::min(diagonal + (is_match ? 0 : 1), std::min(row[j], row[j - 1]) + 1);
+      diagonal = row[j];
+      row[j] = cell;
+    }
+  }
+
+  return row[q.size()];
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Edit distance of small sequences")
+{
+  REQUIRE(paw::edit_distance(std::string(""), std::string("")) == 0);
+  REQUIRE(paw::edit_distance(std::string("ACGT"), std::string("")) == 4);
+  REQUIRE(paw::edit_distance(std::string(""), std::string("ACG")) == 3);
+  REQUIRE(paw::edit_distance(std::string("ACGT"), std::string("ACGT")) == 0);
+  REQUIRE(paw::edit_distance(std::string("ACGT"), std::string("AGGT")) == 1);
+  REQUIRE(paw::edit_distance(std::string("ACGT"), std::string("ACNT")) == 0);
+  REQUIRE(paw::edit_distance(std::string("ACGTTGCA"), std::string("CGTAGCCA")) == 3);
+  REQUIRE(paw::edit_distance(std::string("ACGTTGCA"), std::string("CGTAGCCA"), 3) == 3);
+  REQUIRE(paw::edit_distance(std::string("ACGTTGCA"), std::string("CGTAGCCA"), 2) == -1);
+  REQUIRE(paw::edit_distance(std::vector<char>({'A', 'C'}), std::vector<char>({'C'})) == 1);
+}
+
+
+TEST_CASE("Edit distance has the distance of the full dynamic programming matrix")
+{
+  std::mt19937 rng(40);
+
+  for (long k = 0; k < 300; ++k)
+  {
+    std::string const q = random_dna(rng, rng() % 300);
+    std::string d;
+
+    // Most databases are a mutated query, the rest are unrelated
+    if (k % 4 == 0)
+    {
+      d = random_dna(rng, rng() % 300);
+    }
+    else
+    {
+      d = q;
+
+      for (long e = rng() % 20; e > 0; --e)
+      {
+        long const pos = d.empty() ? 0 : rng() % d.size();
+
+        if (rng() % 3 == 0 && !d.empty())
+          d[pos] = "ACGT"[rng() % 4];
+        else if (rng() % 2 == 0 && !d.empty())
+          d.erase(pos, 1 + rng() % 5);
+        else
+          d.insert(pos, random_dna(rng, 1 + rng() % 5));
+      }
+    }
+
+    INFO("query " << q << ", database " << d);
+    long const expected = get_edit_distance_dp(q, d);
+    REQUIRE(paw::edit_distance(q, d) == expected);
+    REQUIRE(paw::edit_distance(d, q) == expected);
+
+    // Distances above the maximum distance are not reported
+    long const max_distance = rng() % 40;
+    REQUIRE(paw::edit_distance(q, d, max_distance) == (expected <= max_distance ? expected : -1));
+    REQUIRE(paw::edit_distance(q, d, expected) == expected);
+  }
+}
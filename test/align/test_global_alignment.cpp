@@ -0,0 +1,245 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint8_t, uint16_t
+#include <random> // std::mt19937
+#include <string> // std::string
+#include <utility> // std::pair
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/global_alignment.hpp>
+
+
+namespace
+{
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGT"[rng() % 4]);
+
+  return seq;
+}
+
+
+/// \short Checks that a dropped alignment has the score of the global alignment of the sequences up to its end
+template <typename Tuint>
+void
+check_dropped_alignment(std::string const & q, std::string const & d, paw::AlignmentOptions<Tuint> & opts)
+{
+  paw::global_alignment(q, d, opts);
+  paw::AlignmentResults<Tuint> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.is_dropped);
+  long const score = ar.score;
+  long const query_end = ar.query_end;
+  long const database_end = ar.database_end;
+  std::vector<paw::Cigar> const cigar = ar.cigar;
+
+  paw::AlignmentOptions<Tuint> prefix_opts;
+  paw::global_alignment(q.substr(0, query_end), d.substr(0, database_end), prefix_opts);
+  REQUIRE(prefix_opts.get_alignment_results()->score == score);
+
+  // The rest of the sequences are not aligned
+  std::pair<std::string, std::string> const aligned_strings = paw::get_aligned_strings(cigar, q, d);
+  REQUIRE(aligned_strings.first.substr(aligned_strings.first.size() - (d.size() - database_end)) ==
+          std::string(d.size() - database_end, '-'));
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Long deletions are carried between vector elements")
+{
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.set_match(2).set_mismatch(2).set_gap_open(5).set_gap_extend(1);
+  opts.get_aligned_strings = true;
+
+  std::string const prefix = "ACGTTGCAACGGTACCATGA";
+  std::string const suffix = "TTGACCAGTAGGCATACGAT";
+  std::string deleted;
+
+  for (long k = 0; k < 100; ++k)
+    deleted.push_back("ACGT"[(k * 7 + k / 3) % 4]);
+
+  std::string const q = prefix + deleted + suffix;
+  std::string const d = prefix + suffix;
+  paw::global_alignment(q, d, opts);
+
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.score == 2 * 40 - 5 - 99);
+  REQUIRE(ar.aligned_strings_ptr->first == q);
+  REQUIRE(ar.aligned_strings_ptr->second == prefix + std::string(100, '-') + suffix);
+  REQUIRE(ar.num_lazy_e_rows > 0);
+  REQUIRE(ar.num_lazy_e_vectors >= ar.num_lazy_e_rows);
+  REQUIRE(ar.num_lazy_e_rows <= static_cast<long>(d.size()));
+}
+
+
+TEST_CASE("Lazy deletion counters are reset between alignments")
+{
+  paw::AlignmentOptions<uint8_t> opts;
+  std::string const q(200, 'A');
+
+  paw::global_alignment(q, std::string(50, 'A'), opts);
+  paw::AlignmentResults<uint8_t> const & ar = *opts.get_alignment_results();
+  long const num_lazy_e_vectors = ar.num_lazy_e_vectors;
+  REQUIRE(ar.score == 2 * 50 - 5 - 149);
+
+  paw::global_alignment(q, std::string(50, 'A'), opts);
+  REQUIRE(ar.num_lazy_e_vectors == num_lazy_e_vectors);
+}
+
+
+TEST_CASE("Alignments with linear gap costs are traced back without gap extension bits")
+{
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.set_match(2).set_mismatch(3).set_gap_open(2).set_gap_extend(2);
+  opts.get_aligned_strings = true;
+
+  std::string const q = "ACGTACGACCCCGGTTAACGT";
+  std::string const d = "ACGTACGAGGTTAACGT";
+  paw::global_alignment(q, d, opts);
+
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.score == 2 * 17 - 2 * 4);
+  REQUIRE(ar.aligned_strings_ptr->first == q);
+  REQUIRE(ar.aligned_strings_ptr->second == "ACGTACGA----GGTTAACGT");
+
+  opts.set_gap_open(5).set_gap_extend(2);
+  paw::global_alignment(q, d, opts);
+  REQUIRE(ar.score == 2 * 17 - 5 - 2 * 3);
+}
+
+
+TEST_CASE("Alignments have the same score and end with and without a traceback")
+{
+  std::mt19937 rng(47);
+
+  for (long k = 0; k < 40; ++k)
+  {
+    std::string const q = random_dna(rng, 1 + rng() % 120);
+    std::string const d = random_dna(rng, 1 + rng() % 120);
+    INFO("query " << q << ", database " << d);
+
+    paw::AlignmentOptions<uint16_t> opts;
+    opts.left_column_free = k % 4 == 1;
+    opts.right_column_free = k % 4 == 1 || k % 4 == 2;
+
+    if (k % 2 == 1)
+      opts.set_gap_open(5).set_gap_extend(2).set_gap_open_2(12).set_gap_extend_2(1);
+
+    paw::global_alignment(q, d, opts);
+    paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+    long const score = ar.score;
+    long const query_end = ar.query_end;
+    long const database_end = ar.database_end;
+
+    opts.get_cigar = true;
+    paw::global_alignment(q, d, opts);
+    REQUIRE(ar.score == score);
+    REQUIRE(ar.query_end == query_end);
+    REQUIRE(ar.database_end == database_end);
+  }
+}
+
+
+TEST_CASE("Backtracks recomputed from checkpoints give the same alignment as the full backtrack")
+{
+  std::string q;
+
+  for (long k = 0; k < 600; ++k)
+    q.push_back("ACGT"[(k * k + k / 7) % 4]);
+
+  std::string d = q.substr(0, 150) + q.substr(170, 200) + "GATTACA" + q.substr(370);
+  d[40] = 'T';
+  d[500] = 'A';
+
+  for (bool const is_free_ends : {false, true})
+  {
+    paw::AlignmentOptions<uint16_t> opts;
+    opts.get_aligned_strings = true;
+    opts.left_column_free = is_free_ends;
+    opts.right_column_free = is_free_ends;
+    paw::global_alignment(q, d, opts);
+
+    paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+    long const score = ar.score;
+    std::pair<std::string, std::string> const aligned_strings = *ar.aligned_strings_ptr;
+
+    for (long const limit : {0l, 1000l, 100000l})
+    {
+      opts.backtrack_memory_limit = limit;
+      paw::global_alignment(q, d, opts);
+      REQUIRE(ar.score == score);
+      REQUIRE(*ar.aligned_strings_ptr == aligned_strings);
+    }
+  }
+}
+
+
+TEST_CASE("Alignments which turn bad are stopped by the X-drop")
+{
+  std::mt19937 rng(43);
+  std::string const prefix = random_dna(rng, 300);
+  std::string const q = prefix + random_dna(rng, 700);
+  std::string const d = prefix + random_dna(rng, 700);
+
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.get_cigar = true;
+  opts.x_drop = 50;
+  check_dropped_alignment(q, d, opts);
+
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.score >= 2 * 300);
+  REQUIRE(ar.database_end < 400);
+
+  paw::AlignmentOptions<uint8_t> opts8;
+  opts8.get_aligned_strings = true;
+  opts8.x_drop = 20;
+  check_dropped_alignment(q, d, opts8);
+
+  // The checkpointed backtrack is traced back from the last row computed
+  opts.backtrack_memory_limit = 0;
+  check_dropped_alignment(q, d, opts);
+
+  // Similar sequences are not dropped
+  std::string similar = q;
+  similar[100] = similar[100] == 'A' ? 'C' : 'A';
+  similar[600] = similar[600] == 'A' ? 'C' : 'A';
+  paw::AlignmentOptions<uint16_t> full_opts;
+  paw::global_alignment(q, similar, full_opts);
+  paw::global_alignment(q, similar, opts);
+  REQUIRE(!ar.is_dropped);
+  REQUIRE(ar.score == full_opts.get_alignment_results()->score);
+  REQUIRE(ar.database_end == static_cast<long>(similar.size()));
+}
+
+
+TEST_CASE("The Z-drop allows long gaps which the X-drop does not")
+{
+  std::mt19937 rng(44);
+  std::string const prefix = random_dna(rng, 200);
+  std::string const suffix = random_dna(rng, 200);
+  std::string const q = prefix + random_dna(rng, 200) + suffix;
+  std::string const d = prefix + suffix;
+
+  // The scores of random sequences drop slowly with the default penalties
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.set_mismatch(4).set_gap_open(8);
+  opts.get_cigar = true;
+  opts.x_drop = 30;
+  check_dropped_alignment(q, d, opts);
+
+  opts.x_drop = -1;
+  opts.z_drop = 30;
+  paw::global_alignment(q, d, opts);
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(!ar.is_dropped);
+  REQUIRE(ar.score == 2 * 400 - 8 - 199);
+  REQUIRE(paw::get_cigar_string(ar.cigar) == "200=200D200=");
+}
@@ -0,0 +1,260 @@
+#include "../include/catch.hpp"
+
+#include <algorithm> // std::find, std::max
+#include <cstdint> // uint8_t, uint16_t
+#include <limits> // std::numeric_limits
+#include <random> // std::mt19937
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/global_alignment.hpp>
+#include <paw/align/graph.hpp>
+#include <paw/align/graph_alignment.hpp>
+
+
+namespace
+{
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGT"[rng() % 4]);
+
+  return seq;
+}
+
+
+/// \short Creates a graph of a random reference with SNPs, insertions and deletions as alternative vertices
+paw::Graph
+random_variant_graph(std::mt19937 & rng, long const num_variants)
+{
+  paw::Graph graph;
+  long prev = graph.add_vertex(random_dna(rng, 1 + rng() % 20));
+
+  for (long k = 0; k < num_variants; ++k)
+  {
+    std::string const ref = random_dna(rng, rng() % 3);
+    std::string alt = random_dna(rng, rng() % 4);
+
+    if (ref == alt)
+      alt += 'A';
+
+    long const ref_vertex = graph.add_vertex(ref);
+    long const alt_vertex = graph.add_vertex(alt);
+    long const next = graph.add_vertex(random_dna(rng, 1 + rng() % 20));
+    graph.add_edge(prev, ref_vertex);
+    graph.add_edge(prev, alt_vertex);
+    graph.add_edge(ref_vertex, next);
+    graph.add_edge(alt_vertex, next);
+    prev = next;
+  }
+
+  return graph;
+}
+
+
+/// \short Adds every path from vertex u to a vertex without outbound edges to paths
+void
+get_all_paths(paw::Graph const & graph,
+              long const u,
+              std::vector<long> & path,
+              std::vector<std::vector<long> > & paths)
+{
+  path.push_back(u);
+
+  if (graph.get_indexes_outbound(u).empty())
+    paths.push_back(path);
+
+  for (long const to : graph.get_indexes_outbound(u))
+    get_all_paths(graph, to, path, paths);
+
+  path.pop_back();
+}
+
+
+/// \short Checks that a path starts at a vertex without inbound edges, follows the edges of the graph and ends at a
+/// vertex without outbound edges
+bool
+is_full_path(paw::Graph const & graph, std::vector<long> const & path)
+{
+  if (path.empty() || !graph.get_indexes_inbound(path.front()).empty() ||
+      !graph.get_indexes_outbound(path.back()).empty())
+  {
+    return false;
+  }
+
+  for (long k = 1; k < static_cast<long>(path.size()); ++k)
+  {
+    std::vector<long> const & outbound = graph.get_indexes_outbound(path[k - 1]);
+
+    if (std::find(outbound.begin(), outbound.end(), path[k]) == outbound.end())
+      return false;
+  }
+
+  return true;
+}
+
+
+/// \short Checks the graph alignment of a query against the best global alignment to any path of the graph
+template <typename Tuint>
+void
+check_graph_alignment(std::string const & q, paw::Graph const & graph, paw::AlignmentOptions<Tuint> & opts)
+{
+  std::vector<long> path;
+  std::vector<std::vector<long> > paths;
+
+  for (long u = 0; u < graph.size(); ++u)
+  {
+    if (graph.get_indexes_inbound(u).empty())
+      get_all_paths(graph, u, path, paths);
+  }
+
+  long expected = std::numeric_limits<long>::min();
+
+  for (std::vector<long> const & p : paths)
+  {
+    paw::global_alignment(q, graph.get_path_sequence(p), opts);
+    expected = std::max(expected, opts.get_alignment_results()->score);
+  }
+
+  opts.get_aligned_strings = true;
+  paw::graph_alignment(q, graph, opts);
+  opts.get_aligned_strings = false;
+
+  paw::AlignmentResults<Tuint> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.score == expected);
+  REQUIRE(is_full_path(graph, ar.path));
+
+  // The path has the same score when it is aligned on its own
+  std::string const path_seq = graph.get_path_sequence(ar.path);
+  std::pair<std::string, std::string> const aligned_strings = *ar.aligned_strings_ptr;
+  REQUIRE(paw::get_aligned_strings(ar.cigar, q, path_seq) == aligned_strings);
+  long const query_begin = ar.query_begin;
+  long const query_end = ar.query_end;
+  long const database_begin = ar.database_begin;
+  long const database_end = ar.database_end;
+
+  paw::global_alignment(q, path_seq, opts);
+  REQUIRE(ar.score == expected);
+
+  if (!opts.left_column_free && !opts.right_column_free && !opts.top_row_free && !opts.bottom_row_free)
+  {
+    REQUIRE(query_begin == 0);
+    REQUIRE(query_end == static_cast<long>(q.size()));
+    REQUIRE(database_begin == 0);
+    REQUIRE(database_end == static_cast<long>(path_seq.size()));
+  }
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Graph topological order")
+{
+  paw::Graph graph;
+  graph.add_vertex("AC");
+  graph.add_vertex("G");
+  graph.add_vertex("");
+  graph.add_vertex("T");
+  graph.add_edge(3, 0);
+  graph.add_edge(0, 1);
+  graph.add_edge(0, 2);
+  graph.add_edge(2, 1);
+
+  REQUIRE(graph.get_topological_order() == std::vector<long>({3, 0, 2, 1}));
+  REQUIRE(graph.get_path_sequence({3, 0, 2, 1}) == "TACG");
+}
+
+
+TEST_CASE("Graph alignment takes the best path")
+{
+  // AAAAAAAAAA
+  // A|T
+  // AAAAAAAAAAAAAAAAAAAAAAAAAAAA
+  paw::Graph graph;
+  graph.add_vertex("A");
+  graph.add_vertex("T");
+  graph.add_vertex("A");
+  graph.add_vertex("AAAAAAAAAAAAAAAAAAAAAAAAAAAA");
+  graph.add_edge(0, 1);
+  graph.add_edge(0, 2);
+  graph.add_edge(1, 3);
+  graph.add_edge(2, 3);
+
+  std::string const query = "ATAAAAAAAAAAAAAAAAAAAAAAAAAAAA";
+
+  {
+    paw::AlignmentOptions<uint16_t> opts;
+    opts.get_aligned_strings = true;
+    paw::graph_alignment(query, graph, opts);
+
+    paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+    REQUIRE(ar.score == 2 * static_cast<long>(query.size()));
+    REQUIRE(ar.path == std::vector<long>({0, 1, 3}));
+    REQUIRE(paw::get_cigar_string(ar.cigar) == "30=");
+    REQUIRE(ar.aligned_strings_ptr->second == query);
+  }
+
+  {
+    paw::AlignmentOptions<uint8_t> opts;
+    paw::graph_alignment(std::string("AA") + query.substr(2), graph, opts);
+
+    paw::AlignmentResults<uint8_t> const & ar = *opts.get_alignment_results();
+    REQUIRE(ar.score == 2 * static_cast<long>(query.size()));
+    REQUIRE(ar.path == std::vector<long>({0, 2, 3}));
+  }
+}
+
+
+TEST_CASE("Graph alignment has the best score of all paths")
+{
+  std::mt19937 rng(37);
+
+  for (long k = 0; k < 40; ++k)
+  {
+    paw::Graph const graph = random_variant_graph(rng, 1 + rng() % 5);
+
+    // The query is a mutated path of the graph
+    std::vector<long> path;
+    std::vector<std::vector<long> > paths;
+    get_all_paths(graph, 0, path, paths);
+    std::string q = graph.get_path_sequence(paths[rng() % paths.size()]);
+
+    for (long e = 0; e < 3 && !q.empty(); ++e)
+    {
+      long const pos = rng() % q.size();
+
+      if (rng() % 2 == 0)
+        q[pos] = "ACGT"[rng() % 4];
+      else
+        q.erase(pos, 1 + rng() % 3);
+    }
+
+    INFO("query " << q);
+
+    paw::AlignmentOptions<uint16_t> opts;
+    check_graph_alignment(q, graph, opts);
+
+    paw::AlignmentOptions<uint8_t> opts8;
+    opts8.set_match(2).set_mismatch(4).set_gap_open(6).set_gap_extend(2);
+    check_graph_alignment(q, graph, opts8);
+
+    opts.set_gap_open(5).set_gap_extend(2).set_gap_open_2(12).set_gap_extend_2(1);
+    check_graph_alignment(q, graph, opts);
+
+    paw::AlignmentOptions<uint16_t> free_opts;
+    free_opts.top_row_free = k % 2 == 0;
+    free_opts.bottom_row_free = k % 2 == 0;
+    free_opts.left_column_free = k % 2 == 1;
+    free_opts.right_column_free = k % 2 == 1;
+    check_graph_alignment(q, graph, free_opts);
+  }
+}
@@ -0,0 +1,73 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint8_t, uint16_t
+#include <random> // std::mt19937
+
+#include <simdpp/simd.h>
+
+#include <paw/align/alignment_cache.hpp>
+#include <paw/align/libsimdpp_utils.hpp>
+
+
+namespace
+{
+
+template <typename Tuint>
+void
+check_shift_one_right(long const max_reduction)
+{
+  using Tpack = typename paw::SIMDPP_ARCH_NAMESPACE::T<Tuint>::pack;
+  using Tarr_uint = typename paw::SIMDPP_ARCH_NAMESPACE::T<Tuint>::arr_uint;
+
+  std::mt19937 rng(1);
+  paw::SIMDPP_ARCH_NAMESPACE::AlignmentCache<Tuint> aln_cache;
+
+  for (long k = 0; k < 100; ++k)
+  {
+    for (auto & reduction : aln_cache.reductions)
+      reduction = static_cast<long>(rng() % max_reduction);
+
+    aln_cache.update_reduction_deltas();
+
+    Tarr_uint vec;
+
+    for (auto & element : vec)
+      element = static_cast<Tuint>(rng());
+
+    Tpack const pack = simdpp::load_u(&vec[0]);
+    Tuint const left = static_cast<Tuint>(rng());
+
+    Tarr_uint expected;
+    simdpp::store_u(&expected[0],
+                    paw::SIMDPP_ARCH_NAMESPACE::shift_one_right<Tuint>(pack, left, aln_cache.reductions));
+
+    Tarr_uint result;
+    simdpp::store_u(&result[0],
+                    paw::SIMDPP_ARCH_NAMESPACE::shift_one_right<Tuint>(pack,
+                                                                       left,
+                                                                       aln_cache.reduction_delta_add,
+                                                                       aln_cache.reduction_delta_sub,
+                                                                       aln_cache.left_mask));
+
+    REQUIRE(result[0] == left);
+    REQUIRE(result == expected);
+  }
+}
+
+} // anon namespace
+
+
+TEST_CASE("Shifting packs in registers is the same as shifting them through memory")
+{
+  SECTION("8-bit packs")
+  {
+    check_shift_one_right<uint8_t>(20);
+    check_shift_one_right<uint8_t>(1000);
+  }
+
+  SECTION("16-bit packs")
+  {
+    check_shift_one_right<uint16_t>(20);
+    check_shift_one_right<uint16_t>(100000);
+  }
+}
@@ -0,0 +1,89 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint8_t, uint16_t
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/local_alignment.hpp>
+
+
+TEST_CASE("Local alignment finds the best matching part of both sequences")
+{
+  paw::AlignmentOptions<uint8_t> opts;
+  opts.set_match(2).set_mismatch(2).set_gap_open(5).set_gap_extend(1);
+  opts.get_aligned_strings = true;
+
+  std::string const q = "TTTTTTTTACGTACGTACGTTTTTTTT";
+  std::string const d = "GGGGGGGGGGACGTACGTACGGGGGGGGGG";
+  paw::local_alignment(q, d, opts);
+
+  paw::AlignmentResults<uint8_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.score == 22); // ACGTACGTACG
+  REQUIRE(ar.query_begin == 8);
+  REQUIRE(ar.query_end == 19);
+  REQUIRE(ar.database_begin == 10);
+  REQUIRE(ar.database_end == 21);
+  REQUIRE(!ar.is_overflow);
+  REQUIRE(ar.aligned_strings_ptr);
+  REQUIRE(ar.aligned_strings_ptr->first == "ACGTACGTACG");
+  REQUIRE(ar.aligned_strings_ptr->second == "ACGTACGTACG");
+}
+
+
+TEST_CASE("Local alignment with gaps")
+{
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.set_match(2).set_mismatch(4).set_gap_open(5).set_gap_extend(1);
+  opts.get_aligned_strings = true;
+
+  std::string const q = "CCCCCAGCTTAGCTAGCATTCGATCGATGGGGG";
+  std::string const d = "AGCTTAGCTAGCATTTTTCGATCGAT";
+  paw::local_alignment(q, d, opts);
+
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.score == 2 * 23 - 5 - 2); // 23 matches and a gap of length three
+  REQUIRE(ar.query_begin == 5);
+  REQUIRE(ar.query_end == 28);
+  REQUIRE(ar.database_begin == 0);
+  REQUIRE(ar.database_end == 26);
+  REQUIRE(ar.aligned_strings_ptr);
+
+  std::pair<std::string, std::string> const & s = *ar.aligned_strings_ptr;
+  REQUIRE(s.first.size() == s.second.size());
+  REQUIRE(s.first.size() == 26);
+}
+
+
+TEST_CASE("Local alignment of sequences without any matches")
+{
+  paw::AlignmentOptions<uint8_t> opts;
+  paw::local_alignment(std::string("AAAAA"), std::string("CCCCCCC"), opts);
+
+  paw::AlignmentResults<uint8_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.score == 0);
+  REQUIRE(ar.query_begin == ar.query_end);
+  REQUIRE(ar.database_begin == ar.database_end);
+}
+
+
+TEST_CASE("Local alignment scores which do not fit in 8 bits")
+{
+  paw::AlignmentOptions<uint8_t> opts;
+  opts.set_match(2).set_mismatch(2).set_gap_open(5).set_gap_extend(1);
+
+  std::string q(1000, 'A');
+  std::string d = std::string(50, 'C') + q + std::string(50, 'C');
+  q[500] = 'C';
+  paw::local_alignment(q, d, opts);
+
+  paw::AlignmentResults<uint8_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(!ar.is_overflow);
+  REQUIRE(ar.score == 2 * 999 - 2);
+  REQUIRE(ar.query_begin == 0);
+  REQUIRE(ar.query_end == 1000);
+  REQUIRE(ar.database_begin == 50);
+  REQUIRE(ar.database_end == 1050);
+}
@@ -0,0 +1,160 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint8_t, uint16_t
+#include <random> // std::mt19937
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+#include <paw/align/alignment_archs.hpp>
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/global_alignment.hpp>
+#include <paw/align/reference_alignment.hpp>
+
+
+namespace
+{
+
+struct Scores
+{
+  long match;
+  long mismatch;
+  long gap_open;
+  long gap_extend;
+  long gap_open_2;
+  long gap_extend_2;
+};
+
+
+std::vector<Scores> const SCORES = {
+  {2, 2, 5, 1, 0, 0}, // The default scores
+  {1, 4, 6, 1, 0, 0},
+  {3, 1, 4, 2, 0, 0}, // Mismatches cost less than extending gaps
+  {1, 1, 1, 1, 0, 0}, // Linear gaps
+  {5, 4, 12, 3, 0, 0}, // High scores which need to be reduced often with 8-bit scores
+  {2, 4, 4, 2, 24, 1} // Two gap costs
+};
+
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGT"[rng() % 4]);
+
+  return seq;
+}
+
+
+/// \short Generates a database and a query with edits in about 1 - identity of its bases. Some queries are only a part
+/// of the database and some have a base which is N.
+std::pair<std::string, std::string>
+random_pair(std::mt19937 & rng, long const size, double const identity)
+{
+  std::uniform_real_distribution<double> real_dist(0.0, 1.0);
+  std::string const d = random_dna(rng, size);
+  long const begin = rng() % 3 == 0 ? rng() % (1 + size / 4) : 0;
+  long const end = rng() % 3 == 0 ? size - rng() % (1 + size / 4) : size;
+  std::string q;
+
+  for (long i = begin; i < end; ++i)
+  {
+    if (real_dist(rng) >= 1.0 - identity)
+    {
+      q.push_back(d[i]);
+      continue;
+    }
+
+    switch (rng() % 4)
+    {
+    case 0: q.push_back("ACGT"[rng() % 4]); break;
+    case 1: q.push_back('N'); break;
+    case 2: q += random_dna(rng, 1 + rng() % 4); break;
+    default: break; // deletion
+    }
+  }
+
+  if (q.empty())
+    q = "A";
+
+  return {q, d};
+}
+
+
+template <typename Tuint>
+void
+check_reference_scores(void (* paw::AlignmentArch::* function)(std::string const &,
+                                                                std::string const &,
+                                                                paw::AlignmentOptions<Tuint> &),
+                       long const max_size)
+{
+  std::mt19937 rng(49);
+
+  for (long k = 0; k < 120; ++k)
+  {
+    Scores const & s = SCORES[k % SCORES.size()];
+    double const identity = k % 3 == 0 ? 0.95 : (k % 3 == 1 ? 0.8 : 0.6);
+    auto const p = random_pair(rng, 1 + rng() % max_size, identity);
+
+    paw::AlignmentOptions<Tuint> opts;
+    opts.set_match(s.match).set_mismatch(s.mismatch).set_gap_open(s.gap_open).set_gap_extend(s.gap_extend);
+    opts.set_gap_open_2(s.gap_open_2).set_gap_extend_2(s.gap_extend_2);
+    opts.left_column_free = k % 5 == 1 || k % 5 == 4;
+    opts.right_column_free = k % 5 == 2 || k % 5 == 4;
+    opts.top_row_free = k % 7 == 3;
+    opts.bottom_row_free = k % 7 == 5;
+    opts.get_aligned_strings = true;
+    long const expected = paw::get_reference_global_score(p.first, p.second, opts);
+
+    for (paw::AlignmentArch const & arch : paw::get_alignment_archs())
+    {
+      if (!arch.is_runnable)
+        continue;
+
+      INFO("arch " << arch.name << ", scores " << s.match << " " << s.mismatch << " " << s.gap_open << " "
+                   << s.gap_extend << " " << s.gap_open_2 << " " << s.gap_extend_2
+                   << ", free ends " << opts.left_column_free << opts.right_column_free << opts.top_row_free
+                   << opts.bottom_row_free << ", query " << p.first << ", database " << p.second);
+      (arch.*function)(p.first, p.second, opts);
+      paw::AlignmentResults<Tuint> const & ar = *opts.get_alignment_results();
+      REQUIRE(ar.score == expected);
+      REQUIRE(paw::get_aligned_strings_score(*ar.aligned_strings_ptr, opts) == expected);
+    }
+  }
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("The reference alignment has the scores of hand made alignments")
+{
+  paw::AlignmentOptions<uint16_t> opts; // match 2, mismatch 2, gap open 5, gap extend 1
+  REQUIRE(paw::get_reference_global_score<uint16_t>("ACGT", "ACGT", opts) == 8);
+  REQUIRE(paw::get_reference_global_score<uint16_t>("ACGT", "AGGT", opts) == 4);
+  REQUIRE(paw::get_reference_global_score<uint16_t>("ACGT", "ANGT", opts) == 8);
+  REQUIRE(paw::get_reference_global_score<uint16_t>("ACGTACGT", "ACGACGT", opts) == 14 - 5);
+  REQUIRE(paw::get_reference_global_score<uint16_t>("AC", "ACGTA", opts) == 4 - 7);
+  REQUIRE(paw::get_aligned_strings_score<uint16_t>({"AC---", "ACGTA"}, opts) == 4 - 7);
+
+  opts.right_column_free = true;
+  REQUIRE(paw::get_reference_global_score<uint16_t>("AC", "ACGTA", opts) == 4);
+  REQUIRE(paw::get_aligned_strings_score<uint16_t>({"AC---", "ACGTA"}, opts) == 4);
+}
+
+
+TEST_CASE("Every runnable architecture has the score of the reference alignment")
+{
+  SECTION("8-bit scores")
+  {
+    check_reference_scores(&paw::AlignmentArch::global_alignment_uint8, 200);
+  }
+
+  SECTION("16-bit scores")
+  {
+    check_reference_scores(&paw::AlignmentArch::global_alignment_uint16, 400);
+  }
+}
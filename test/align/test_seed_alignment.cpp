@@ -0,0 +1,156 @@
+#include "../include/catch.hpp"
+
+#include <algorithm> // std::min_element
+#include <cstdint> // uint8_t, uint16_t
+#include <random> // std::mt19937
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/global_alignment.hpp>
+#include <paw/align/seed_alignment.hpp>
+
+
+namespace
+{
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGT"[rng() % 4]);
+
+  return seq;
+}
+
+
+/// \short Checks that the seed alignment has a CIGAR of the whole sequences and the score of the full alignment
+template <typename Tuint>
+void
+check_seed_alignment(std::string const & q,
+                     std::string const & d,
+                     paw::MinimizerIndex const & index,
+                     paw::AlignmentOptions<Tuint> & opts)
+{
+  paw::global_alignment(q, d, opts);
+  paw::AlignmentResults<Tuint> const & ar = *opts.get_alignment_results();
+  long const expected_score = ar.score;
+  long const expected_database_begin = ar.database_begin;
+  long const expected_database_end = ar.database_end;
+
+  paw::seed_alignment(q, d, index, opts);
+  REQUIRE(ar.score == expected_score);
+  REQUIRE(ar.database_begin == expected_database_begin);
+  REQUIRE(ar.database_end == expected_database_end);
+  REQUIRE(ar.aligned_strings_ptr->first.size() == ar.aligned_strings_ptr->second.size());
+
+  std::string aligned_query = ar.aligned_strings_ptr->first;
+  std::string aligned_database = ar.aligned_strings_ptr->second;
+  aligned_query.erase(std::remove(aligned_query.begin(), aligned_query.end(), '-'), aligned_query.end());
+  aligned_database.erase(std::remove(aligned_database.begin(), aligned_database.end(), '-'), aligned_database.end());
+  REQUIRE(aligned_query == q);
+  REQUIRE(aligned_database == d);
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Minimizers have the lowest hash of each window")
+{
+  std::mt19937 rng(42);
+  std::string const seq = random_dna(rng, 1000);
+  long const k = 11;
+  long const w = 7;
+  std::vector<paw::Minimizer> const minimizers = paw::get_minimizers(seq, k, w);
+  std::vector<paw::Minimizer> const kmers = paw::get_minimizers(seq, k, 1);
+  REQUIRE(kmers.size() == seq.size() - k + 1);
+
+  for (long i = 0; i + w <= static_cast<long>(kmers.size()); ++i)
+  {
+    auto const min_it = std::min_element(kmers.begin() + i, kmers.begin() + i + w,
+                                         [](paw::Minimizer const & a, paw::Minimizer const & b)
+      {
+        return a.hash < b.hash;
+      });
+
+    bool const is_found = std::find_if(minimizers.begin(), minimizers.end(), [&](paw::Minimizer const & mm)
+      {
+        return mm.pos == min_it->pos;
+      }) != minimizers.end();
+
+    REQUIRE(is_found);
+  }
+
+  // K-mers with other bases are skipped
+  std::vector<paw::Minimizer> const n_kmers = paw::get_minimizers("ACGTNACGTA", 4, 1);
+  REQUIRE(n_kmers.size() == 3);
+  REQUIRE(n_kmers[0].pos == 0);
+  REQUIRE(n_kmers[1].pos == 5);
+  REQUIRE(n_kmers[2].pos == 6);
+  REQUIRE(n_kmers[0].hash == n_kmers[1].hash);
+}
+
+
+TEST_CASE("Chained anchors increase in both sequences")
+{
+  std::vector<paw::Anchor> anchors = {{100, 1100}, {0, 1000}, {50, 5000}, {200, 1200}, {150, 1149}};
+  std::vector<paw::Anchor> const chain = paw::chain_anchors(anchors, 15, 5000);
+  REQUIRE(chain.size() == 4);
+  REQUIRE(chain[0].query_pos == 0);
+  REQUIRE(chain[1].query_pos == 100);
+  REQUIRE(chain[2].query_pos == 150);
+  REQUIRE(chain[3].query_pos == 200);
+}
+
+
+TEST_CASE("Seed alignment of contigs to a reference has the score of the full alignment")
+{
+  std::mt19937 rng(43);
+  std::string const ref = random_dna(rng, 20000);
+  paw::MinimizerIndex const index(ref);
+
+  for (long k = 0; k < 10; ++k)
+  {
+    long const begin = rng() % 15000;
+    std::string q = ref.substr(begin, 500 + rng() % 3000);
+
+    for (long e = 0; e < 8; ++e)
+    {
+      long const pos = rng() % q.size();
+
+      if (rng() % 2 == 0)
+        q[pos] = "ACGT"[rng() % 4];
+      else if (rng() % 2 == 0)
+        q.erase(pos, 1 + rng() % 10);
+      else
+        q.insert(pos, random_dna(rng, 1 + rng() % 10));
+    }
+
+    INFO("contig " << k << " starts at " << begin);
+
+    paw::AlignmentOptions<uint16_t> opts;
+    opts.left_column_free = true;
+    opts.right_column_free = true;
+    opts.get_aligned_strings = true;
+    check_seed_alignment(q, ref, index, opts);
+
+    // Without free ends the parts before the first and after the last anchor are aligned to the ends of the reference
+    std::string const sub_ref = ref.substr(begin, q.size());
+    paw::MinimizerIndex const sub_index(sub_ref);
+    paw::AlignmentOptions<uint16_t> global_opts;
+    global_opts.get_aligned_strings = true;
+    check_seed_alignment(q, sub_ref, sub_index, global_opts);
+  }
+
+  // A query without anchors is aligned to the whole reference
+  paw::AlignmentOptions<uint8_t> opts;
+  opts.left_column_free = true;
+  opts.right_column_free = true;
+  opts.get_aligned_strings = true;
+  check_seed_alignment(std::string("ACGTNACGTNACGT"), ref, index, opts);
+}
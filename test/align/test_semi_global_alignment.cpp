@@ -0,0 +1,110 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint8_t, uint16_t
+#include <string> // std::string
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/global_alignment.hpp>
+
+
+namespace
+{
+
+template <typename Tuint>
+paw::AlignmentResults<Tuint> const &
+align(std::string const & q, std::string const & d, paw::AlignmentOptions<Tuint> & opts)
+{
+  paw::global_alignment(q, d, opts);
+  return *opts.get_alignment_results();
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Query contained in the database")
+{
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.set_match(2).set_mismatch(2).set_gap_open(5).set_gap_extend(1);
+  opts.left_column_free = true;
+  opts.right_column_free = true;
+
+  std::string const q = "ACGTTGCA";
+  std::string const d = "GGGGGGACGTTGCAGGGGGGGGG";
+
+  for (long band_width : {-1l, 20l})
+  {
+    for (bool get_aligned_strings : {false, true})
+    {
+      opts.band_width = band_width;
+      opts.get_aligned_strings = get_aligned_strings;
+      auto const & ar = align(q, d, opts);
+      REQUIRE(ar.score == 16);
+      REQUIRE(ar.query_begin == 0);
+      REQUIRE(ar.query_end == 8);
+      REQUIRE(ar.database_begin == 6);
+      REQUIRE(ar.database_end == 14);
+    }
+  }
+}
+
+
+TEST_CASE("Database contained in the query")
+{
+  paw::AlignmentOptions<uint8_t> opts;
+  opts.set_match(2).set_mismatch(2).set_gap_open(5).set_gap_extend(1);
+  opts.top_row_free = true;
+  opts.bottom_row_free = true;
+
+  std::string const q = "TTTTTTTTTACGTTGCATTTTT";
+  std::string const d = "ACGTTGCA";
+
+  for (long band_width : {-1l, 20l})
+  {
+    for (bool get_aligned_strings : {false, true})
+    {
+      opts.band_width = band_width;
+      opts.get_aligned_strings = get_aligned_strings;
+      auto const & ar = align(q, d, opts);
+      REQUIRE(ar.score == 16);
+      REQUIRE(ar.query_begin == 9);
+      REQUIRE(ar.query_end == 17);
+      REQUIRE(ar.database_begin == 0);
+      REQUIRE(ar.database_end == 8);
+
+      if (get_aligned_strings)
+      {
+        REQUIRE(ar.aligned_strings_ptr->first == q);
+        REQUIRE(ar.aligned_strings_ptr->second == "---------ACGTTGCA-----");
+      }
+    }
+  }
+}
+
+
+TEST_CASE("Overlap of the end of the database and the begin of the query")
+{
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.set_match(2).set_mismatch(2).set_gap_open(5).set_gap_extend(1);
+  opts.left_column_free = true;
+  opts.bottom_row_free = true;
+
+  std::string const q = "ACGTACCCAGATTTTTTT";
+  std::string const d = "GGGGGGGGGGGGACGTACCCAGA";
+
+  for (long band_width : {-1l, 30l})
+  {
+    for (bool get_aligned_strings : {false, true})
+    {
+      opts.band_width = band_width;
+      opts.get_aligned_strings = get_aligned_strings;
+      auto const & ar = align(q, d, opts);
+      REQUIRE(ar.score == 22);
+      REQUIRE(ar.query_begin == 0);
+      REQUIRE(ar.query_end == 11);
+      REQUIRE(ar.database_begin == 12);
+      REQUIRE(ar.database_end == 23);
+    }
+  }
+}
@@ -0,0 +1,209 @@
+#include "../include/catch.hpp"
+
+#include <algorithm> // std::max
+#include <cstdint> // uint8_t, uint16_t
+#include <limits> // std::numeric_limits
+#include <random> // std::mt19937
+#include <sstream> // std::istringstream
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/global_alignment.hpp>
+#include <paw/align/local_alignment.hpp>
+#include <paw/align/substitution_matrix.hpp>
+
+
+namespace
+{
+
+std::string
+random_protein(std::mt19937 & rng, long const size)
+{
+  std::string const amino_acids = "ARNDCQEGHILKMFPSTWYV";
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back(amino_acids[rng() % amino_acids.size()]);
+
+  return seq;
+}
+
+
+/// \short Score of the best global alignment, computed one cell at a time. A gap of length k costs
+/// gap_open + (k - 1) * gap_extend.
+long
+get_global_score(std::string const & q,
+                 std::string const & d,
+                 paw::SubstitutionMatrix const & matrix,
+                 long const gap_open,
+                 long const gap_extend)
+{
+  long const NEG_INF = std::numeric_limits<long>::min() / 2;
+  long const m = q.size();
+  std::vector<long> H(m + 1);
+  std::vector<long> F(m + 1, NEG_INF);
+
+  for (long j = 1; j <= m; ++j)
+    H[j] = -gap_open - (j - 1) * gap_extend;
+
+  for (long i = 1; i <= static_cast<long>(d.size()); ++i)
+  {
+    long h_diagonal = H[0];
+    H[0] = -gap_open - (i - 1) * gap_extend;
+    long E = NEG_INF;
+
+    for (long j = 1; j <= m; ++j)
+    {
+      E = std::max(E - gap_extend, H[j - 1] - gap_open);
+      F[j] = std::max(F[j] - gap_extend, H[j] - gap_open);
+      long const h = std::max(h_diagonal + matrix.get_score(q[j - 1], d[i - 1]), std::max(E, F[j]));
+      h_diagonal = H[j];
+      H[j] = h;
+    }
+  }
+
+  return H[m];
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Substitution matrices are read in the NCBI format")
+{
+  std::istringstream ss("# A small matrix with its rows out of order\n"
+                        "   A  B  *\n"
+                        "B -1  3 -2\n"
+                        "A  2 -1 -2\n"
+                        "* -2 -2  1\n");
+
+  paw::SubstitutionMatrix matrix;
+  matrix.read(ss);
+  REQUIRE(matrix.get_alphabet() == "AB*");
+  REQUIRE(matrix.get_score('A', 'A') == 2);
+  REQUIRE(matrix.get_score('B', 'B') == 3);
+  REQUIRE(matrix.get_score('A', 'B') == -1);
+  REQUIRE(matrix.get_score('b', 'b') == 3); // Lowercase characters are scored as uppercase ones
+  REQUIRE(matrix.get_score('A', 'Z') == -2); // Other characters are scored as the last symbol
+  REQUIRE(matrix.get_max_score() == 3);
+  REQUIRE(matrix.get_min_score() == -2);
+}
+
+
+TEST_CASE("The BLOSUM62 and IUPAC DNA matrices are symmetric")
+{
+  paw::SubstitutionMatrix const blosum62 = paw::get_blosum62_matrix();
+  REQUIRE(blosum62.get_alphabet_size() == 24);
+  REQUIRE(blosum62.get_score('W', 'W') == 11);
+  REQUIRE(blosum62.get_score('A', 'R') == -1);
+  REQUIRE(blosum62.get_min_score() == -4);
+
+  paw::SubstitutionMatrix const iupac = paw::get_iupac_dna_matrix(2, 3);
+  REQUIRE(iupac.get_score('A', 'R') == 2);
+  REQUIRE(iupac.get_score('C', 'R') == -3);
+  REQUIRE(iupac.get_score('S', 'R') == 2);
+  REQUIRE(iupac.get_score('N', 'T') == 2);
+
+  for (paw::SubstitutionMatrix const * matrix : {&blosum62, &iupac})
+  {
+    for (char const a : matrix->get_alphabet())
+    {
+      for (char const b : matrix->get_alphabet())
+        REQUIRE(matrix->get_score(a, b) == matrix->get_score(b, a));
+    }
+  }
+}
+
+
+TEST_CASE("Protein alignments with BLOSUM62 have the best score")
+{
+  paw::SubstitutionMatrix const blosum62 = paw::get_blosum62_matrix();
+  std::mt19937 rng(11);
+
+  for (long k = 0; k < 30; ++k)
+  {
+    std::string const q = random_protein(rng, 1 + rng() % 150);
+    std::string d = q.substr(rng() % 10);
+    d.insert(d.size() / 2, random_protein(rng, rng() % 5));
+
+    if (k % 2 == 1)
+      d = random_protein(rng, 1 + rng() % 150);
+
+    long const expected = get_global_score(q, d, blosum62, 11, 1);
+    INFO("query " << q << ", database " << d);
+
+    paw::AlignmentOptions<uint16_t> opts;
+    opts.set_gap_open(11).set_gap_extend(1).set_substitution_matrix(blosum62);
+    opts.get_aligned_strings = true;
+    paw::global_alignment(q, d, opts);
+    paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+    REQUIRE(ar.score == expected);
+
+    // The aligned strings have the same score
+    long score = 0;
+    std::string const & s1 = ar.aligned_strings_ptr->first;
+    std::string const & s2 = ar.aligned_strings_ptr->second;
+
+    for (long j = 0; j < static_cast<long>(s1.size()); ++j)
+    {
+      if (s1[j] == '-' || s2[j] == '-')
+      {
+        bool const is_open = j == 0 || (s1[j] == '-' ? s1[j - 1] != '-' : s2[j - 1] != '-');
+        score -= is_open ? 11 : 1;
+      }
+      else
+      {
+        score += blosum62.get_score(s1[j], s2[j]);
+      }
+    }
+
+    REQUIRE(score == expected);
+
+    paw::AlignmentOptions<uint8_t> opts8;
+    opts8.set_gap_open(11).set_gap_extend(1).set_substitution_matrix(blosum62);
+    paw::global_alignment(q, d, opts8);
+    REQUIRE(opts8.get_alignment_results()->score == expected);
+
+    opts.band_width = q.size() + d.size();
+    paw::global_alignment(q, d, opts);
+    REQUIRE(ar.score == expected);
+  }
+}
+
+
+TEST_CASE("Local alignment with BLOSUM62")
+{
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.set_gap_open(11).set_gap_extend(1).set_substitution_matrix(paw::get_blosum62_matrix());
+  opts.get_aligned_strings = true;
+  paw::local_alignment(std::string("PPPPPHEAGAWGHEEPPPPP"), std::string("GGGGGHEAGAWGHEEGGGGG"), opts);
+
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.score == 8 + 5 + 4 + 6 + 4 + 11 + 6 + 8 + 5 + 5); // HEAGAWGHEE
+  REQUIRE(ar.query_begin == 5);
+  REQUIRE(ar.query_end == 15);
+  REQUIRE(ar.aligned_strings_ptr->first == "HEAGAWGHEE");
+}
+
+
+TEST_CASE("The IUPAC DNA matrix matches ambiguous bases")
+{
+  std::string const q = "ACGTACGTRYACGTACGT";
+  std::string const d = "ACGTACGTGTACGTACGT";
+
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.set_gap_open(5).set_gap_extend(1);
+  paw::global_alignment(q, d, opts);
+  REQUIRE(opts.get_alignment_results()->score < 2 * 18);
+
+  opts.set_substitution_matrix(paw::get_iupac_dna_matrix(2, 2));
+  paw::global_alignment(q, d, opts);
+  REQUIRE(opts.get_alignment_results()->score == 2 * 18);
+
+  // An empty matrix gives back the match and mismatch values
+  opts.set_substitution_matrix(paw::SubstitutionMatrix());
+  paw::global_alignment(q, d, opts);
+  REQUIRE(opts.get_alignment_results()->score < 2 * 18);
+}
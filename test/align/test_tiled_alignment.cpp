@@ -0,0 +1,137 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint8_t, uint16_t
+#include <random> // std::mt19937
+#include <string> // std::string
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/global_alignment.hpp>
+
+
+namespace
+{
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGT"[rng() % 4]);
+
+  return seq;
+}
+
+
+/// \short Checks that an alignment computed in tiles is the same as one computed on a single thread
+template <typename Tuint>
+void
+check_tiled_alignment(std::string const & q,
+                      std::string const & d,
+                      paw::AlignmentOptions<Tuint> & opts,
+                      long const num_threads,
+                      long const tile_size)
+{
+  opts.get_cigar = true;
+  opts.num_threads = 1;
+  paw::global_alignment(q, d, opts);
+
+  paw::AlignmentResults<Tuint> const & ar = *opts.get_alignment_results();
+  long const score = ar.score;
+  long const query_begin = ar.query_begin;
+  long const query_end = ar.query_end;
+  long const database_begin = ar.database_begin;
+  long const database_end = ar.database_end;
+  std::string const cigar = paw::get_cigar_string(ar.cigar);
+
+  opts.num_threads = num_threads;
+  opts.tile_size = tile_size;
+  paw::global_alignment(q, d, opts);
+  REQUIRE(ar.score == score);
+  REQUIRE(ar.query_begin == query_begin);
+  REQUIRE(ar.query_end == query_end);
+  REQUIRE(ar.database_begin == database_begin);
+  REQUIRE(ar.database_end == database_end);
+  REQUIRE(paw::get_cigar_string(ar.cigar) == cigar);
+
+  // Without a traceback only the score and the ends are computed
+  opts.get_cigar = false;
+  paw::global_alignment(q, d, opts);
+  REQUIRE(ar.score == score);
+  REQUIRE(ar.query_end == query_end);
+  REQUIRE(ar.database_end == database_end);
+  opts.num_threads = 1;
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Tiled alignments are the same as alignments on a single thread")
+{
+  std::mt19937 rng(39);
+
+  for (long k = 0; k < 60; ++k)
+  {
+    std::string const q = random_dna(rng, 1 + rng() % 150);
+    std::string d = q;
+
+    for (long e = 0; e < 4 && !d.empty(); ++e)
+    {
+      long const pos = rng() % d.size();
+
+      if (rng() % 2 == 0)
+        d[pos] = "ACGT"[rng() % 4];
+      else if (rng() % 2 == 0)
+        d.erase(pos, 1 + rng() % 20);
+      else
+        d.insert(pos, random_dna(rng, 1 + rng() % 20));
+    }
+
+    if (d.empty())
+      d = "A";
+
+    long const num_threads = 2 + rng() % 3;
+    long const tile_size = k % 3 == 0 ? 0 : 1 + rng() % 40; // Zero splits the query into a tile per thread
+    INFO("query " << q << ", database " << d << ", threads " << num_threads << ", tile size " << tile_size);
+
+    paw::AlignmentOptions<uint16_t> opts;
+    check_tiled_alignment(q, d, opts, num_threads, tile_size);
+
+    paw::AlignmentOptions<uint8_t> opts8;
+    opts8.set_match(2).set_mismatch(4).set_gap_open(6).set_gap_extend(2);
+    check_tiled_alignment(q, d, opts8, num_threads, tile_size);
+
+    opts.set_gap_open(5).set_gap_extend(2).set_gap_open_2(12).set_gap_extend_2(1);
+    check_tiled_alignment(q, d, opts, num_threads, tile_size);
+
+    paw::AlignmentOptions<uint16_t> free_opts;
+    free_opts.top_row_free = k % 2 == 0;
+    free_opts.bottom_row_free = k % 2 == 0;
+    free_opts.left_column_free = k % 2 == 1;
+    free_opts.right_column_free = k % 2 == 1;
+    check_tiled_alignment(q, d, free_opts, num_threads, tile_size);
+  }
+}
+
+
+TEST_CASE("Tiled alignment of long sequences")
+{
+  std::mt19937 rng(3939);
+  std::string const q = random_dna(rng, 3000);
+  std::string d = q;
+
+  for (long e = 0; e < 30; ++e)
+  {
+    long const pos = rng() % d.size();
+    d[pos] = "ACGT"[rng() % 4];
+  }
+
+  d.erase(1000, 100);
+  d.insert(2000, random_dna(rng, 50));
+
+  paw::AlignmentOptions<uint16_t> opts;
+  check_tiled_alignment(q, d, opts, 4, 0);
+}
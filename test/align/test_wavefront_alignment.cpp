@@ -0,0 +1,174 @@
+#include "../include/catch.hpp"
+
+#include <cstdint> // uint8_t, uint16_t
+#include <random> // std::mt19937
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <paw/align/alignment_options.hpp>
+#include <paw/align/alignment_results.hpp>
+#include <paw/align/cigar.hpp>
+#include <paw/align/global_alignment.hpp>
+#include <paw/align/wavefront_alignment.hpp>
+
+
+namespace
+{
+
+std::string
+random_dna(std::mt19937 & rng, long const size)
+{
+  std::string seq;
+
+  for (long k = 0; k < size; ++k)
+    seq.push_back("ACGTN"[rng() % 30 == 0 ? 4 : rng() % 4]);
+
+  return seq;
+}
+
+
+/// \short Returns the score of the alignment in a CIGAR
+template <typename Tuint>
+long
+get_cigar_score(std::vector<paw::Cigar> const & cigar, paw::AlignmentOptions<Tuint> const & opts)
+{
+  long score = 0;
+
+  for (paw::Cigar const & c : cigar)
+  {
+    long const count = c.count;
+
+    if (c.operation == paw::SEQUENCE_MATCH)
+      score += count * opts.get_match();
+    else if (c.operation == paw::MISMATCH)
+      score -= count * opts.get_mismatch();
+    else
+      score -= opts.get_gap_open() + (count - 1) * opts.get_gap_extend();
+  }
+
+  return score;
+}
+
+
+/// \short Checks that the wavefront alignment has the score of the global alignment and a CIGAR with that score
+template <typename Tuint>
+void
+check_wavefront_alignment(std::string const & q, std::string const & d, paw::AlignmentOptions<Tuint> & opts)
+{
+  paw::global_alignment(q, d, opts);
+  paw::AlignmentResults<Tuint> const & ar = *opts.get_alignment_results();
+  long const expected_score = ar.score;
+
+  opts.get_aligned_strings = true;
+  REQUIRE(paw::wavefront_alignment(q, d, opts));
+  opts.get_aligned_strings = false;
+
+  REQUIRE(ar.score == expected_score);
+  REQUIRE(ar.query_begin == 0);
+  REQUIRE(ar.query_end == static_cast<long>(q.size()));
+  REQUIRE(ar.database_begin == 0);
+  REQUIRE(ar.database_end == static_cast<long>(d.size()));
+  REQUIRE(get_cigar_score(ar.cigar, opts) == expected_score);
+  REQUIRE(paw::get_aligned_strings(ar.cigar, q, d) == *ar.aligned_strings_ptr);
+}
+
+
+} // anon namespace
+
+
+TEST_CASE("Wavefront alignment of small sequences")
+{
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.get_cigar = true;
+
+  REQUIRE(paw::wavefront_alignment(std::string("ACGTACGT"), std::string("ACGTACGT"), opts));
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  REQUIRE(ar.score == 16);
+  REQUIRE(paw::get_cigar_string(ar.cigar) == "8=");
+
+  REQUIRE(paw::wavefront_alignment(std::string("ACGTACGT"), std::string("ACGAACGT"), opts));
+  REQUIRE(ar.score == 14 - 2);
+  REQUIRE(paw::get_cigar_string(ar.cigar) == "3=1X4=");
+
+  REQUIRE(paw::wavefront_alignment(std::string("ACGTTTTACGT"), std::string("ACGTACGT"), opts));
+  REQUIRE(ar.score == 16 - 5 - 2);
+
+  REQUIRE(paw::wavefront_alignment(std::string(""), std::string("ACG"), opts));
+  REQUIRE(ar.score == -5 - 2);
+  REQUIRE(paw::get_cigar_string(ar.cigar) == "3I");
+
+  // Too many edits or unsupported options
+  REQUIRE(!paw::wavefront_alignment(std::string("ACGTACGT"), std::string("ACGAACGA"), opts, 1));
+  REQUIRE(!paw::wavefront_alignment(std::string("ACGTTTTACGT"), std::string("ACGTACGT"), opts, 2));
+  opts.left_column_free = true;
+  REQUIRE(!paw::wavefront_alignment(std::string("ACGTACGT"), std::string("ACGTACGT"), opts));
+}
+
+
+TEST_CASE("Wavefront alignment has the score of the global alignment")
+{
+  std::mt19937 rng(41);
+
+  for (long k = 0; k < 200; ++k)
+  {
+    std::string const q = random_dna(rng, rng() % 200);
+    std::string d = q;
+
+    for (long e = rng() % 12; e > 0; --e)
+    {
+      long const pos = d.empty() ? 0 : rng() % d.size();
+
+      if (rng() % 3 == 0 && !d.empty())
+        d[pos] = "ACGT"[rng() % 4];
+      else if (rng() % 2 == 0 && !d.empty())
+        d.erase(pos, 1 + rng() % 8);
+      else
+        d.insert(pos, random_dna(rng, 1 + rng() % 8));
+    }
+
+    INFO("query " << q << ", database " << d);
+
+    paw::AlignmentOptions<uint16_t> opts;
+    check_wavefront_alignment(q, d, opts);
+
+    opts.set_match(1).set_mismatch(4).set_gap_open(6).set_gap_extend(1);
+    check_wavefront_alignment(q, d, opts);
+
+    opts.set_match(0).set_mismatch(1).set_gap_open(1).set_gap_extend(1);
+    check_wavefront_alignment(q, d, opts);
+
+    paw::AlignmentOptions<uint8_t> opts8;
+    opts8.set_match(2).set_mismatch(3).set_gap_open(4).set_gap_extend(2);
+    check_wavefront_alignment(q, d, opts8);
+  }
+}
+
+
+TEST_CASE("Global alignments of similar sequences are computed with the wavefront alignment")
+{
+  std::mt19937 rng(42);
+  std::string const q = random_dna(rng, 5000);
+  std::string d = q;
+  d[1000] = d[1000] == 'A' ? 'C' : 'A';
+  d.erase(3000, 5);
+  d.insert(4000, "ACGTACGT");
+
+  paw::AlignmentOptions<uint16_t> opts;
+  opts.get_cigar = true;
+  paw::global_alignment(q, d, opts);
+  paw::AlignmentResults<uint16_t> const & ar = *opts.get_alignment_results();
+  long const expected_score = ar.score;
+
+  opts.wfa_max_divergence = 0.01;
+  paw::global_alignment(q, d, opts);
+  REQUIRE(ar.score == expected_score);
+  REQUIRE(get_cigar_score(ar.cigar, opts) == expected_score);
+
+  // Divergent sequences fall back to the score matrix
+  std::string const other = random_dna(rng, 5000);
+  paw::global_alignment(q, other, opts);
+  long const divergent_score = ar.score;
+  opts.wfa_max_divergence = 0.0;
+  paw::global_alignment(q, other, opts);
+  REQUIRE(ar.score == divergent_score);
+}